@@ -3,9 +3,26 @@
 #include <sys/types.h>
 #include <sys/wait.h>
 #include "rl/rlstr.h"
+#include "rl/rlstat.h"
 
 #define __FILENAME__ "rlcmd"
 
+// 统计指标（第一次执行命令时登记，导出到 rlstat 共享内存）
+static rl_stat_t *rl_cmd_stat_forks = NULL;
+static rl_stat_t *rl_cmd_stat_timeouts = NULL;
+static rl_stat_t *rl_cmd_stat_run_ms = NULL;
+static pthread_once_t rl_cmd_stat_once = PTHREAD_ONCE_INIT;
+
+static void rl_cmd_stat_register()
+{
+    // 创建的子进程数量（包括重试）
+    rl_cmd_stat_forks = rl_stat_register("rlcmd.forks", RL_STAT_COUNTER);
+    // 超时被杀死的子进程数量
+    rl_cmd_stat_timeouts = rl_stat_register("rlcmd.timeouts", RL_STAT_COUNTER);
+    // 每次调用的总耗时（毫秒，包括重试）
+    rl_cmd_stat_run_ms = rl_stat_register("rlcmd.run_ms", RL_STAT_HISTOGRAM);
+}
+
 int rl_system_100ms_ex(const char *cmdStr, int timeout_count, int try_count)
 {
     if (rl_str_isempty(cmdStr) == RL_TRUE)
@@ -13,6 +30,8 @@ int rl_system_100ms_ex(const char *cmdStr, int timeout_count, int try_count)
         rl_log_error("[%s:%s:%d] cmdStr invalid", __FILENAME__, __FUNCTION__, __LINE__);
         return RL_FAILED;
     }
+    pthread_once(&rl_cmd_stat_once, rl_cmd_stat_register);
+    unsigned long long start_us = rl_stat_now_us();
 
     // 处理 SIGINT 和 SIGQUIT 信号
     // 暂时忽略这两个信号,确保父进程不会意外终止，同时子进程可以独立执行
@@ -65,6 +84,8 @@ int rl_system_100ms_ex(const char *cmdStr, int timeout_count, int try_count)
         // 表示第一次执行命令 不算重试，后续才是重试次数
         needRetry = RL_FALSE;
 
+        // 在 fork 之前计数（共享内存映射会被子进程继承）
+        rl_stat_add(rl_cmd_stat_forks, 1);
         // 创建子进程
         pid = fork();
         // 创建失败
@@ -119,6 +140,7 @@ int rl_system_100ms_ex(const char *cmdStr, int timeout_count, int try_count)
                             // 确保子进程资源被释放，避免僵尸进程
                             waitpid(pid, NULL, 0);
                         }
+                        rl_stat_add(rl_cmd_stat_timeouts, 1);
                         // 设置 status = RL_FAILED，表示失败
                         status = RL_FAILED;
                         // 允许重试
@@ -148,6 +170,7 @@ int rl_system_100ms_ex(const char *cmdStr, int timeout_count, int try_count)
         rl_log_error("[%s:%s:%d] sigaction:SIGQUIT failed", __FILENAME__, __FUNCTION__, __LINE__);
         return RL_FAILED;
     }
+    rl_stat_observe(rl_cmd_stat_run_ms, (rl_stat_now_us() - start_us) / 1000);
 
     // 如果子进程正常终止
     if (WIFEXITED(status))
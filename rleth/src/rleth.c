@@ -5,9 +5,35 @@
 #include <linux/route.h>
 #include <netdb.h>
 #include "rl/rlstr.h"
+#include "rl/rlstat.h"
 
 #define __FILENAME__ "rleth"
 
+// 外网连通性测试的统计指标（第一次测试时登记，导出到 rlstat 共享内存）
+static rl_stat_t *rl_eth_stat_tcp_us = NULL;
+static rl_stat_t *rl_eth_stat_udp_us = NULL;
+static rl_stat_t *rl_eth_stat_failures = NULL;
+static pthread_once_t rl_eth_stat_once = PTHREAD_ONCE_INIT;
+
+static void rl_eth_stat_register()
+{
+    // 每次测试的耗时（微秒，包括域名解析）
+    rl_eth_stat_tcp_us = rl_stat_register("rleth.tcp_probe_us", RL_STAT_HISTOGRAM);
+    rl_eth_stat_udp_us = rl_stat_register("rleth.udp_probe_us", RL_STAT_HISTOGRAM);
+    // 测试失败次数
+    rl_eth_stat_failures = rl_stat_register("rleth.probe_failures", RL_STAT_COUNTER);
+}
+
+// 记录一次测试的耗时和结果
+static void rl_eth_stat_probe(rl_stat_t *latency, unsigned long long start_us, int ret)
+{
+    rl_stat_observe(latency, rl_stat_now_us() - start_us);
+    if (ret != RL_SUCCESS)
+    {
+        rl_stat_add(rl_eth_stat_failures, 1);
+    }
+}
+
 bool rl_is_ipv4(const char *str)
 {
     if (rl_str_isempty(str) == RL_TRUE)
@@ -62,7 +88,7 @@ int rl_get_ethernet_card_state(unsigned int timeout_ms, int retry_count)
             }
             else
             {
-                rl_log_debug("[%s:%s:%d] get ethernet card state failed, attempt=%d", __FILENAME__, __FUNCTION__, __LINE__, retry_count);
+                RL_LOGD("[%s:%s:%d] get ethernet card state failed, attempt=%d", __FILENAME__, __FUNCTION__, __LINE__, retry_count);
             }
         }
         close(sockfd);
@@ -75,7 +101,7 @@ int rl_get_ethernet_card_state(unsigned int timeout_ms, int retry_count)
 }
 
 // 测试是否链接外网（TCP）
-int rl_get_ethernet_connect_tcp(unsigned int try_sec)
+static int rl_eth_connect_tcp(unsigned int try_sec)
 {
     int sockfd = socket(AF_INET, SOCK_STREAM, 0);
     if (sockfd < 0)
@@ -126,7 +152,17 @@ int rl_get_ethernet_connect_tcp(unsigned int try_sec)
 }
 
 // 测试是否链接外网（TCP）
-int rl_get_ethernet_connect_tcp_sel(unsigned int try_sec)
+int rl_get_ethernet_connect_tcp(unsigned int try_sec)
+{
+    pthread_once(&rl_eth_stat_once, rl_eth_stat_register);
+    unsigned long long start_us = rl_stat_now_us();
+    int ret = rl_eth_connect_tcp(try_sec);
+    rl_eth_stat_probe(rl_eth_stat_tcp_us, start_us, ret);
+    return ret;
+}
+
+// 测试是否链接外网（TCP）
+static int rl_eth_connect_tcp_sel(unsigned int try_sec)
 {
     int sockfd = socket(AF_INET, SOCK_STREAM, 0);
     if (sockfd < 0)
@@ -200,8 +236,18 @@ int rl_get_ethernet_connect_tcp_sel(unsigned int try_sec)
     return RL_FAILED;
 }
 
+// 测试是否链接外网（TCP，非阻塞连接加 select 超时）
+int rl_get_ethernet_connect_tcp_sel(unsigned int try_sec)
+{
+    pthread_once(&rl_eth_stat_once, rl_eth_stat_register);
+    unsigned long long start_us = rl_stat_now_us();
+    int ret = rl_eth_connect_tcp_sel(try_sec);
+    rl_eth_stat_probe(rl_eth_stat_tcp_us, start_us, ret);
+    return ret;
+}
+
 // 测试是否链接外网（UDP）
-int rl_get_ethernet_connect_udp(unsigned int try_sec)
+static int rl_eth_connect_udp(unsigned int try_sec)
 {
     int sockfd = socket(AF_INET, SOCK_DGRAM, 0);
     if (sockfd < 0)
@@ -271,6 +317,16 @@ int rl_get_ethernet_connect_udp(unsigned int try_sec)
     return RL_FAILED;
 }
 
+// 测试是否链接外网（UDP）
+int rl_get_ethernet_connect_udp(unsigned int try_sec)
+{
+    pthread_once(&rl_eth_stat_once, rl_eth_stat_register);
+    unsigned long long start_us = rl_stat_now_us();
+    int ret = rl_eth_connect_udp(try_sec);
+    rl_eth_stat_probe(rl_eth_stat_udp_us, start_us, ret);
+    return ret;
+}
+
 // 获取dhcp状态
 int rl_get_dhcp()
 {
@@ -10,10 +10,34 @@ extern "C"
 
 // 日志路径
 #define RL_LOG_FILE_DIR     "/tmp/Messages"
+// 二进制日志路径（使用 rllog/tools/rllog_decode 还原为文本）
+#define RL_LOG_BIN_FILE_DIR "/tmp/Messages.bin"
 // 日志文件大小 10 MB
 #define RL_LOG_FILE_SIZE    1024 * 1024 * 50
+// 默认保留的历史日志份数（/tmp/Messages.1 ~ /tmp/Messages.N）
+#define RL_LOG_ROTATE_KEEP_COUNT    3
+// 每写入多少次检查一次日志文件是否被外部删除/替换/截断
+#define RL_LOG_FILE_CHECK_COUNT     1024
 // 单条日志最大长度
 #define RL_LOG_BUF_SIZE     1024
+// 异步模式环形缓冲区默认槽位数量（必须为 2 的幂）
+#define RL_LOG_ASYNC_SLOT_COUNT     1024
+// 异步写线程单次批量写入的最大日志条数
+#define RL_LOG_ASYNC_BATCH_COUNT    64
+// 暂存模式每个线程的暂存缓冲区大小
+#define RL_LOG_STAGE_BUF_SIZE       (16 * 1024)
+// 暂存模式默认刷新间隔（毫秒）
+#define RL_LOG_STAGE_FLUSH_MS       200
+// 内存映射模式默认 msync 间隔（毫秒）
+#define RL_LOG_MMAP_SYNC_MS         1000
+// 每个调用点默认每秒允许输出的日志条数（令牌桶速率，0 为不限速，调用 rl_log_limit_config 后才开启；NORMAL 等级不受限制）
+#define RL_LOG_LIMIT_RATE           0
+// 每个调用点默认允许的突发日志条数（令牌桶容量，0 时与速率相同）
+#define RL_LOG_LIMIT_BURST          0
+// 重复日志持续出现时，每隔多久输出一次 "last message repeated N times"（毫秒）
+#define RL_LOG_REPEAT_FLUSH_MS      30000
+// 限速调用点表大小（必须为 2 的幂，表满后新的调用点不再限速）
+#define RL_LOG_LIMIT_TABLE_SIZE     512
 
 typedef enum
 {
@@ -24,9 +48,85 @@ typedef enum
     RL_LOG_LEVEL_DEBUG
 } RL_LOG_LEVEL;
 
+// 日志头时间戳精度
+typedef enum
+{
+    RL_LOG_TIME_SEC,    // HH:MM:SS
+    RL_LOG_TIME_MS,     // HH:MM:SS.mmm（CLOCK_REALTIME_COARSE，精度取决于内核时钟节拍）
+    RL_LOG_TIME_US      // HH:MM:SS.uuuuuu（CLOCK_REALTIME）
+} RL_LOG_TIME_PRECISION;
+
+// 异步模式下环形缓冲区满时的处理策略
+typedef enum
+{
+    RL_LOG_OVERFLOW_DROP,   // 丢弃日志并计数
+    RL_LOG_OVERFLOW_BLOCK   // 阻塞等待写线程腾出槽位
+} RL_LOG_OVERFLOW_POLICY;
+
+// 日志统计信息
+typedef struct
+{
+    unsigned long long written;         // 已输出的日志条数
+    unsigned long long dropped;         // 异步模式缓冲区满丢弃的条数
+    unsigned long long rate_limited;    // 被调用点限速丢弃的条数
+    unsigned long long repeated;        // 被合并为 "last message repeated N times" 的条数
+    unsigned long long rotated;         // 日志文件轮转次数
+} RL_LOG_STATS_T;
+
+// 编译期最低日志等级：比该等级更详细的 RL_LOGx 调用在编译期被整体移除（可在编译选项中 -DRL_LOG_COMPILE_LEVEL=RL_LOG_LEVEL_INFO 覆盖）
+#ifndef RL_LOG_COMPILE_LEVEL
+#define RL_LOG_COMPILE_LEVEL    RL_LOG_LEVEL_DEBUG
+#endif
+
+// 当前运行时日志等级（只读，修改请使用 rl_log_set_level）
+extern RL_LOG_LEVEL rl_log_cur_level;
+
 int rl_log_init(RL_LOG_LEVEL level);
 int rl_log_deint();
 
+// 运行时修改日志等级（无需重新初始化）
+int rl_log_set_level(RL_LOG_LEVEL level);
+
+// 获取当前运行时日志等级
+RL_LOG_LEVEL rl_log_get_level();
+
+// 设置日志头时间戳精度（默认 RL_LOG_TIME_SEC）
+int rl_log_set_time_precision(RL_LOG_TIME_PRECISION precision);
+
+// 配置日志轮转：超过 RL_LOG_FILE_SIZE 后重命名为 .1 ~ .keep_count 保留历史，compress 为真时由后台低优先级线程 gzip 压缩
+// keep_count 为 0 时不保留历史，直接清空日志文件
+int rl_log_rotate_config(unsigned int keep_count, bool compress);
+
+// 开启异步日志（在 rl_log_init 之后调用，slot_count 为 0 时使用默认值，rl_log_deint 时写完缓冲区中的日志）
+int rl_log_async_enable(unsigned int slot_count, RL_LOG_OVERFLOW_POLICY policy);
+
+// 获取异步模式下因缓冲区满而丢弃的日志条数
+unsigned long long rl_log_async_dropped();
+
+// 配置调用点（按格式串区分）限速和重复日志合并
+// rate 为每秒允许的条数（0 表示不限速），burst 为允许的突发条数（0 时与 rate 相同）
+// collapse 为 RL_TRUE 时，同一调用点连续输出的相同日志合并为 "last message repeated N times"
+// 默认不限速也不合并，调用本接口后才开启
+int rl_log_limit_config(unsigned int rate, unsigned int burst, bool collapse);
+
+// 获取日志统计信息
+int rl_log_get_stats(RL_LOG_STATS_T *stats);
+
+// 开启二进制日志模式（在 rl_log_init 之后调用，之后的日志写入 RL_LOG_BIN_FILE_DIR）
+// 只记录格式串编号和原始参数，不在设备上格式化；格式串首次使用时登记到日志文件中
+int rl_log_binary_enable();
+
+// 开启内存映射模式（在 rl_log_init 之后调用，与异步/暂存模式互斥）
+// 日志文件按 RL_LOG_FILE_SIZE 预分配并 mmap，写日志只需 memcpy 和一次原子加
+// 每 sync_interval_ms（为 0 时使用默认值）、写入 ERROR 日志及 rl_log_deint 时 msync 落盘
+// 开启期间独占日志文件（flock 排他锁），其他进程已打开该文件时返回失败；之后启动的进程和 fork 出的子进程写入 <文件名>.<进程号>
+int rl_log_mmap_enable(unsigned int sync_interval_ms);
+
+// 开启线程暂存模式（在 rl_log_init 之后调用，与异步模式互斥）
+// 每个线程先写入自己的暂存缓冲区，缓冲区满、超过 flush_interval_ms（为 0 时使用默认值）或写入 ERROR 日志时一次性刷新到文件
+// 日志头中附带单调时间戳（m微秒），用于恢复跨线程的先后顺序
+int rl_log_staged_enable(unsigned int flush_interval_ms);
+
 // __attribute__((format(printf, format_index, args_index))) 的意思是：
 // format_index：格式字符串参数在函数参数列表中的索引（从 1 开始）
 // args_index：变参开始的参数索引（从 1 开始）
@@ -38,6 +138,15 @@ void rl_log_warn(const char *fmt, ...) __attribute__((format(printf, 1, 2)));
 void rl_log_error(const char *fmt, ...) __attribute__((format(printf, 1, 2)));
 void rl_log_normal(const char *fmt, ...) __attribute__((format(printf, 1, 2)));
 
+// 判断某个等级的日志是否需要输出（编译期等级为常量比较，运行期等级只读一次内存）
+#define RL_LOG_ENABLED(level)   ((level) <= RL_LOG_COMPILE_LEVEL && (level) <= __atomic_load_n(&rl_log_cur_level, __ATOMIC_RELAXED))
+
+// 日志宏：等级未开启时不会计算参数，也不会调用日志函数
+#define RL_LOGE(fmt, ...)   do { if (RL_LOG_ENABLED(RL_LOG_LEVEL_ERROR)) rl_log_error(fmt, ##__VA_ARGS__); } while (0)
+#define RL_LOGW(fmt, ...)   do { if (RL_LOG_ENABLED(RL_LOG_LEVEL_WARN)) rl_log_warn(fmt, ##__VA_ARGS__); } while (0)
+#define RL_LOGI(fmt, ...)   do { if (RL_LOG_ENABLED(RL_LOG_LEVEL_INFO)) rl_log_info(fmt, ##__VA_ARGS__); } while (0)
+#define RL_LOGD(fmt, ...)   do { if (RL_LOG_ENABLED(RL_LOG_LEVEL_DEBUG)) rl_log_debug(fmt, ##__VA_ARGS__); } while (0)
+
 #ifdef __cplusplus
 }
 #endif
@@ -1,118 +1,2314 @@
 #include <time.h>
 #include <sys/stat.h>
 #include <sys/syscall.h>
+#include <sys/uio.h>
+#include <sys/wait.h>
+#include <sys/resource.h>
+#include <sys/mman.h>
+#include <sys/file.h>
+#include <sched.h>
+#include <spawn.h>
+#include <stdint.h>
+#include <stddef.h>
 #include "rllog.h"
+#include "rl/rlstat.h"
 
 // rl_log文件读写互斥锁
 static pthread_mutex_t rl_log_mutex = PTHREAD_MUTEX_INITIALIZER;
 // rl_log文件句柄
 static int log_file_fd = -1;
+// 当前日志文件路径（文本或二进制；其他进程以内存映射模式独占该文件时为 <文件名>.<进程号>）
+static const char *log_file_path = RL_LOG_FILE_DIR;
+// 日志文件的默认路径（文本或二进制）
+static const char *log_file_base = RL_LOG_FILE_DIR;
+static char log_file_path_buf[128];
+// 日志文件上持有的 flock 锁：普通模式为共享锁，内存映射模式为排他锁（只有一个进程写入时才能开启）
+static int log_file_lock = LOCK_SH;
+// 打开日志文件的进程号，fork 后子进程首次写入时重新打开
+static pid_t log_file_pid = 0;
+// 日志文件代数，每次打开新文件时加一（二进制模式据此在新文件中重新登记格式串）
+static unsigned int log_file_gen = 0;
+// 日志文件已写入的字节数（rl_log_init 时由 fstat 初始化，受 rl_log_mutex 保护）
+static off_t log_file_bytes = 0;
+// 日志文件的设备号和 inode，用于发现文件被外部替换
+static dev_t log_file_dev;
+static ino_t log_file_ino;
+// 距离上次检查日志文件状态的写入次数
+static unsigned int log_file_check_count = 0;
+
+// 保留的历史日志份数
+static unsigned int rl_log_rotate_keep = RL_LOG_ROTATE_KEEP_COUNT;
+// 是否压缩历史日志
+static bool rl_log_rotate_compress = RL_TRUE;
+// 后台轮转线程是否正在处理上一次轮转（受 rl_log_rotate_mutex 保护）
+static bool rl_log_rotate_pending = RL_FALSE;
+// 后台轮转线程是否已创建（受 rl_log_mutex 保护）
+static bool rl_log_rotate_thread_state = RL_FALSE;
+// 通知后台轮转线程退出
+static bool rl_log_rotate_exit = RL_FALSE;
+static pthread_t rl_log_rotate_thread;
+static pthread_mutex_t rl_log_rotate_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t rl_log_rotate_cond = PTHREAD_COND_INITIALIZER;
 // 进程pid
 static pid_t pid_now;
 // 进程名称（一般小于16个字符）
 static char proc_name[17] = {0};
-// 日志等级
-static RL_LOG_LEVEL cur_rl_log_level;
+// 日志等级（导出给 RL_LOGx 宏做快速判断）
+RL_LOG_LEVEL rl_log_cur_level = RL_LOG_LEVEL_NORMAL;
+// 已输出的日志条数（统计指标在 rl_log_init 时登记，导出到 rlstat 共享内存）
+static rl_stat_t *rl_log_stat_written = NULL;
+// 日志文件轮转次数
+static rl_stat_t *rl_log_stat_rotated = NULL;
+// 异步模式下缓冲区满被丢弃的日志条数（累计，不随重新开启异步模式清零）
+static rl_stat_t *rl_log_stat_dropped = NULL;
+
+// 单条格式化后日志的最大长度（日志头 + 日志内容）
+#define RL_LOG_RECORD_SIZE  (RL_LOG_BUF_SIZE + 128)
+
+// 日志头时间戳精度
+static RL_LOG_TIME_PRECISION rl_log_time_precision = RL_LOG_TIME_SEC;
+// 日志头中固定不变的部分："-进程名-p进程号-t"（rl_log_init 时生成）
+static char rl_log_proc_prefix[48] = {0};
+static int rl_log_proc_prefix_len = 0;
+// 当前线程的线程号缓存
+static __thread int rl_log_tid_cache = 0;
+// 当前线程缓存的秒数及对应的 "HH:MM:SS"
+static __thread time_t rl_log_time_cache_sec = -1;
+static __thread char rl_log_time_cache_str[8];
+
+// 异步日志槽位
+typedef struct
+{
+    // 槽位序号（生产者与写线程通过序号判断槽位是否可写/可读）
+    unsigned long seq;
+    // 日志长度
+    int len;
+    // 格式化后的日志
+    char buf[RL_LOG_RECORD_SIZE];
+} RL_LOG_SLOT_T;
+
+// 异步日志环形缓冲区（多生产者单消费者）
+typedef struct
+{
+    RL_LOG_SLOT_T *slots;
+    unsigned long mask;
+    // 生产者写入位置（CAS 竞争）
+    unsigned long enqueue_pos __attribute__((aligned(64)));
+    // 正在写入缓冲区的生产者数量
+    unsigned int inflight;
+    // 写线程读取位置（仅写线程访问）
+    unsigned long dequeue_pos __attribute__((aligned(64)));
+    // 缓冲区满时的处理策略
+    RL_LOG_OVERFLOW_POLICY policy;
+    // 丢弃的日志条数
+    unsigned long long dropped;
+    // 写线程是否在等待新日志
+    int sleeping;
+    pthread_mutex_t wait_mutex;
+    pthread_cond_t wait_cond;
+    pthread_t writer;
+} RL_LOG_RING_T;
+
+// 是否开启异步日志
+static bool rl_log_async_state = RL_FALSE;
+// 异步日志环形缓冲区
+static RL_LOG_RING_T rl_log_ring;
+// 缓冲区满按丢弃策略丢弃日志时的返回值（不算失败，但不计入已输出的条数）
+#define RL_LOG_DROPPED  1
+
+// 线程暂存缓冲区
+typedef struct RL_LOG_STAGE
+{
+    // 所属线程与刷新线程之间的互斥锁
+    pthread_mutex_t lock;
+    // 已暂存的字节数
+    unsigned int len;
+    // 上次刷新的单调时间（毫秒）
+    unsigned long long last_flush_ms;
+    struct RL_LOG_STAGE *next;
+    char buf[RL_LOG_STAGE_BUF_SIZE];
+} RL_LOG_STAGE_T;
+
+// 是否开启线程暂存模式
+static bool rl_log_staged_state = RL_FALSE;
+// 暂存模式刷新间隔（毫秒）
+static unsigned int rl_log_stage_interval_ms = RL_LOG_STAGE_FLUSH_MS;
+// 当前线程的暂存缓冲区
+static __thread RL_LOG_STAGE_T *rl_log_stage_self = NULL;
+// 正在写入暂存缓冲区的线程数量（关闭暂存模式时等待归零后再最后刷新一次）
+static unsigned int rl_log_stage_inflight = 0;
+// 所有线程暂存缓冲区链表及其互斥锁
+static RL_LOG_STAGE_T *rl_log_stage_list = NULL;
+static pthread_mutex_t rl_log_stage_list_mutex = PTHREAD_MUTEX_INITIALIZER;
+// 线程退出时刷新并释放暂存缓冲区
+static pthread_key_t rl_log_stage_key;
+static pthread_once_t rl_log_stage_key_once = PTHREAD_ONCE_INIT;
+// 定时刷新线程
+static pthread_t rl_log_stage_flusher;
+static pthread_mutex_t rl_log_stage_wait_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t rl_log_stage_wait_cond = PTHREAD_COND_INITIALIZER;
+
+// 获取单调时间（微秒）
+static unsigned long long rl_log_monotonic_us()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (unsigned long long)ts.tv_sec * 1000000ULL + ts.tv_nsec / 1000;
+}
+
+// 将无符号整数转换为十进制字符串，返回写入的长度
+static int rl_log_utoa(unsigned long long value, char *buf)
+{
+    char tmp[20];
+    int len = 0;
+    do
+    {
+        tmp[len++] = '0' + value % 10;
+        value /= 10;
+    } while (value != 0);
+    for (int i = 0; i < len; i++)
+    {
+        buf[i] = tmp[len - 1 - i];
+    }
+    return len;
+}
+
+// 将无符号整数转换为固定宽度、高位补零的十进制字符串
+static void rl_log_utoa_width(unsigned int value, char *buf, int width)
+{
+    for (int i = width - 1; i >= 0; i--)
+    {
+        buf[i] = '0' + value % 10;
+        value /= 10;
+    }
+}
+
+// 获取当前线程的日志头时间字符串，秒数变化时才重新 localtime_r，返回长度
+static int rl_log_time_str(char *buf)
+{
+    RL_LOG_TIME_PRECISION precision = __atomic_load_n(&rl_log_time_precision, __ATOMIC_RELAXED);
+    struct timespec ts;
+    // 微秒精度需要精确时钟，其余使用开销更低的粗粒度时钟
+    clock_gettime((precision == RL_LOG_TIME_US) ? CLOCK_REALTIME : CLOCK_REALTIME_COARSE, &ts);
+    if (ts.tv_sec != rl_log_time_cache_sec)
+    {
+        struct tm time_info;
+        localtime_r(&ts.tv_sec, &time_info);
+        rl_log_utoa_width(time_info.tm_hour, rl_log_time_cache_str, 2);
+        rl_log_time_cache_str[2] = ':';
+        rl_log_utoa_width(time_info.tm_min, rl_log_time_cache_str + 3, 2);
+        rl_log_time_cache_str[5] = ':';
+        rl_log_utoa_width(time_info.tm_sec, rl_log_time_cache_str + 6, 2);
+        rl_log_time_cache_sec = ts.tv_sec;
+    }
+    memcpy(buf, rl_log_time_cache_str, 8);
+    if (precision == RL_LOG_TIME_MS)
+    {
+        buf[8] = '.';
+        rl_log_utoa_width(ts.tv_nsec / 1000000, buf + 9, 3);
+        return 12;
+    }
+    else if (precision == RL_LOG_TIME_US)
+    {
+        buf[8] = '.';
+        rl_log_utoa_width(ts.tv_nsec / 1000, buf + 9, 6);
+        return 15;
+    }
+    return 8;
+}
+
+// 格式化单条日志，返回日志长度（mono_us 不为 0 时在日志头中附带单调时间戳）
+// 日志头格式：HH:MM:SS[.mmm|.uuuuuu]-进程名-p进程号-t线程号[-m单调时间] 等级:内容
+static int rl_log_format(RL_LOG_LEVEL level, const char *message, unsigned long long mono_us, char *log_buf, unsigned int size)
+{
+    char *p = log_buf;
+    if (level != RL_LOG_LEVEL_NORMAL)
+    {
+        // 时间
+        p += rl_log_time_str(p);
+        // 进程名和进程号（rl_log_init 时生成）
+        memcpy(p, rl_log_proc_prefix, rl_log_proc_prefix_len);
+        p += rl_log_proc_prefix_len;
+        // 线程号（每个线程只获取一次）
+        if (rl_log_tid_cache == 0)
+        {
+            rl_log_tid_cache = syscall(SYS_gettid);
+        }
+        p += rl_log_utoa(rl_log_tid_cache, p);
+        if (mono_us != 0)
+        {
+            *p++ = '-';
+            *p++ = 'm';
+            p += rl_log_utoa(mono_us, p);
+        }
+        *p++ = ' ';
+        // 日志等级
+        static const char *level_str[] = {"", "error:", "warn:", "info:", "debug:"};
+        static const int level_len[] = {0, 6, 5, 5, 6};
+        memcpy(p, level_str[level], level_len[level]);
+        p += level_len[level];
+    }
+    // 日志内容，超长时截断（保留一个字节给换行符）
+    size_t remain = log_buf + size - 1 - p;
+    size_t msg_len = strnlen(message, remain);
+    memcpy(p, message, msg_len);
+    p += msg_len;
+    if (level != RL_LOG_LEVEL_NORMAL)
+    {
+        *p++ = '\n';
+    }
+    *p = '\0';
+    return p - log_buf;
+}
+
+static bool rl_log_binary_state;
+static bool rl_log_mmap_state;
+static void rl_log_bin_write_session_locked();
+
+// 打开 log_file_path 并按 log_file_lock 加锁，返回文件描述符（调用者需持有 rl_log_mutex 或处于初始化阶段）
+// flock 锁属于打开的文件描述，fork 出的子进程需要自己重新打开；其他进程以内存映射模式独占该文件时，
+// 追加的内容会落在其预分配空间之后被截断，改为写入 <文件名>.<进程号>
+static int rl_log_file_open()
+{
+    log_file_pid = pid_now;
+    int fd = open(log_file_path, O_RDWR | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+    if (fd == -1 || flock(fd, log_file_lock | LOCK_NB) == 0 || errno != EWOULDBLOCK)
+    {
+        return fd;
+    }
+    char path[sizeof(log_file_path_buf)];
+    snprintf(path, sizeof(path), "%s.%d", log_file_base, pid_now);
+    // 已经是本进程单独的文件
+    if (strcmp(path, log_file_path) == 0)
+    {
+        return fd;
+    }
+    close(fd);
+    memcpy(log_file_path_buf, path, sizeof(path));
+    log_file_path = log_file_path_buf;
+    fd = open(log_file_path, O_RDWR | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+    if (fd != -1)
+    {
+        flock(fd, log_file_lock | LOCK_NB);
+    }
+    return fd;
+}
+
+// 记录日志文件的身份和当前大小（调用者需持有 rl_log_mutex 或处于初始化阶段）
+static int rl_log_file_seed()
+{
+    struct stat st;
+    if (fstat(log_file_fd, &st) == -1)
+    {
+        char err_msg[128] = {0};
+        snprintf(err_msg, sizeof(err_msg), "[rllog:%s:%d] Failed to fstat:%s", __FUNCTION__, __LINE__, log_file_path);
+        perror(err_msg);
+        return RL_FAILED;
+    }
+    log_file_dev = st.st_dev;
+    log_file_ino = st.st_ino;
+    log_file_bytes = st.st_size;
+    log_file_check_count = 0;
+    // 新文件需要重新登记二进制格式串并写入会话记录
+    __atomic_add_fetch(&log_file_gen, 1, __ATOMIC_RELEASE);
+    if (rl_log_binary_state == RL_TRUE)
+    {
+        rl_log_bin_write_session_locked();
+    }
+    return RL_SUCCESS;
+}
+
+// 截掉内存映射模式异常退出时残留在文件末尾的预分配空间（全为 '\0'），文本日志截到最后一个换行符之后
+// 只有文件以 '\0' 结尾时才处理，截断后更新 log_file_bytes（调用者需持有 rl_log_mutex 和文件的排他锁，
+// 否则末尾的 '\0' 可能是其他进程正在使用的映射区）
+static void rl_log_file_trim_tail()
+{
+    struct stat st;
+    if (fstat(log_file_fd, &st) == -1)
+    {
+        return;
+    }
+    char buf[16 * 1024];
+    off_t end = st.st_size;
+    off_t keep = -1;
+    bool data_found = RL_FALSE;
+    while (end > 0 && keep < 0)
+    {
+        size_t len = (end < (off_t)sizeof(buf)) ? (size_t)end : sizeof(buf);
+        off_t off = end - len;
+        if (pread(log_file_fd, buf, len, off) != (ssize_t)len)
+        {
+            return;
+        }
+        for (size_t i = len; i > 0 && keep < 0; i--)
+        {
+            char c = buf[i - 1];
+            if (data_found == RL_FALSE)
+            {
+                if (c == '\0')
+                {
+                    continue;
+                }
+                // 最后一字节不是 '\0'，不是异常退出留下的文件
+                if (off + (off_t)i == st.st_size)
+                {
+                    return;
+                }
+                data_found = RL_TRUE;
+                // 二进制记录中可能包含 '\0'，只截掉末尾的 '\0'，不完整的记录由解码工具跳过
+                if (rl_log_binary_state == RL_TRUE)
+                {
+                    keep = off + i;
+                }
+            }
+            // 最后一条记录可能只拷贝了一部分
+            if (keep < 0 && c == '\n')
+            {
+                keep = off + i;
+            }
+        }
+        end = off;
+    }
+    if (keep < 0)
+    {
+        keep = 0;
+    }
+    if (ftruncate(log_file_fd, keep) == -1)
+    {
+        char err_msg[128] = {0};
+        snprintf(err_msg, sizeof(err_msg), "[rllog:%s:%d] Failed to truncate:%s", __FUNCTION__, __LINE__, log_file_path);
+        perror(err_msg);
+        return;
+    }
+    log_file_bytes = keep;
+}
+
+// 重新打开日志文件（调用者需持有 rl_log_mutex）
+static int rl_log_file_reopen_locked()
+{
+    int fd = rl_log_file_open();
+    if (fd == -1)
+    {
+        char err_msg[128] = {0};
+        snprintf(err_msg, sizeof(err_msg), "[rllog:%s:%d] Failed to reopen:%s", __FUNCTION__, __LINE__, log_file_path);
+        perror(err_msg);
+        return RL_FAILED;
+    }
+    close(log_file_fd);
+    log_file_fd = fd;
+    return rl_log_file_seed();
+}
+
+// 检查日志文件是否被外部删除、替换或截断（调用者需持有 rl_log_mutex）
+static int rl_log_check_file_locked()
+{
+    struct stat st;
+    if (stat(log_file_path, &st) == 0 && st.st_dev == log_file_dev && st.st_ino == log_file_ino)
+    {
+        // 以实际大小为准（其他进程也在写入同一个文件）；内存映射模式下文件包含预分配空间，只在被外部截断时更新
+        if (rl_log_mmap_state == RL_FALSE || st.st_size < log_file_bytes)
+        {
+            log_file_bytes = st.st_size;
+        }
+        return RL_SUCCESS;
+    }
+    // 文件被删除或替换，重新打开
+    return rl_log_file_reopen_locked();
+}
+
+// 拼接第 index 份历史日志的路径
+static void rl_log_rotate_path(char *buf, unsigned int len, unsigned int index, bool gz)
+{
+    snprintf(buf, len, "%s.%u%s", log_file_path, index, (gz == RL_TRUE) ? ".gz" : "");
+}
+
+// 使用 gzip 压缩文件（子进程继承当前线程的低优先级）
+static int rl_log_rotate_gzip(const char *path)
+{
+    pid_t pid;
+    char *argv[] = {"gzip", "-f", "-q", (char *)path, NULL};
+    extern char **environ;
+    if (posix_spawnp(&pid, "gzip", NULL, NULL, argv, environ) != 0)
+    {
+        return RL_FAILED;
+    }
+    int status = 0;
+    while (waitpid(pid, &status, 0) == -1)
+    {
+        if (errno != EINTR)
+        {
+            return RL_FAILED;
+        }
+    }
+    return (WIFEXITED(status) && WEXITSTATUS(status) == 0) ? RL_SUCCESS : RL_FAILED;
+}
+
+// 后台轮转：依次后移历史日志，将 .0 改名为 .1 并压缩
+static void rl_log_rotate_shift()
+{
+    char src[128] = {0};
+    char dst[128] = {0};
+    unsigned int keep = rl_log_rotate_keep;
+    // 轮转期间被配置为不保留历史
+    if (keep == 0)
+    {
+        rl_log_rotate_path(src, sizeof(src), 0, RL_FALSE);
+        unlink(src);
+        return;
+    }
+    // 删除最旧的一份
+    rl_log_rotate_path(dst, sizeof(dst), keep, RL_FALSE);
+    unlink(dst);
+    rl_log_rotate_path(dst, sizeof(dst), keep, RL_TRUE);
+    unlink(dst);
+    // .N-1 -> .N ... .1 -> .2（压缩与未压缩的都处理）
+    for (unsigned int i = keep - 1; i >= 1; i--)
+    {
+        for (int gz = RL_FALSE; gz <= RL_TRUE; gz++)
+        {
+            rl_log_rotate_path(src, sizeof(src), i, gz);
+            rl_log_rotate_path(dst, sizeof(dst), i + 1, gz);
+            if (rename(src, dst) == -1 && errno != ENOENT)
+            {
+                char err_msg[128] = {0};
+                snprintf(err_msg, sizeof(err_msg), "[rllog:%s:%d] Failed to rename:%s", __FUNCTION__, __LINE__, src);
+                perror(err_msg);
+            }
+        }
+    }
+    // .0 -> .1
+    rl_log_rotate_path(src, sizeof(src), 0, RL_FALSE);
+    rl_log_rotate_path(dst, sizeof(dst), 1, RL_FALSE);
+    if (rename(src, dst) == -1)
+    {
+        char err_msg[128] = {0};
+        snprintf(err_msg, sizeof(err_msg), "[rllog:%s:%d] Failed to rename:%s", __FUNCTION__, __LINE__, src);
+        perror(err_msg);
+        return;
+    }
+    // 压缩失败（例如没有 gzip）时保留未压缩的文件
+    if (rl_log_rotate_compress == RL_TRUE)
+    {
+        rl_log_rotate_gzip(dst);
+    }
+}
+
+// 后台轮转线程（低优先级），避免日志线程承担重命名和压缩的耗时
+static void *rl_log_rotate_worker(void *arg)
+{
+    (void)arg;
+    // Linux 下 setpriority 可以只作用于当前线程
+    setpriority(PRIO_PROCESS, syscall(SYS_gettid), 19);
+    pthread_mutex_lock(&rl_log_rotate_mutex);
+    while (1)
+    {
+        while (rl_log_rotate_pending == RL_FALSE && rl_log_rotate_exit == RL_FALSE)
+        {
+            pthread_cond_wait(&rl_log_rotate_cond, &rl_log_rotate_mutex);
+        }
+        if (rl_log_rotate_pending == RL_FALSE)
+        {
+            break;
+        }
+        pthread_mutex_unlock(&rl_log_rotate_mutex);
+        rl_log_rotate_shift();
+        pthread_mutex_lock(&rl_log_rotate_mutex);
+        // 处理完成后才允许下一次轮转，避免 .0/.1 被并发改名
+        rl_log_rotate_pending = RL_FALSE;
+    }
+    pthread_mutex_unlock(&rl_log_rotate_mutex);
+    return NULL;
+}
+
+// 停止后台轮转线程（等待正在进行的轮转完成）
+static void rl_log_rotate_stop()
+{
+    if (rl_log_rotate_thread_state == RL_FALSE)
+    {
+        return;
+    }
+    pthread_mutex_lock(&rl_log_rotate_mutex);
+    rl_log_rotate_exit = RL_TRUE;
+    pthread_cond_signal(&rl_log_rotate_cond);
+    pthread_mutex_unlock(&rl_log_rotate_mutex);
+    pthread_join(rl_log_rotate_thread, NULL);
+    rl_log_rotate_thread_state = RL_FALSE;
+    rl_log_rotate_exit = RL_FALSE;
+}
+
+// 清空日志文件（不保留历史时使用，调用者需持有 rl_log_mutex）
+static int rl_log_clear_locked()
+{
+    // 清空文件内容
+    if (ftruncate(log_file_fd, 0) == -1)
+    {
+        char err_msg[128] = {0};
+        snprintf(err_msg, sizeof(err_msg), "[rllog:%s:%d] Failed to clear:%s", __FUNCTION__, __LINE__, log_file_path);
+        perror(err_msg);
+        return RL_FAILED;
+    }
+    // 将文件指针移动到文件开头
+    if (lseek(log_file_fd, 0, SEEK_SET) == -1)
+    {
+        char err_msg[128] = {0};
+        snprintf(err_msg, sizeof(err_msg), "[rllog:%s:%d] Failed to reset pointer:%s", __FUNCTION__, __LINE__, log_file_path);
+        perror(err_msg);
+        return RL_FAILED;
+    }
+    log_file_bytes = 0;
+    return RL_SUCCESS;
+}
+
+// 轮转日志文件（调用者需持有 rl_log_mutex）
+// 日志线程只把当前文件改名为 .0 并重新打开，后移历史和压缩交给后台线程
+static int rl_log_rotate_locked()
+{
+    // 多个进程共用日志文件时，其他进程可能已经完成了轮转：路径上已是新文件则只重新打开，不再改名
+    // （否则会把刚轮转出的新文件当作历史后移），重新打开后按新文件的实际大小判断是否需要轮转
+    struct stat st;
+    if (stat(log_file_path, &st) == 0 && (st.st_dev != log_file_dev || st.st_ino != log_file_ino))
+    {
+        return rl_log_file_reopen_locked();
+    }
+    if (rl_log_rotate_keep == 0)
+    {
+        if (rl_log_clear_locked() != RL_SUCCESS)
+        {
+            return RL_FAILED;
+        }
+        rl_stat_add(rl_log_stat_rotated, 1);
+        return RL_SUCCESS;
+    }
+    pthread_mutex_lock(&rl_log_rotate_mutex);
+    // 上一次轮转还未处理完，继续写入当前文件
+    if (rl_log_rotate_pending == RL_TRUE)
+    {
+        pthread_mutex_unlock(&rl_log_rotate_mutex);
+        return RL_SUCCESS;
+    }
+    pthread_mutex_unlock(&rl_log_rotate_mutex);
+    // 首次轮转时创建后台线程
+    if (rl_log_rotate_thread_state == RL_FALSE)
+    {
+        if (pthread_create(&rl_log_rotate_thread, NULL, rl_log_rotate_worker, NULL) != 0)
+        {
+            char err_msg[128] = {0};
+            snprintf(err_msg, sizeof(err_msg), "[rllog:%s:%d] create rotate thread failed", __FUNCTION__, __LINE__);
+            perror(err_msg);
+            return rl_log_clear_locked();
+        }
+        rl_log_rotate_thread_state = RL_TRUE;
+    }
+    char path[128] = {0};
+    rl_log_rotate_path(path, sizeof(path), 0, RL_FALSE);
+    if (rename(log_file_path, path) == -1)
+    {
+        char err_msg[128] = {0};
+        snprintf(err_msg, sizeof(err_msg), "[rllog:%s:%d] Failed to rename:%s", __FUNCTION__, __LINE__, log_file_path);
+        perror(err_msg);
+        return rl_log_clear_locked();
+    }
+    int fd = rl_log_file_open();
+    if (fd == -1)
+    {
+        char err_msg[128] = {0};
+        snprintf(err_msg, sizeof(err_msg), "[rllog:%s:%d] Failed to reopen:%s", __FUNCTION__, __LINE__, log_file_path);
+        perror(err_msg);
+        // 无法创建新文件时继续写入已改名的文件
+        return RL_FAILED;
+    }
+    close(log_file_fd);
+    log_file_fd = fd;
+    rl_log_file_seed();
+    rl_stat_add(rl_log_stat_rotated, 1);
+    // 通知后台线程处理历史日志
+    pthread_mutex_lock(&rl_log_rotate_mutex);
+    rl_log_rotate_pending = RL_TRUE;
+    pthread_cond_signal(&rl_log_rotate_cond);
+    pthread_mutex_unlock(&rl_log_rotate_mutex);
+    return RL_SUCCESS;
+}
+
+// 检查日志文件大小，超过 RL_LOG_FILE_SIZE 则轮转（调用者需持有 rl_log_mutex）
+static int rl_log_check_size_locked()
+{
+    // fork 后子进程首次写入时重新打开日志文件，不与父进程共用文件描述和锁
+    if (log_file_pid != pid_now && rl_log_file_reopen_locked() != RL_SUCCESS)
+    {
+        return RL_FAILED;
+    }
+    // 每 RL_LOG_FILE_CHECK_COUNT 次写入检查一次文件状态
+    if (++log_file_check_count >= RL_LOG_FILE_CHECK_COUNT)
+    {
+        log_file_check_count = 0;
+        if (rl_log_check_file_locked() != RL_SUCCESS)
+        {
+            return RL_FAILED;
+        }
+    }
+    // 超过 RL_LOG_FILE_SIZE 则轮转后再写入（使用内存中的计数，避免每条日志 stat）
+    if (log_file_bytes > RL_LOG_FILE_SIZE)
+    {
+        return rl_log_rotate_locked();
+    }
+    return RL_SUCCESS;
+}
+
+// 将多段日志一次写入文件，处理部分写入（调用者需持有 rl_log_mutex）
+static int rl_log_writev_locked(struct iovec *iov, int iov_cnt)
+{
+    while (iov_cnt > 0)
+    {
+        ssize_t ret = writev(log_file_fd, iov, iov_cnt);
+        if (ret == -1)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            char err_msg[128] = {0};
+            snprintf(err_msg, sizeof(err_msg), "[rllog:%s:%d] Failed to write log:%s", __FUNCTION__, __LINE__, log_file_path);
+            perror(err_msg);
+            return RL_FAILED;
+        }
+        log_file_bytes += ret;
+        // 跳过已经完整写入的段
+        while (iov_cnt > 0 && (size_t)ret >= iov->iov_len)
+        {
+            ret -= iov->iov_len;
+            iov++;
+            iov_cnt--;
+        }
+        // 调整部分写入的段
+        if (iov_cnt > 0)
+        {
+            iov->iov_base = (char *)iov->iov_base + ret;
+            iov->iov_len -= ret;
+        }
+    }
+    return RL_SUCCESS;
+}
+
+// 加锁写入多段日志到文件
+static int rl_log_output(struct iovec *iov, int iov_cnt)
+{
+    // 加锁
+    pthread_mutex_lock(&rl_log_mutex);
+    // 检查日志文件大小
+    if (rl_log_check_size_locked() != RL_SUCCESS)
+    {
+        // 解锁
+        pthread_mutex_unlock(&rl_log_mutex);
+        return RL_FAILED;
+    }
+    // log 写入文件
+    int ret = rl_log_writev_locked(iov, iov_cnt);
+    // 解锁
+    pthread_mutex_unlock(&rl_log_mutex);
+    return ret;
+}
+
+// 唤醒异步写线程
+static void rl_log_async_wakeup()
+{
+    if (__atomic_exchange_n(&rl_log_ring.sleeping, 0, __ATOMIC_SEQ_CST) != 0)
+    {
+        pthread_mutex_lock(&rl_log_ring.wait_mutex);
+        pthread_cond_signal(&rl_log_ring.wait_cond);
+        pthread_mutex_unlock(&rl_log_ring.wait_mutex);
+    }
+}
+
+// 将日志放入异步环形缓冲区（record 不为 NULL 时复制已编码的记录，否则格式化 message），按丢弃策略丢弃时返回 RL_LOG_DROPPED
+static int rl_log_async_push(RL_LOG_LEVEL level, const char *message, const char *record, int record_len)
+{
+    RL_LOG_RING_T *ring = &rl_log_ring;
+    RL_LOG_SLOT_T *slot = NULL;
+    unsigned long pos = __atomic_load_n(&ring->enqueue_pos, __ATOMIC_RELAXED);
+    while (1)
+    {
+        slot = &ring->slots[pos & ring->mask];
+        unsigned long seq = __atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE);
+        long diff = (long)seq - (long)pos;
+        if (diff == 0)
+        {
+            // 槽位空闲，尝试占用
+            if (__atomic_compare_exchange_n(&ring->enqueue_pos, &pos, pos + 1, RL_TRUE, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+            {
+                break;
+            }
+        }
+        else if (diff < 0)
+        {
+            // 缓冲区已满
+            if (ring->policy == RL_LOG_OVERFLOW_DROP)
+            {
+                __atomic_add_fetch(&ring->dropped, 1, __ATOMIC_RELAXED);
+                rl_stat_add(rl_log_stat_dropped, 1);
+                return RL_LOG_DROPPED;
+            }
+            // 阻塞策略：唤醒写线程后让出 CPU 等待槽位释放
+            rl_log_async_wakeup();
+            sched_yield();
+            pos = __atomic_load_n(&ring->enqueue_pos, __ATOMIC_RELAXED);
+        }
+        else
+        {
+            pos = __atomic_load_n(&ring->enqueue_pos, __ATOMIC_RELAXED);
+        }
+    }
+    // 直接格式化到槽位中，发布给写线程
+    if (record != NULL)
+    {
+        memcpy(slot->buf, record, record_len);
+        slot->len = record_len;
+    }
+    else
+    {
+        slot->len = rl_log_format(level, message, 0, slot->buf, sizeof(slot->buf));
+    }
+    __atomic_store_n(&slot->seq, pos + 1, __ATOMIC_RELEASE);
+    rl_log_async_wakeup();
+    return RL_SUCCESS;
+}
+
+// 批量取出缓冲区中已发布的日志并写入文件，返回写入条数
+static int rl_log_async_drain()
+{
+    RL_LOG_RING_T *ring = &rl_log_ring;
+    struct iovec iov[RL_LOG_ASYNC_BATCH_COUNT];
+    int count = 0;
+    unsigned long pos = ring->dequeue_pos;
+    while (count < RL_LOG_ASYNC_BATCH_COUNT)
+    {
+        RL_LOG_SLOT_T *slot = &ring->slots[(pos + count) & ring->mask];
+        if (__atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE) != pos + count + 1)
+        {
+            break;
+        }
+        iov[count].iov_base = slot->buf;
+        iov[count].iov_len = slot->len;
+        count++;
+    }
+    if (count == 0)
+    {
+        return 0;
+    }
+    rl_log_output(iov, count);
+    // 释放槽位给生产者
+    for (int i = 0; i < count; i++)
+    {
+        RL_LOG_SLOT_T *slot = &ring->slots[(pos + i) & ring->mask];
+        __atomic_store_n(&slot->seq, pos + i + ring->mask + 1, __ATOMIC_RELEASE);
+    }
+    ring->dequeue_pos = pos + count;
+    return count;
+}
+
+// 异步写线程
+static void *rl_log_async_writer(void *arg)
+{
+    (void)arg;
+    RL_LOG_RING_T *ring = &rl_log_ring;
+    while (1)
+    {
+        if (rl_log_async_drain() > 0)
+        {
+            continue;
+        }
+        // 已关闭异步模式且没有正在写入的生产者时，写完剩余日志后退出
+        if (__atomic_load_n(&rl_log_async_state, __ATOMIC_ACQUIRE) == RL_FALSE &&
+            __atomic_load_n(&ring->inflight, __ATOMIC_ACQUIRE) == 0)
+        {
+            // 等待已占用槽位的生产者发布日志
+            while (ring->dequeue_pos != __atomic_load_n(&ring->enqueue_pos, __ATOMIC_ACQUIRE))
+            {
+                if (rl_log_async_drain() == 0)
+                {
+                    sched_yield();
+                }
+            }
+            break;
+        }
+        // 标记等待后再次检查，避免错过唤醒
+        __atomic_store_n(&ring->sleeping, 1, __ATOMIC_SEQ_CST);
+        RL_LOG_SLOT_T *slot = &ring->slots[ring->dequeue_pos & ring->mask];
+        if (__atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE) == ring->dequeue_pos + 1)
+        {
+            __atomic_store_n(&ring->sleeping, 0, __ATOMIC_SEQ_CST);
+            continue;
+        }
+        pthread_mutex_lock(&ring->wait_mutex);
+        if (__atomic_load_n(&ring->sleeping, __ATOMIC_SEQ_CST) != 0)
+        {
+            // 超时兜底，保证关闭异步模式时能及时退出
+            struct timespec ts;
+            clock_gettime(CLOCK_REALTIME, &ts);
+            ts.tv_nsec += 100 * 1000 * 1000;
+            if (ts.tv_nsec >= 1000000000)
+            {
+                ts.tv_sec += 1;
+                ts.tv_nsec -= 1000000000;
+            }
+            pthread_cond_timedwait(&ring->wait_cond, &ring->wait_mutex, &ts);
+        }
+        pthread_mutex_unlock(&ring->wait_mutex);
+        __atomic_store_n(&ring->sleeping, 0, __ATOMIC_SEQ_CST);
+    }
+    return NULL;
+}
+
+// 关闭异步模式，写线程写完缓冲区中全部日志后退出
+static void rl_log_async_disable()
+{
+    if (rl_log_async_state == RL_FALSE)
+    {
+        return;
+    }
+    // 新日志改为同步写入
+    __atomic_store_n(&rl_log_async_state, RL_FALSE, __ATOMIC_RELEASE);
+    // 强制唤醒写线程
+    __atomic_store_n(&rl_log_ring.sleeping, 1, __ATOMIC_SEQ_CST);
+    rl_log_async_wakeup();
+    pthread_join(rl_log_ring.writer, NULL);
+    pthread_mutex_destroy(&rl_log_ring.wait_mutex);
+    pthread_cond_destroy(&rl_log_ring.wait_cond);
+    free(rl_log_ring.slots);
+    rl_log_ring.slots = NULL;
+}
+
+// 将暂存缓冲区刷新到文件（调用者需持有 stage->lock）
+static int rl_log_stage_flush_locked(RL_LOG_STAGE_T *stage, unsigned long long now_ms)
+{
+    int ret = RL_SUCCESS;
+    if (stage->len > 0)
+    {
+        struct iovec iov;
+        iov.iov_base = stage->buf;
+        iov.iov_len = stage->len;
+        ret = rl_log_output(&iov, 1);
+        stage->len = 0;
+    }
+    stage->last_flush_ms = now_ms;
+    return ret;
+}
+
+// 线程退出时刷新暂存缓冲区并从链表中移除
+static void rl_log_stage_destructor(void *arg)
+{
+    RL_LOG_STAGE_T *stage = (RL_LOG_STAGE_T *)arg;
+    pthread_mutex_lock(&rl_log_stage_list_mutex);
+    RL_LOG_STAGE_T **cur = &rl_log_stage_list;
+    while (*cur != NULL && *cur != stage)
+    {
+        cur = &((*cur)->next);
+    }
+    if (*cur == stage)
+    {
+        *cur = stage->next;
+    }
+    pthread_mutex_lock(&stage->lock);
+    if (log_file_fd != -1)
+    {
+        rl_log_stage_flush_locked(stage, 0);
+    }
+    pthread_mutex_unlock(&stage->lock);
+    pthread_mutex_unlock(&rl_log_stage_list_mutex);
+    pthread_mutex_destroy(&stage->lock);
+    // 之后运行的其他线程局部变量析构函数仍可能写日志，重新创建缓冲区
+    rl_log_stage_self = NULL;
+    free(stage);
+}
+
+static void rl_log_stage_key_create()
+{
+    pthread_key_create(&rl_log_stage_key, rl_log_stage_destructor);
+}
+
+// 获取当前线程的暂存缓冲区，首次使用时创建
+static RL_LOG_STAGE_T *rl_log_stage_get()
+{
+    if (rl_log_stage_self != NULL)
+    {
+        return rl_log_stage_self;
+    }
+    RL_LOG_STAGE_T *stage = (RL_LOG_STAGE_T *)malloc(sizeof(RL_LOG_STAGE_T));
+    if (stage == NULL)
+    {
+        return NULL;
+    }
+    pthread_mutex_init(&stage->lock, NULL);
+    stage->len = 0;
+    stage->last_flush_ms = rl_log_monotonic_us() / 1000;
+    pthread_mutex_lock(&rl_log_stage_list_mutex);
+    stage->next = rl_log_stage_list;
+    rl_log_stage_list = stage;
+    pthread_mutex_unlock(&rl_log_stage_list_mutex);
+    pthread_setspecific(rl_log_stage_key, stage);
+    rl_log_stage_self = stage;
+    return stage;
+}
+
+// 刷新所有线程的暂存缓冲区
+static void rl_log_stage_flush_all()
+{
+    unsigned long long now_ms = rl_log_monotonic_us() / 1000;
+    pthread_mutex_lock(&rl_log_stage_list_mutex);
+    for (RL_LOG_STAGE_T *stage = rl_log_stage_list; stage != NULL; stage = stage->next)
+    {
+        pthread_mutex_lock(&stage->lock);
+        rl_log_stage_flush_locked(stage, now_ms);
+        pthread_mutex_unlock(&stage->lock);
+    }
+    pthread_mutex_unlock(&rl_log_stage_list_mutex);
+}
+
+// 定时刷新线程：刷新长时间没有写满的暂存缓冲区
+static void *rl_log_stage_flusher_thread(void *arg)
+{
+    (void)arg;
+    pthread_mutex_lock(&rl_log_stage_wait_mutex);
+    while (rl_log_staged_state == RL_TRUE)
+    {
+        struct timespec ts;
+        clock_gettime(CLOCK_REALTIME, &ts);
+        ts.tv_sec += rl_log_stage_interval_ms / 1000;
+        ts.tv_nsec += (rl_log_stage_interval_ms % 1000) * 1000 * 1000;
+        if (ts.tv_nsec >= 1000000000)
+        {
+            ts.tv_sec += 1;
+            ts.tv_nsec -= 1000000000;
+        }
+        pthread_cond_timedwait(&rl_log_stage_wait_cond, &rl_log_stage_wait_mutex, &ts);
+        pthread_mutex_unlock(&rl_log_stage_wait_mutex);
+        rl_log_stage_flush_all();
+        pthread_mutex_lock(&rl_log_stage_wait_mutex);
+    }
+    pthread_mutex_unlock(&rl_log_stage_wait_mutex);
+    return NULL;
+}
+
+// 将日志写入当前线程的暂存缓冲区（record 不为 NULL 时复制已编码的记录，否则格式化 message）
+static int rl_log_stage_push(RL_LOG_LEVEL level, const char *message, const char *record, int record_len)
+{
+    RL_LOG_STAGE_T *stage = rl_log_stage_get();
+    if (stage == NULL)
+    {
+        return RL_FAILED;
+    }
+    unsigned long long now_us = rl_log_monotonic_us();
+    unsigned long long now_ms = now_us / 1000;
+    char log_buf[RL_LOG_RECORD_SIZE];
+    const char *log_data = record;
+    int log_len = record_len;
+    if (record == NULL)
+    {
+        log_len = rl_log_format(level, message, now_us, log_buf, sizeof(log_buf));
+        log_data = log_buf;
+    }
+    int ret = RL_SUCCESS;
+
+    pthread_mutex_lock(&stage->lock);
+    // 缓冲区放不下则先刷新
+    if (stage->len + log_len > sizeof(stage->buf))
+    {
+        ret = rl_log_stage_flush_locked(stage, now_ms);
+    }
+    memcpy(stage->buf + stage->len, log_data, log_len);
+    stage->len += log_len;
+    // ERROR 日志或超过刷新间隔时立即刷新
+    if (level == RL_LOG_LEVEL_ERROR || now_ms - stage->last_flush_ms >= rl_log_stage_interval_ms)
+    {
+        ret = rl_log_stage_flush_locked(stage, now_ms);
+    }
+    pthread_mutex_unlock(&stage->lock);
+    return ret;
+}
+
+// 关闭线程暂存模式，刷新全部暂存缓冲区
+static void rl_log_staged_disable()
+{
+    if (rl_log_staged_state == RL_FALSE)
+    {
+        return;
+    }
+    pthread_mutex_lock(&rl_log_stage_wait_mutex);
+    __atomic_store_n(&rl_log_staged_state, RL_FALSE, __ATOMIC_RELEASE);
+    pthread_cond_signal(&rl_log_stage_wait_cond);
+    pthread_mutex_unlock(&rl_log_stage_wait_mutex);
+    pthread_join(rl_log_stage_flusher, NULL);
+    while (__atomic_load_n(&rl_log_stage_inflight, __ATOMIC_ACQUIRE) != 0)
+    {
+        sched_yield();
+    }
+    rl_log_stage_flush_all();
+}
+
+// 内存映射模式：state 高 16 位为映射段代数，低 48 位为段内写入偏移
+#define RL_LOG_MMAP_GEN_SHIFT   48
+#define RL_LOG_MMAP_OFF_MASK    ((1ULL << RL_LOG_MMAP_GEN_SHIFT) - 1)
+// 映射段最小长度（文件接近 RL_LOG_FILE_SIZE 或后台仍在轮转时，每段至少映射这么多）
+#define RL_LOG_MMAP_MIN_SEG_SIZE    (1024 * 1024)
+
+// 内存映射日志段（两段交替使用，旧段在所有写入完成后才解除映射）
+typedef struct
+{
+    char *base;
+    // 该段在文件中的起始偏移（页对齐）
+    off_t file_off;
+    // 映射和预分配的长度（映射到文件的 RL_LOG_FILE_SIZE 处为止）
+    unsigned long long size;
+    // 已完成拷贝的字节数
+    unsigned long long committed;
+} RL_LOG_MMAP_SEG_T;
+
+// 是否开启内存映射模式
+static bool rl_log_mmap_state = RL_FALSE;
+// 当前段代数和段内偏移
+static unsigned long long rl_log_mmap_pos __attribute__((aligned(64))) = 0;
+// 正在写入映射区的线程数量
+static unsigned int rl_log_mmap_inflight = 0;
+static RL_LOG_MMAP_SEG_T rl_log_mmap_seg[2];
+// msync 间隔（毫秒）
+static unsigned int rl_log_mmap_sync_ms = RL_LOG_MMAP_SYNC_MS;
+// 定时 msync 线程
+static pthread_t rl_log_mmap_syncer;
+static pthread_mutex_t rl_log_mmap_wait_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t rl_log_mmap_wait_cond = PTHREAD_COND_INITIALIZER;
+
+// 从 log_file_bytes 处开始映射一段日志文件，返回段内起始偏移（调用者需持有 rl_log_mutex）
+static long long rl_log_mmap_map_locked(RL_LOG_MMAP_SEG_T *seg)
+{
+    long page = sysconf(_SC_PAGESIZE);
+    off_t file_off = log_file_bytes / page * page;
+    unsigned long long start = log_file_bytes - file_off;
+    // 映射到 RL_LOG_FILE_SIZE 为止，写满后轮转，文件不会超过 RL_LOG_FILE_SIZE 太多
+    unsigned long long size = ((unsigned long long)file_off < RL_LOG_FILE_SIZE) ? RL_LOG_FILE_SIZE - file_off : 0;
+    if (size < start + RL_LOG_MMAP_MIN_SEG_SIZE)
+    {
+        size = start + RL_LOG_MMAP_MIN_SEG_SIZE;
+    }
+    // 预分配空间，避免写入时因磁盘已满触发 SIGBUS
+    int ret = posix_fallocate(log_file_fd, file_off, size);
+    if (ret != 0)
+    {
+        errno = ret;
+        char err_msg[128] = {0};
+        snprintf(err_msg, sizeof(err_msg), "[rllog:%s:%d] Failed to fallocate:%s", __FUNCTION__, __LINE__, log_file_path);
+        perror(err_msg);
+        return RL_FAILED;
+    }
+    void *base = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, log_file_fd, file_off);
+    if (base == MAP_FAILED)
+    {
+        char err_msg[128] = {0};
+        snprintf(err_msg, sizeof(err_msg), "[rllog:%s:%d] Failed to mmap:%s", __FUNCTION__, __LINE__, log_file_path);
+        perror(err_msg);
+        ftruncate(log_file_fd, log_file_bytes);
+        return RL_FAILED;
+    }
+    seg->base = (char *)base;
+    seg->file_off = file_off;
+    seg->size = size;
+    seg->committed = start;
+    return start;
+}
+
+// 解除映射并截掉文件中预分配但未写入的部分（调用者需持有 rl_log_mutex）
+static void rl_log_mmap_unmap_locked(RL_LOG_MMAP_SEG_T *seg, unsigned long long used)
+{
+    log_file_bytes = seg->file_off + used;
+    munmap(seg->base, seg->size);
+    __atomic_store_n(&seg->base, NULL, __ATOMIC_RELEASE);
+    if (ftruncate(log_file_fd, log_file_bytes) == -1)
+    {
+        char err_msg[128] = {0};
+        snprintf(err_msg, sizeof(err_msg), "[rllog:%s:%d] Failed to truncate:%s", __FUNCTION__, __LINE__, log_file_path);
+        perror(err_msg);
+    }
+}
+
+// 等待某段中 off 之前的写入全部完成
+static void rl_log_mmap_wait_committed(RL_LOG_MMAP_SEG_T *seg, unsigned long long off)
+{
+    while (__atomic_load_n(&seg->committed, __ATOMIC_ACQUIRE) < off)
+    {
+        sched_yield();
+    }
+}
+
+// 映射段写满：切换到下一段，必要时轮转日志文件（仅由跨越段末尾的那个写入者调用）
+static void rl_log_mmap_next_segment(unsigned int gen, unsigned long long off)
+{
+    pthread_mutex_lock(&rl_log_mutex);
+    RL_LOG_MMAP_SEG_T *old_seg = &rl_log_mmap_seg[gen & 1];
+    RL_LOG_MMAP_SEG_T *new_seg = &rl_log_mmap_seg[(gen + 1) & 1];
+    rl_log_mmap_wait_committed(old_seg, off);
+    rl_log_mmap_unmap_locked(old_seg, off);
+    long long start = RL_FAILED;
+    if (rl_log_mmap_state == RL_TRUE)
+    {
+        // 剩余空间放不下一条日志则轮转（后台仍在处理上一次轮转时继续映射当前文件的后续部分）
+        if (log_file_bytes + RL_LOG_RECORD_SIZE >= RL_LOG_FILE_SIZE)
+        {
+            rl_log_rotate_locked();
+        }
+        start = rl_log_mmap_map_locked(new_seg);
+    }
+    if (start < 0)
+    {
+        // 无法继续映射，退回同步写入
+        __atomic_store_n(&rl_log_mmap_state, RL_FALSE, __ATOMIC_RELEASE);
+        start = 0;
+    }
+    __atomic_store_n(&rl_log_mmap_pos, ((unsigned long long)(gen + 1) << RL_LOG_MMAP_GEN_SHIFT) | start, __ATOMIC_RELEASE);
+    pthread_mutex_unlock(&rl_log_mutex);
+}
+
+// 将一条日志写入映射区，映射模式已关闭时返回 RL_FAILED 由调用者改为同步写入
+static int rl_log_mmap_append(RL_LOG_LEVEL level, const char *data, int len)
+{
+    while (__atomic_load_n(&rl_log_mmap_state, __ATOMIC_ACQUIRE) == RL_TRUE)
+    {
+        unsigned long long pos = __atomic_fetch_add(&rl_log_mmap_pos, len, __ATOMIC_ACQ_REL);
+        unsigned int gen = pos >> RL_LOG_MMAP_GEN_SHIFT;
+        unsigned long long off = pos & RL_LOG_MMAP_OFF_MASK;
+        RL_LOG_MMAP_SEG_T *seg = &rl_log_mmap_seg[gen & 1];
+        if (off + len <= seg->size)
+        {
+            memcpy(seg->base + off, data, len);
+            __atomic_add_fetch(&seg->committed, len, __ATOMIC_RELEASE);
+            // ERROR 日志立即落盘
+            if (level == RL_LOG_LEVEL_ERROR)
+            {
+                long page = sysconf(_SC_PAGESIZE);
+                unsigned long long begin = off / page * page;
+                msync(seg->base + begin, off + len - begin, MS_SYNC);
+            }
+            return RL_SUCCESS;
+        }
+        if (off <= seg->size)
+        {
+            // 本条日志跨越段末尾，由本线程切换到下一段
+            rl_log_mmap_next_segment(gen, off);
+            continue;
+        }
+        // 等待其他线程切换段
+        while ((__atomic_load_n(&rl_log_mmap_pos, __ATOMIC_ACQUIRE) >> RL_LOG_MMAP_GEN_SHIFT) == gen &&
+               __atomic_load_n(&rl_log_mmap_state, __ATOMIC_ACQUIRE) == RL_TRUE)
+        {
+            sched_yield();
+        }
+    }
+    return RL_FAILED;
+}
+
+// 将当前映射段中已写入的部分同步到磁盘（调用者需持有 rl_log_mutex）
+static void rl_log_mmap_sync_locked()
+{
+    unsigned long long pos = __atomic_load_n(&rl_log_mmap_pos, __ATOMIC_ACQUIRE);
+    RL_LOG_MMAP_SEG_T *seg = &rl_log_mmap_seg[(pos >> RL_LOG_MMAP_GEN_SHIFT) & 1];
+    unsigned long long used = __atomic_load_n(&seg->committed, __ATOMIC_ACQUIRE);
+    if (seg->base != NULL && used > 0)
+    {
+        msync(seg->base, (used < seg->size) ? used : seg->size, MS_SYNC);
+    }
+}
+
+// 定时 msync 线程
+static void *rl_log_mmap_syncer_thread(void *arg)
+{
+    (void)arg;
+    pthread_mutex_lock(&rl_log_mmap_wait_mutex);
+    while (rl_log_mmap_state == RL_TRUE)
+    {
+        struct timespec ts;
+        clock_gettime(CLOCK_REALTIME, &ts);
+        ts.tv_sec += rl_log_mmap_sync_ms / 1000;
+        ts.tv_nsec += (rl_log_mmap_sync_ms % 1000) * 1000 * 1000;
+        if (ts.tv_nsec >= 1000000000)
+        {
+            ts.tv_sec += 1;
+            ts.tv_nsec -= 1000000000;
+        }
+        pthread_cond_timedwait(&rl_log_mmap_wait_cond, &rl_log_mmap_wait_mutex, &ts);
+        pthread_mutex_unlock(&rl_log_mmap_wait_mutex);
+        pthread_mutex_lock(&rl_log_mutex);
+        if (rl_log_mmap_state == RL_TRUE)
+        {
+            rl_log_mmap_sync_locked();
+        }
+        pthread_mutex_unlock(&rl_log_mutex);
+        pthread_mutex_lock(&rl_log_mmap_wait_mutex);
+    }
+    pthread_mutex_unlock(&rl_log_mmap_wait_mutex);
+    return NULL;
+}
+
+// 关闭内存映射模式：等待正在进行的写入完成，落盘后截掉预分配的空间
+static void rl_log_mmap_disable()
+{
+    pthread_mutex_lock(&rl_log_mmap_wait_mutex);
+    bool state = rl_log_mmap_state;
+    __atomic_store_n(&rl_log_mmap_state, RL_FALSE, __ATOMIC_RELEASE);
+    pthread_cond_signal(&rl_log_mmap_wait_cond);
+    pthread_mutex_unlock(&rl_log_mmap_wait_mutex);
+    if (state == RL_FALSE)
+    {
+        return;
+    }
+    pthread_join(rl_log_mmap_syncer, NULL);
+    while (__atomic_load_n(&rl_log_mmap_inflight, __ATOMIC_ACQUIRE) != 0)
+    {
+        sched_yield();
+    }
+    pthread_mutex_lock(&rl_log_mutex);
+    unsigned long long pos = __atomic_load_n(&rl_log_mmap_pos, __ATOMIC_ACQUIRE);
+    RL_LOG_MMAP_SEG_T *seg = &rl_log_mmap_seg[(pos >> RL_LOG_MMAP_GEN_SHIFT) & 1];
+    if (seg->base != NULL)
+    {
+        unsigned long long used = __atomic_load_n(&seg->committed, __ATOMIC_ACQUIRE);
+        msync(seg->base, used, MS_SYNC);
+        rl_log_mmap_unmap_locked(seg, used);
+    }
+    // 预分配空间已截掉，允许其他进程写入
+    log_file_lock = LOCK_SH;
+    flock(log_file_fd, LOCK_SH);
+    pthread_mutex_unlock(&rl_log_mutex);
+}
+
+// 写入日志函数（record 不为 NULL 时直接写入已编码的二进制记录，否则按文本格式化 message），异步缓冲区满被丢弃时返回 RL_LOG_DROPPED
+static int write_rl_log(RL_LOG_LEVEL level, const char *message, const char *record, int record_len)
+{
+    // 检查文件状态
+    if (log_file_fd == -1)
+    {
+        char err_msg[128] = {0};
+        snprintf(err_msg, sizeof(err_msg), "[rllog:write_rl_log:24] Failed to open:%s", log_file_path);
+        perror(err_msg);
+        return RL_FAILED;
+    }
+
+    // 内存映射模式：拷贝到映射区
+    if (__atomic_load_n(&rl_log_mmap_state, __ATOMIC_ACQUIRE) == RL_TRUE)
+    {
+        char log_buf[RL_LOG_RECORD_SIZE];
+        if (record == NULL)
+        {
+            record_len = rl_log_format(level, message, 0, log_buf, sizeof(log_buf));
+            record = log_buf;
+        }
+        __atomic_add_fetch(&rl_log_mmap_inflight, 1, __ATOMIC_ACQ_REL);
+        int ret = rl_log_mmap_append(level, record, record_len);
+        __atomic_sub_fetch(&rl_log_mmap_inflight, 1, __ATOMIC_ACQ_REL);
+        if (ret == RL_SUCCESS)
+        {
+            return RL_SUCCESS;
+        }
+        // 映射模式已关闭：等映射区截断完成后改为同步写入，避免写到预分配空间之后
+        while (__atomic_load_n(&rl_log_mmap_seg[0].base, __ATOMIC_ACQUIRE) != NULL ||
+               __atomic_load_n(&rl_log_mmap_seg[1].base, __ATOMIC_ACQUIRE) != NULL)
+        {
+            sched_yield();
+        }
+        struct iovec iov;
+        iov.iov_base = (void *)record;
+        iov.iov_len = record_len;
+        return rl_log_output(&iov, 1);
+    }
+    // 异步模式：放入环形缓冲区，由写线程批量写入
+    else if (__atomic_load_n(&rl_log_async_state, __ATOMIC_ACQUIRE) == RL_TRUE)
+    {
+        __atomic_add_fetch(&rl_log_ring.inflight, 1, __ATOMIC_ACQ_REL);
+        // 再次确认，避免在关闭异步模式的同时写入
+        if (__atomic_load_n(&rl_log_async_state, __ATOMIC_ACQUIRE) == RL_TRUE)
+        {
+            int ret = rl_log_async_push(level, message, record, record_len);
+            __atomic_sub_fetch(&rl_log_ring.inflight, 1, __ATOMIC_ACQ_REL);
+            return ret;
+        }
+        __atomic_sub_fetch(&rl_log_ring.inflight, 1, __ATOMIC_ACQ_REL);
+    }
+    // 线程暂存模式：写入本线程缓冲区，批量刷新
+    else if (__atomic_load_n(&rl_log_staged_state, __ATOMIC_ACQUIRE) == RL_TRUE)
+    {
+        __atomic_add_fetch(&rl_log_stage_inflight, 1, __ATOMIC_ACQ_REL);
+        // 再次确认，避免在关闭暂存模式最后一次刷新之后写入
+        if (__atomic_load_n(&rl_log_staged_state, __ATOMIC_ACQUIRE) == RL_TRUE)
+        {
+            int ret = rl_log_stage_push(level, message, record, record_len);
+            __atomic_sub_fetch(&rl_log_stage_inflight, 1, __ATOMIC_ACQ_REL);
+            return ret;
+        }
+        __atomic_sub_fetch(&rl_log_stage_inflight, 1, __ATOMIC_ACQ_REL);
+    }
+
+    // 格式化日志内容
+    char log_buf[RL_LOG_RECORD_SIZE];
+    struct iovec iov;
+    if (record != NULL)
+    {
+        iov.iov_base = (void *)record;
+        iov.iov_len = record_len;
+    }
+    else
+    {
+        iov.iov_base = log_buf;
+        iov.iov_len = rl_log_format(level, message, 0, log_buf, sizeof(log_buf));
+    }
+
+    // log 写入文件
+    return rl_log_output(&iov, 1);
+}
+
+// 二进制日志记录头（所有多字节字段为设备本机字节序，rllog_decode 中有相同定义）
+typedef struct
+{
+    uint16_t magic;
+    uint8_t type;
+    uint8_t level;
+    // 整条记录长度（含记录头）
+    uint32_t len;
+} __attribute__((packed)) RL_LOG_BIN_HEAD_T;
+
+// 会话记录：每次打开日志文件时写入，标识进程和格式串编号的作用域
+typedef struct
+{
+    RL_LOG_BIN_HEAD_T head;
+    uint32_t version;
+    uint32_t pid;
+    // 设备上 long 的字节数，解码 %ld 时使用
+    uint8_t long_size;
+    uint8_t reserved[3];
+    // 会话编号（rl_log_init 时的 CLOCK_REALTIME 纳秒）
+    uint64_t session;
+    char proc_name[16];
+} __attribute__((packed)) RL_LOG_BIN_SESSION_T;
+
+// 日志记录：格式串编号 + 原始参数
+typedef struct
+{
+    RL_LOG_BIN_HEAD_T head;
+    // CLOCK_REALTIME 纳秒
+    uint64_t time_ns;
+    // CLOCK_MONOTONIC 微秒，用于恢复跨线程顺序
+    uint64_t mono_us;
+    uint32_t tid;
+    uint32_t fmt_id;
+} __attribute__((packed)) RL_LOG_BIN_RECORD_T;
+
+#define RL_LOG_BIN_MAGIC            0x4C52
+#define RL_LOG_BIN_VERSION          1
+// 记录类型
+#define RL_LOG_BIN_TYPE_SESSION     1   // 会话
+#define RL_LOG_BIN_TYPE_FORMAT      2   // 格式串登记：uint32 编号 + 以 '\0' 结尾的格式串
+#define RL_LOG_BIN_TYPE_RECORD      3   // 日志：RL_LOG_BIN_RECORD_T + 参数
+#define RL_LOG_BIN_TYPE_TEXT        4   // 无法二进制编码的日志：RL_LOG_BIN_RECORD_T + 格式化后的文本
+// 参数类型（整数统一按 8 字节保存，字符串为 uint16 长度 + 内容）
+#define RL_LOG_BIN_ARG_INT          1
+#define RL_LOG_BIN_ARG_LONG         2
+#define RL_LOG_BIN_ARG_LLONG        3
+#define RL_LOG_BIN_ARG_SIZE         4
+#define RL_LOG_BIN_ARG_INTMAX       5
+#define RL_LOG_BIN_ARG_PTRDIFF      6
+#define RL_LOG_BIN_ARG_DOUBLE       7
+#define RL_LOG_BIN_ARG_LDOUBLE      8
+#define RL_LOG_BIN_ARG_STR          9
+#define RL_LOG_BIN_ARG_PTR          10
+// 单个格式串最多支持的参数个数
+#define RL_LOG_BIN_MAX_ARGS         16
+// 格式串登记表大小（必须为 2 的幂）
+#define RL_LOG_BIN_FMT_TABLE_SIZE   4096
+// 查找格式串最多探测的位置数（超过后按文本记录输出，表满时不会每条日志遍历整个表）
+#define RL_LOG_BIN_FMT_PROBE        16
+
+// 已登记的格式串
+typedef struct
+{
+    // 格式串内容哈希（0 表示空位）
+    uint64_t hash;
+    // 格式串副本
+    char *fmt;
+    uint32_t id;
+    // 参数个数（-1 表示无法二进制编码）
+    int arg_count;
+    unsigned char arg_type[RL_LOG_BIN_MAX_ARGS];
+    // 已登记到哪一代日志文件
+    unsigned int def_gen;
+} RL_LOG_BIN_FMT_T;
+
+// 是否开启二进制日志
+static bool rl_log_binary_state = RL_FALSE;
+// 会话编号
+static uint64_t rl_log_bin_session = 0;
+// 格式串登记表（查找无锁，插入加锁）
+static RL_LOG_BIN_FMT_T rl_log_bin_fmt_table[RL_LOG_BIN_FMT_TABLE_SIZE];
+static pthread_mutex_t rl_log_bin_fmt_mutex = PTHREAD_MUTEX_INITIALIZER;
+static uint32_t rl_log_bin_fmt_next_id = 1;
+
+// 关闭二进制日志模式（rl_log_deint 时调用，之后重新 rl_log_init 写入的是文本日志）
+// 已登记的格式串保留（查找无锁，不能释放），只清除登记到的文件代数，重新开启时会再次登记
+static void rl_log_bin_reset()
+{
+    __atomic_store_n(&rl_log_binary_state, RL_FALSE, __ATOMIC_RELEASE);
+    pthread_mutex_lock(&rl_log_bin_fmt_mutex);
+    for (unsigned int i = 0; i < RL_LOG_BIN_FMT_TABLE_SIZE; i++)
+    {
+        __atomic_store_n(&rl_log_bin_fmt_table[i].def_gen, 0, __ATOMIC_RELAXED);
+    }
+    pthread_mutex_unlock(&rl_log_bin_fmt_mutex);
+    __atomic_store_n(&log_file_gen, 0, __ATOMIC_RELEASE);
+}
+
+// 写入二进制会话记录（调用者需持有 rl_log_mutex）
+static void rl_log_bin_write_session_locked()
+{
+    RL_LOG_BIN_SESSION_T session;
+    memset(&session, 0, sizeof(session));
+    session.head.magic = RL_LOG_BIN_MAGIC;
+    session.head.type = RL_LOG_BIN_TYPE_SESSION;
+    session.head.len = sizeof(session);
+    session.version = RL_LOG_BIN_VERSION;
+    session.pid = pid_now;
+    session.long_size = sizeof(long);
+    session.session = rl_log_bin_session;
+    memcpy(session.proc_name, proc_name, sizeof(session.proc_name));
+    struct iovec iov;
+    iov.iov_base = &session;
+    iov.iov_len = sizeof(session);
+    rl_log_writev_locked(&iov, 1);
+}
+
+// 计算格式串哈希（FNV-1a，避免返回 0）
+static uint64_t rl_log_bin_hash(const char *fmt)
+{
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    while (*fmt != '\0')
+    {
+        hash ^= (unsigned char)*fmt++;
+        hash *= 0x100000001b3ULL;
+    }
+    return (hash == 0) ? 1 : hash;
+}
+
+// 解析格式串中的参数类型，返回参数个数，无法二进制编码时返回 -1
+static int rl_log_bin_parse(const char *fmt, unsigned char *arg_type)
+{
+    int count = 0;
+    for (const char *p = fmt; *p != '\0'; p++)
+    {
+        if (*p != '%')
+        {
+            continue;
+        }
+        p++;
+        if (*p == '%')
+        {
+            continue;
+        }
+        // 标志
+        while (*p != '\0' && strchr("-+ #0'", *p) != NULL)
+        {
+            p++;
+        }
+        // 宽度与精度（* 需要额外的 int 参数）
+        for (int part = 0; part < 2; part++)
+        {
+            if (part == 1)
+            {
+                if (*p != '.')
+                {
+                    break;
+                }
+                p++;
+            }
+            if (*p == '*')
+            {
+                if (count >= RL_LOG_BIN_MAX_ARGS)
+                {
+                    return -1;
+                }
+                arg_type[count++] = RL_LOG_BIN_ARG_INT;
+                p++;
+            }
+            while (*p >= '0' && *p <= '9')
+            {
+                p++;
+            }
+            // 不支持 %1$d 这样的位置参数
+            if (*p == '$')
+            {
+                return -1;
+            }
+        }
+        // 长度修饰符
+        int type = RL_LOG_BIN_ARG_INT;
+        if (*p == 'h')
+        {
+            p += (p[1] == 'h') ? 2 : 1;
+        }
+        else if (*p == 'l')
+        {
+            type = (p[1] == 'l') ? RL_LOG_BIN_ARG_LLONG : RL_LOG_BIN_ARG_LONG;
+            p += (p[1] == 'l') ? 2 : 1;
+        }
+        else if (*p == 'q' || *p == 'L')
+        {
+            type = RL_LOG_BIN_ARG_LLONG;
+            p++;
+        }
+        else if (*p == 'z')
+        {
+            type = RL_LOG_BIN_ARG_SIZE;
+            p++;
+        }
+        else if (*p == 'j')
+        {
+            type = RL_LOG_BIN_ARG_INTMAX;
+            p++;
+        }
+        else if (*p == 't')
+        {
+            type = RL_LOG_BIN_ARG_PTRDIFF;
+            p++;
+        }
+        // 转换说明符
+        switch (*p)
+        {
+        case 'd': case 'i': case 'u': case 'x': case 'X': case 'o':
+            break;
+        case 'c':
+            // 不支持宽字符
+            if (type != RL_LOG_BIN_ARG_INT)
+            {
+                return -1;
+            }
+            break;
+        case 'f': case 'F': case 'e': case 'E': case 'g': case 'G': case 'a': case 'A':
+            type = (p[-1] == 'L') ? RL_LOG_BIN_ARG_LDOUBLE : RL_LOG_BIN_ARG_DOUBLE;
+            break;
+        case 's':
+            if (type != RL_LOG_BIN_ARG_INT)
+            {
+                return -1;
+            }
+            type = RL_LOG_BIN_ARG_STR;
+            break;
+        case 'p':
+            type = RL_LOG_BIN_ARG_PTR;
+            break;
+        default:
+            // %n、%m 等无法离线还原
+            return -1;
+        }
+        if (count >= RL_LOG_BIN_MAX_ARGS)
+        {
+            return -1;
+        }
+        arg_type[count++] = type;
+    }
+    return count;
+}
+
+// 查找格式串，首次使用时登记，探测 RL_LOG_BIN_FMT_PROBE 个位置都没有找到或登记时返回 NULL
+static RL_LOG_BIN_FMT_T *rl_log_bin_lookup(const char *fmt)
+{
+    uint64_t hash = rl_log_bin_hash(fmt);
+    unsigned int mask = RL_LOG_BIN_FMT_TABLE_SIZE - 1;
+    unsigned int index = hash & mask;
+    for (unsigned int i = 0; i < RL_LOG_BIN_FMT_PROBE; i++)
+    {
+        RL_LOG_BIN_FMT_T *entry = &rl_log_bin_fmt_table[(index + i) & mask];
+        uint64_t entry_hash = __atomic_load_n(&entry->hash, __ATOMIC_ACQUIRE);
+        if (entry_hash == hash && strcmp(entry->fmt, fmt) == 0)
+        {
+            return entry;
+        }
+        if (entry_hash != 0)
+        {
+            continue;
+        }
+        // 空位：加锁后登记
+        pthread_mutex_lock(&rl_log_bin_fmt_mutex);
+        // 其他线程可能已经占用了该位置
+        if (entry->hash != 0)
+        {
+            pthread_mutex_unlock(&rl_log_bin_fmt_mutex);
+            if (entry->hash == hash && strcmp(entry->fmt, fmt) == 0)
+            {
+                return entry;
+            }
+            continue;
+        }
+        entry->fmt = strdup(fmt);
+        if (entry->fmt == NULL)
+        {
+            pthread_mutex_unlock(&rl_log_bin_fmt_mutex);
+            return NULL;
+        }
+        entry->id = rl_log_bin_fmt_next_id++;
+        entry->arg_count = rl_log_bin_parse(fmt, entry->arg_type);
+        entry->def_gen = 0;
+        __atomic_store_n(&entry->hash, hash, __ATOMIC_RELEASE);
+        pthread_mutex_unlock(&rl_log_bin_fmt_mutex);
+        return entry;
+    }
+    return NULL;
+}
+
+// 按类型把参数追加到记录中，空间不足时返回 RL_FAILED
+static int rl_log_bin_put(char *buf, unsigned int size, unsigned int *pos, const void *data, unsigned int len)
+{
+    if (*pos + len > size)
+    {
+        return RL_FAILED;
+    }
+    memcpy(buf + *pos, data, len);
+    *pos += len;
+    return RL_SUCCESS;
+}
+
+// 编码一条二进制日志（必要时先登记格式串）并写入
+static int rl_log_bin_write(RL_LOG_LEVEL level, const char *fmt, va_list args)
+{
+    char buf[RL_LOG_RECORD_SIZE];
+    RL_LOG_BIN_RECORD_T *rec = (RL_LOG_BIN_RECORD_T *)buf;
+    unsigned int pos = sizeof(RL_LOG_BIN_RECORD_T);
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    if (rl_log_tid_cache == 0)
+    {
+        rl_log_tid_cache = syscall(SYS_gettid);
+    }
+    rec->head.magic = RL_LOG_BIN_MAGIC;
+    rec->head.level = level;
+    rec->time_ns = (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+    rec->mono_us = rl_log_monotonic_us();
+    rec->tid = rl_log_tid_cache;
+
+    RL_LOG_BIN_FMT_T *entry = rl_log_bin_lookup(fmt);
+    if (entry == NULL || entry->arg_count < 0)
+    {
+        // 无法二进制编码：格式化为文本记录
+        rec->head.type = RL_LOG_BIN_TYPE_TEXT;
+        rec->fmt_id = 0;
+        int len = vsnprintf(buf + pos, sizeof(buf) - pos, fmt, args);
+        if (len < 0)
+        {
+            return RL_FAILED;
+        }
+        pos += ((unsigned int)len >= sizeof(buf) - pos) ? sizeof(buf) - pos - 1 : (unsigned int)len;
+        rec->head.len = pos;
+        return write_rl_log(level, NULL, buf, pos);
+    }
+
+    // 新的日志文件中还未登记该格式串
+    unsigned int gen = __atomic_load_n(&log_file_gen, __ATOMIC_ACQUIRE);
+    if (__atomic_load_n(&entry->def_gen, __ATOMIC_RELAXED) != gen)
+    {
+        char def_buf[RL_LOG_RECORD_SIZE];
+        RL_LOG_BIN_HEAD_T *def = (RL_LOG_BIN_HEAD_T *)def_buf;
+        unsigned int fmt_len = strlen(entry->fmt) + 1;
+        unsigned int def_len = sizeof(RL_LOG_BIN_HEAD_T) + sizeof(uint32_t) + fmt_len;
+        if (def_len > sizeof(def_buf))
+        {
+            fmt_len -= def_len - sizeof(def_buf);
+            def_len = sizeof(def_buf);
+        }
+        def->magic = RL_LOG_BIN_MAGIC;
+        def->type = RL_LOG_BIN_TYPE_FORMAT;
+        def->level = level;
+        def->len = def_len;
+        memcpy(def_buf + sizeof(RL_LOG_BIN_HEAD_T), &entry->id, sizeof(uint32_t));
+        memcpy(def_buf + sizeof(RL_LOG_BIN_HEAD_T) + sizeof(uint32_t), entry->fmt, fmt_len);
+        def_buf[def_len - 1] = '\0';
+        write_rl_log(level, NULL, def_buf, def_len);
+        __atomic_store_n(&entry->def_gen, gen, __ATOMIC_RELAXED);
+    }
+
+    rec->head.type = RL_LOG_BIN_TYPE_RECORD;
+    rec->fmt_id = entry->id;
+    for (int i = 0; i < entry->arg_count; i++)
+    {
+        int64_t value = 0;
+        double dvalue = 0;
+        switch (entry->arg_type[i])
+        {
+        case RL_LOG_BIN_ARG_INT:
+            value = va_arg(args, int);
+            break;
+        case RL_LOG_BIN_ARG_LONG:
+            value = va_arg(args, long);
+            break;
+        case RL_LOG_BIN_ARG_LLONG:
+            value = va_arg(args, long long);
+            break;
+        case RL_LOG_BIN_ARG_SIZE:
+            value = va_arg(args, size_t);
+            break;
+        case RL_LOG_BIN_ARG_INTMAX:
+            value = va_arg(args, intmax_t);
+            break;
+        case RL_LOG_BIN_ARG_PTRDIFF:
+            value = va_arg(args, ptrdiff_t);
+            break;
+        case RL_LOG_BIN_ARG_PTR:
+            value = (intptr_t)va_arg(args, void *);
+            break;
+        case RL_LOG_BIN_ARG_DOUBLE:
+            dvalue = va_arg(args, double);
+            break;
+        case RL_LOG_BIN_ARG_LDOUBLE:
+            dvalue = (double)va_arg(args, long double);
+            break;
+        case RL_LOG_BIN_ARG_STR:
+        {
+            const char *str = va_arg(args, const char *);
+            if (str == NULL)
+            {
+                str = "(null)";
+            }
+            // 字符串过长时截断到剩余空间
+            unsigned int remain = (pos + sizeof(uint16_t) < sizeof(buf)) ? sizeof(buf) - pos - sizeof(uint16_t) : 0;
+            uint16_t str_len = strnlen(str, remain);
+            if (rl_log_bin_put(buf, sizeof(buf), &pos, &str_len, sizeof(str_len)) != RL_SUCCESS ||
+                rl_log_bin_put(buf, sizeof(buf), &pos, str, str_len) != RL_SUCCESS)
+            {
+                return RL_FAILED;
+            }
+            continue;
+        }
+        default:
+            break;
+        }
+        int ret = (entry->arg_type[i] == RL_LOG_BIN_ARG_DOUBLE || entry->arg_type[i] == RL_LOG_BIN_ARG_LDOUBLE) ?
+                  rl_log_bin_put(buf, sizeof(buf), &pos, &dvalue, sizeof(dvalue)) :
+                  rl_log_bin_put(buf, sizeof(buf), &pos, &value, sizeof(value));
+        if (ret != RL_SUCCESS)
+        {
+            return RL_FAILED;
+        }
+    }
+    rec->head.len = pos;
+    return write_rl_log(level, NULL, buf, pos);
+}
+
+// 调用点限速与重复合并状态
+typedef struct
+{
+    // 调用点格式串（为 NULL 表示空槽位，只用于比较地址，调用者的缓冲区可能已经失效）
+    const char *fmt;
+    // 插入时复制的格式串（rl_log_limit_flush 输出使用）
+    char *fmt_copy;
+    unsigned char lock;
+    // 剩余令牌（单位：百万分之一条）
+    unsigned long long tokens;
+    unsigned long long last_us;
+    // 自上次输出以来被限速丢弃的条数及最近一次的日志等级
+    unsigned long long limited;
+    RL_LOG_LEVEL level;
+    // 上一条日志内容的哈希和等级
+    uint64_t last_hash;
+    RL_LOG_LEVEL last_level;
+    // 上一条日志之后被合并的重复条数及首次重复的时间
+    unsigned long long repeat;
+    unsigned long long repeat_us;
+} __attribute__((aligned(64))) RL_LOG_LIMIT_T;
+
+static RL_LOG_LIMIT_T rl_log_limit_table[RL_LOG_LIMIT_TABLE_SIZE];
+static unsigned int rl_log_limit_rate = RL_LOG_LIMIT_RATE;
+static unsigned int rl_log_limit_burst = RL_LOG_LIMIT_BURST;
+static bool rl_log_limit_collapse = RL_FALSE;
+static rl_stat_t *rl_log_stat_limited = NULL;
+static rl_stat_t *rl_log_stat_repeated = NULL;
+
+// 查找或插入调用点，表满时返回 NULL
+static RL_LOG_LIMIT_T *rl_log_limit_get(const char *fmt)
+{
+    uintptr_t key = (uintptr_t)fmt;
+    unsigned int index = (unsigned int)((key >> 3) ^ (key >> 12)) & (RL_LOG_LIMIT_TABLE_SIZE - 1);
+    for (int probe = 0; probe < 16; probe++)
+    {
+        RL_LOG_LIMIT_T *entry = &rl_log_limit_table[(index + probe) & (RL_LOG_LIMIT_TABLE_SIZE - 1)];
+        const char *cur = __atomic_load_n(&entry->fmt, __ATOMIC_ACQUIRE);
+        if (cur == fmt)
+        {
+            return entry;
+        }
+        if (cur == NULL)
+        {
+            const char *expected = NULL;
+            if (__atomic_compare_exchange_n(&entry->fmt, &expected, fmt, RL_FALSE, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE))
+            {
+                __atomic_store_n(&entry->fmt_copy, strdup(fmt), __ATOMIC_RELEASE);
+                return entry;
+            }
+            if (expected == fmt)
+            {
+                return entry;
+            }
+        }
+    }
+    return NULL;
+}
 
-// 写入日志函数
-static int write_rl_log(RL_LOG_LEVEL level,const char *message)
+static void rl_log_limit_lock(RL_LOG_LIMIT_T *entry)
 {
-    // 检查文件状态
-    if (log_file_fd == -1)
+    while (__atomic_test_and_set(&entry->lock, __ATOMIC_ACQUIRE))
     {
-        char err_msg[128] = {0};
-        snprintf(err_msg, sizeof(err_msg), "[rllog:write_rl_log:24] Failed to open:%s", RL_LOG_FILE_DIR);
-        perror(err_msg);
-        return RL_FAILED;
+        sched_yield();
     }
+}
 
-    // 格式化日志内容
-    int log_len = 0;
-    char log_buf[RL_LOG_BUF_SIZE + 64] = {0};
-    if (level != RL_LOG_LEVEL_NORMAL)
+static void rl_log_limit_unlock(RL_LOG_LIMIT_T *entry)
+{
+    __atomic_clear(&entry->lock, __ATOMIC_RELEASE);
+}
+
+// 令牌桶：有令牌时返回 RL_TRUE 并通过 limited 取出之前被丢弃的条数（调用者需持有 entry->lock）
+static bool rl_log_limit_take(RL_LOG_LIMIT_T *entry, RL_LOG_LEVEL level, unsigned long long now_us, unsigned long long *limited)
+{
+    entry->level = level;
+    unsigned int rate = __atomic_load_n(&rl_log_limit_rate, __ATOMIC_RELAXED);
+    if (rate == 0)
     {
-        // 更新时间
-        time_t time_now;
-        time(&time_now);
-        struct tm time_info;
-        localtime_r(&time_now, &time_info);
-        // 获取线程号
-        int tid_now = syscall(SYS_gettid);
-        log_len = snprintf(log_buf, sizeof(log_buf),
-                            "%02d:%02d:%02d-%s-p%d-t%d %s:%s\n",
-                            time_info.tm_hour, time_info.tm_min, time_info.tm_sec,
-                            proc_name, pid_now, tid_now,
-                            (level == RL_LOG_LEVEL_ERROR) ? "error" :
-                            (level == RL_LOG_LEVEL_WARN) ? "warn" :
-                            (level == RL_LOG_LEVEL_INFO) ? "info": "debug",
-                            message);
+        return RL_TRUE;
+    }
+    unsigned long long cap = (unsigned long long)__atomic_load_n(&rl_log_limit_burst, __ATOMIC_RELAXED) * 1000000ULL;
+    unsigned long long elapsed = now_us - entry->last_us;
+    if (entry->last_us == 0 || elapsed >= cap / rate)
+    {
+        entry->tokens = cap;
     }
     else
     {
-        log_len = snprintf(log_buf, sizeof(log_buf), "%s", message);
+        entry->tokens += elapsed * rate;
+        if (entry->tokens > cap)
+        {
+            entry->tokens = cap;
+        }
+    }
+    entry->last_us = now_us;
+    if (entry->tokens < 1000000ULL)
+    {
+        entry->limited++;
+        return RL_FALSE;
+    }
+    entry->tokens -= 1000000ULL;
+    *limited = entry->limited;
+    entry->limited = 0;
+    return RL_TRUE;
+}
+
+// 输出一条日志（二进制模式下不格式化）
+static int rl_log_emit(RL_LOG_LEVEL level, const char *fmt, va_list args)
+{
+    if (__atomic_load_n(&rl_log_binary_state, __ATOMIC_ACQUIRE) == RL_TRUE)
+    {
+        return rl_log_bin_write(level, fmt, args);
     }
-    if (log_len < 0)
+    char buf[RL_LOG_BUF_SIZE];
+    int len = vsnprintf(buf, sizeof(buf), fmt, args);
+    if (len < 0 || len >= RL_LOG_BUF_SIZE)
     {
         char err_msg[128] = {0};
-        snprintf(err_msg, sizeof(err_msg), "[rllog:write_rl_log:48] Failed to write rl_log in:%s", RL_LOG_FILE_DIR);
+        snprintf(err_msg, sizeof(err_msg), "[rllog:%s:%d] Log message truncated or encoding error", __FUNCTION__, __LINE__);
         perror(err_msg);
         return RL_FAILED;
     }
+    return write_rl_log(level, buf, NULL, 0);
+}
 
-    // 加锁
-    pthread_mutex_lock(&rl_log_mutex);
-    // 检查日志文件大小
-    struct stat st;
-    // 超过 RL_LOG_FILE_SIZE KB 则清空文件后再写入
-    if (stat(RL_LOG_FILE_DIR, &st) == 0 && st.st_size > RL_LOG_FILE_SIZE)
+static int rl_log_emitf(RL_LOG_LEVEL level, const char *fmt, ...) __attribute__((format(printf, 2, 3)));
+static int rl_log_emitf(RL_LOG_LEVEL level, const char *fmt, ...)
+{
+    va_list arg;
+    va_start(arg, fmt);
+    int ret = rl_log_emit(level, fmt, arg);
+    va_end(arg);
+    return ret;
+}
+
+// 输出所有调用点中尚未输出的重复/限速计数（rl_log_deint 时调用）
+static void rl_log_limit_flush()
+{
+    for (int i = 0; i < RL_LOG_LIMIT_TABLE_SIZE; i++)
     {
-        // 清空文件内容
-        if (ftruncate(log_file_fd, 0) == -1)
+        RL_LOG_LIMIT_T *entry = &rl_log_limit_table[i];
+        if (__atomic_load_n(&entry->fmt, __ATOMIC_ACQUIRE) == NULL)
         {
-            char err_msg[128] = {0};
-            snprintf(err_msg, sizeof(err_msg), "[rllog:write_rl_log:63] Failed to clear:%s", RL_LOG_FILE_DIR);
-            perror(err_msg);
-            // 解锁
-            pthread_mutex_unlock(&rl_log_mutex);
-            return RL_FAILED;
+            continue;
         }
-        // 将文件指针移动到文件开头
-        if (lseek(log_file_fd, 0, SEEK_SET) == -1)
+        rl_log_limit_lock(entry);
+        unsigned long long repeat = entry->repeat;
+        unsigned long long limited = entry->limited;
+        RL_LOG_LEVEL level = entry->level;
+        entry->repeat = 0;
+        entry->limited = 0;
+        rl_log_limit_unlock(entry);
+        // 复制失败（内存不足）时不输出格式串
+        const char *fmt = __atomic_load_n(&entry->fmt_copy, __ATOMIC_ACQUIRE);
+        if (fmt == NULL)
         {
-            char err_msg[128] = {0};
-            snprintf(err_msg, sizeof(err_msg), "[rllog:write_rl_log:73] Failed to reset pointer:%s", RL_LOG_FILE_DIR);
-            perror(err_msg);
-            // 解锁
-            pthread_mutex_unlock(&rl_log_mutex);
-            return RL_FAILED;
+            fmt = "";
+        }
+        if (repeat > 0)
+        {
+            rl_log_emitf(level, "last message repeated %llu times: %s", repeat, fmt);
+        }
+        if (limited > 0)
+        {
+            rl_log_emitf(level, "%llu messages suppressed by rate limit: %s", limited, fmt);
         }
     }
-    // log 写入文件
-    ssize_t bytes_written = 0;
-    while (bytes_written < log_len)
+}
+
+// 开启异步日志（在 rl_log_init 之后调用）
+int rl_log_async_enable(unsigned int slot_count, RL_LOG_OVERFLOW_POLICY policy)
+{
+    if (log_file_fd == -1)
     {
-        ssize_t ret = write(log_file_fd, log_buf + bytes_written, log_len - bytes_written);
-        if (ret == -1)
+        char err_msg[128] = {0};
+        snprintf(err_msg, sizeof(err_msg), "[rllog:%s:%d] log not init", __FUNCTION__, __LINE__);
+        perror(err_msg);
+        return RL_FAILED;
+    }
+    if (rl_log_async_state == RL_TRUE)
+    {
+        return RL_SUCCESS;
+    }
+    if (rl_log_staged_state == RL_TRUE || rl_log_mmap_state == RL_TRUE)
+    {
+        char err_msg[128] = {0};
+        snprintf(err_msg, sizeof(err_msg), "[rllog:%s:%d] staged or mmap mode already enabled", __FUNCTION__, __LINE__);
+        perror(err_msg);
+        return RL_FAILED;
+    }
+    if (slot_count == 0)
+    {
+        slot_count = RL_LOG_ASYNC_SLOT_COUNT;
+    }
+    // 槽位数量必须为 2 的幂
+    if ((slot_count & (slot_count - 1)) != 0)
+    {
+        char err_msg[128] = {0};
+        snprintf(err_msg, sizeof(err_msg), "[rllog:%s:%d] slot_count=%u must be power of 2", __FUNCTION__, __LINE__, slot_count);
+        perror(err_msg);
+        return RL_FAILED;
+    }
+    RL_LOG_RING_T *ring = &rl_log_ring;
+    // fork 出的子进程中残留父进程的缓冲区（关闭异步模式后为 NULL）
+    free(ring->slots);
+    ring->slots = (RL_LOG_SLOT_T *)malloc(sizeof(RL_LOG_SLOT_T) * slot_count);
+    if (ring->slots == NULL)
+    {
+        char err_msg[128] = {0};
+        snprintf(err_msg, sizeof(err_msg), "[rllog:%s:%d] malloc ring slots failed", __FUNCTION__, __LINE__);
+        perror(err_msg);
+        return RL_FAILED;
+    }
+    for (unsigned int i = 0; i < slot_count; i++)
+    {
+        ring->slots[i].seq = i;
+    }
+    ring->mask = slot_count - 1;
+    ring->enqueue_pos = 0;
+    ring->dequeue_pos = 0;
+    ring->inflight = 0;
+    ring->policy = policy;
+    ring->dropped = 0;
+    ring->sleeping = 0;
+    pthread_mutex_init(&ring->wait_mutex, NULL);
+    pthread_cond_init(&ring->wait_cond, NULL);
+    // 先开启状态再创建写线程，避免写线程启动后立即退出
+    __atomic_store_n(&rl_log_async_state, RL_TRUE, __ATOMIC_RELEASE);
+    if (pthread_create(&ring->writer, NULL, rl_log_async_writer, NULL) != 0)
+    {
+        __atomic_store_n(&rl_log_async_state, RL_FALSE, __ATOMIC_RELEASE);
+        pthread_mutex_destroy(&ring->wait_mutex);
+        pthread_cond_destroy(&ring->wait_cond);
+        free(ring->slots);
+        ring->slots = NULL;
+        char err_msg[128] = {0};
+        snprintf(err_msg, sizeof(err_msg), "[rllog:%s:%d] create async writer thread failed", __FUNCTION__, __LINE__);
+        perror(err_msg);
+        return RL_FAILED;
+    }
+    return RL_SUCCESS;
+}
+
+// 获取异步模式下因缓冲区满而丢弃的日志条数
+unsigned long long rl_log_async_dropped()
+{
+    return __atomic_load_n(&rl_log_ring.dropped, __ATOMIC_RELAXED);
+}
+
+// 配置日志轮转
+int rl_log_rotate_config(unsigned int keep_count, bool compress)
+{
+    pthread_mutex_lock(&rl_log_mutex);
+    rl_log_rotate_keep = keep_count;
+    rl_log_rotate_compress = compress;
+    pthread_mutex_unlock(&rl_log_mutex);
+    return RL_SUCCESS;
+}
+
+// 开启二进制日志模式（在 rl_log_init 之后调用）
+int rl_log_binary_enable()
+{
+    if (log_file_fd == -1)
+    {
+        char err_msg[128] = {0};
+        snprintf(err_msg, sizeof(err_msg), "[rllog:%s:%d] log not init", __FUNCTION__, __LINE__);
+        perror(err_msg);
+        return RL_FAILED;
+    }
+    pthread_mutex_lock(&rl_log_mutex);
+    if (rl_log_binary_state == RL_TRUE)
+    {
+        pthread_mutex_unlock(&rl_log_mutex);
+        return RL_SUCCESS;
+    }
+    const char *path = log_file_path;
+    log_file_base = RL_LOG_BIN_FILE_DIR;
+    log_file_path = RL_LOG_BIN_FILE_DIR;
+    int fd = rl_log_file_open();
+    if (fd == -1)
+    {
+        char err_msg[128] = {0};
+        snprintf(err_msg, sizeof(err_msg), "[rllog:%s:%d] Failed to open:%s", __FUNCTION__, __LINE__, log_file_path);
+        perror(err_msg);
+        log_file_base = RL_LOG_FILE_DIR;
+        log_file_path = path;
+        pthread_mutex_unlock(&rl_log_mutex);
+        return RL_FAILED;
+    }
+    // 切换到二进制日志文件，写入会话记录后再开始编码日志
+    close(log_file_fd);
+    log_file_fd = fd;
+    rl_log_binary_state = RL_TRUE;
+    int ret = rl_log_file_seed();
+    pthread_mutex_unlock(&rl_log_mutex);
+    return ret;
+}
+
+// 开启内存映射模式（在 rl_log_init 之后调用，与异步/暂存模式互斥）
+int rl_log_mmap_enable(unsigned int sync_interval_ms)
+{
+    if (log_file_fd == -1)
+    {
+        char err_msg[128] = {0};
+        snprintf(err_msg, sizeof(err_msg), "[rllog:%s:%d] log not init", __FUNCTION__, __LINE__);
+        perror(err_msg);
+        return RL_FAILED;
+    }
+    if (rl_log_mmap_state == RL_TRUE)
+    {
+        return RL_SUCCESS;
+    }
+    if (rl_log_async_state == RL_TRUE || rl_log_staged_state == RL_TRUE)
+    {
+        char err_msg[128] = {0};
+        snprintf(err_msg, sizeof(err_msg), "[rllog:%s:%d] async or staged mode already enabled", __FUNCTION__, __LINE__);
+        perror(err_msg);
+        return RL_FAILED;
+    }
+    rl_log_mmap_sync_ms = (sync_interval_ms == 0) ? RL_LOG_MMAP_SYNC_MS : sync_interval_ms;
+    pthread_mutex_lock(&rl_log_mutex);
+    // 独占日志文件：其他进程追加的内容会落在预分配空间之后，被本进程截断
+    if (flock(log_file_fd, LOCK_EX | LOCK_NB) == -1)
+    {
+        // 锁转换不是原子的，失败时可能已经释放了原来的共享锁
+        flock(log_file_fd, LOCK_SH | LOCK_NB);
+        pthread_mutex_unlock(&rl_log_mutex);
+        char err_msg[128] = {0};
+        snprintf(err_msg, sizeof(err_msg), "[rllog:%s:%d] log file in use by other process:%s", __FUNCTION__, __LINE__, log_file_path);
+        perror(err_msg);
+        return RL_FAILED;
+    }
+    // 之后轮转打开的新文件同样加排他锁
+    log_file_lock = LOCK_EX;
+    // 已独占文件，末尾的 '\0' 只可能是上次内存映射模式异常退出时残留的预分配空间
+    rl_log_file_trim_tail();
+    // 当前文件已满则先轮转
+    if (log_file_bytes > RL_LOG_FILE_SIZE)
+    {
+        rl_log_rotate_locked();
+    }
+    unsigned int gen = (rl_log_mmap_pos >> RL_LOG_MMAP_GEN_SHIFT) + 1;
+    long long start = rl_log_mmap_map_locked(&rl_log_mmap_seg[gen & 1]);
+    if (start < 0)
+    {
+        log_file_lock = LOCK_SH;
+        flock(log_file_fd, LOCK_SH);
+        pthread_mutex_unlock(&rl_log_mutex);
+        return RL_FAILED;
+    }
+    __atomic_store_n(&rl_log_mmap_pos, ((unsigned long long)gen << RL_LOG_MMAP_GEN_SHIFT) | start, __ATOMIC_RELEASE);
+    __atomic_store_n(&rl_log_mmap_state, RL_TRUE, __ATOMIC_RELEASE);
+    pthread_mutex_unlock(&rl_log_mutex);
+    if (pthread_create(&rl_log_mmap_syncer, NULL, rl_log_mmap_syncer_thread, NULL) != 0)
+    {
+        char err_msg[128] = {0};
+        snprintf(err_msg, sizeof(err_msg), "[rllog:%s:%d] create mmap sync thread failed", __FUNCTION__, __LINE__);
+        perror(err_msg);
+        // 没有定时落盘线程时仍可使用，只是依赖 ERROR 日志和 rl_log_deint 落盘
+    }
+    return RL_SUCCESS;
+}
+
+// 开启线程暂存模式（在 rl_log_init 之后调用，与异步模式互斥）
+int rl_log_staged_enable(unsigned int flush_interval_ms)
+{
+    if (log_file_fd == -1)
+    {
+        char err_msg[128] = {0};
+        snprintf(err_msg, sizeof(err_msg), "[rllog:%s:%d] log not init", __FUNCTION__, __LINE__);
+        perror(err_msg);
+        return RL_FAILED;
+    }
+    if (rl_log_staged_state == RL_TRUE)
+    {
+        return RL_SUCCESS;
+    }
+    if (rl_log_async_state == RL_TRUE || rl_log_mmap_state == RL_TRUE)
+    {
+        char err_msg[128] = {0};
+        snprintf(err_msg, sizeof(err_msg), "[rllog:%s:%d] async or mmap mode already enabled", __FUNCTION__, __LINE__);
+        perror(err_msg);
+        return RL_FAILED;
+    }
+    pthread_once(&rl_log_stage_key_once, rl_log_stage_key_create);
+    rl_log_stage_interval_ms = (flush_interval_ms == 0) ? RL_LOG_STAGE_FLUSH_MS : flush_interval_ms;
+    __atomic_store_n(&rl_log_staged_state, RL_TRUE, __ATOMIC_RELEASE);
+    if (pthread_create(&rl_log_stage_flusher, NULL, rl_log_stage_flusher_thread, NULL) != 0)
+    {
+        __atomic_store_n(&rl_log_staged_state, RL_FALSE, __ATOMIC_RELEASE);
+        char err_msg[128] = {0};
+        snprintf(err_msg, sizeof(err_msg), "[rllog:%s:%d] create stage flusher thread failed", __FUNCTION__, __LINE__);
+        perror(err_msg);
+        return RL_FAILED;
+    }
+    return RL_SUCCESS;
+}
+
+// fork 后子进程刷新进程号和线程号缓存
+static void rl_log_atfork_child()
+{
+    pid_now = getpid();
+    rl_log_proc_prefix_len = snprintf(rl_log_proc_prefix, sizeof(rl_log_proc_prefix), "-%s-p%d-t", proc_name, pid_now);
+    rl_log_tid_cache = 0;
+    // 子进程首次写入时重新打开日志文件（父进程处于内存映射模式时改为写入 <文件名>.<进程号>）
+    log_file_lock = LOCK_SH;
+    // 子进程中没有异步写线程和暂存刷新线程，退回同步写入；缓冲区中父进程的日志由父进程写入
+    // 环形缓冲区在子进程重新开启异步模式时释放
+    rl_log_async_state = RL_FALSE;
+    rl_log_ring.inflight = 0;
+    rl_log_staged_state = RL_FALSE;
+    rl_log_stage_inflight = 0;
+    pthread_mutex_init(&rl_log_stage_list_mutex, NULL);
+    for (RL_LOG_STAGE_T *stage = rl_log_stage_list; stage != NULL; stage = stage->next)
+    {
+        pthread_mutex_init(&stage->lock, NULL);
+        stage->len = 0;
+    }
+    // 子进程不共享父进程的写入偏移，放弃映射区改为同步写入（文件由父进程负责截断）
+    if (rl_log_mmap_state == RL_TRUE)
+    {
+        rl_log_mmap_state = RL_FALSE;
+        for (int i = 0; i < 2; i++)
         {
-            char err_msg[128] = {0};
-            snprintf(err_msg, sizeof(err_msg), "[rllog:write_rl_log:88] Failed to write log:%s", RL_LOG_FILE_DIR);
-            perror(err_msg);
-            // 解锁
-            pthread_mutex_unlock(&rl_log_mutex);
-            return RL_FAILED;
+            if (rl_log_mmap_seg[i].base != NULL)
+            {
+                munmap(rl_log_mmap_seg[i].base, rl_log_mmap_seg[i].size);
+                rl_log_mmap_seg[i].base = NULL;
+            }
         }
-        bytes_written += ret;
     }
-    // 解锁
-    pthread_mutex_unlock(&rl_log_mutex);
+}
+
+static void rl_log_register_atfork()
+{
+    pthread_atfork(NULL, NULL, rl_log_atfork_child);
+}
+
+// 运行时修改日志等级
+int rl_log_set_level(RL_LOG_LEVEL level)
+{
+    if (level < RL_LOG_LEVEL_NORMAL || level > RL_LOG_LEVEL_DEBUG)
+    {
+        char err_msg[128] = {0};
+        snprintf(err_msg, sizeof(err_msg), "[rllog:%s:%d] level=%d invalid", __FUNCTION__, __LINE__, level);
+        perror(err_msg);
+        return RL_FAILED;
+    }
+    __atomic_store_n(&rl_log_cur_level, level, __ATOMIC_RELAXED);
+    return RL_SUCCESS;
+}
+
+// 获取当前运行时日志等级
+RL_LOG_LEVEL rl_log_get_level()
+{
+    return __atomic_load_n(&rl_log_cur_level, __ATOMIC_RELAXED);
+}
+
+// 配置调用点限速和重复日志合并
+int rl_log_limit_config(unsigned int rate, unsigned int burst, bool collapse)
+{
+    if (burst == 0)
+    {
+        burst = (RL_LOG_LIMIT_BURST != 0) ? RL_LOG_LIMIT_BURST : rate;
+    }
+    __atomic_store_n(&rl_log_limit_burst, burst, __ATOMIC_RELAXED);
+    __atomic_store_n(&rl_log_limit_rate, rate, __ATOMIC_RELAXED);
+    __atomic_store_n(&rl_log_limit_collapse, collapse, __ATOMIC_RELAXED);
+    return RL_SUCCESS;
+}
+
+// 获取日志统计信息
+int rl_log_get_stats(RL_LOG_STATS_T *stats)
+{
+    if (stats == NULL)
+    {
+        return RL_FAILED;
+    }
+    stats->written = rl_stat_get(rl_log_stat_written);
+    stats->dropped = rl_log_async_dropped();
+    stats->rate_limited = rl_stat_get(rl_log_stat_limited);
+    stats->repeated = rl_stat_get(rl_log_stat_repeated);
+    stats->rotated = rl_stat_get(rl_log_stat_rotated);
+    return RL_SUCCESS;
+}
+
+// 设置日志头时间戳精度
+int rl_log_set_time_precision(RL_LOG_TIME_PRECISION precision)
+{
+    if (precision != RL_LOG_TIME_SEC && precision != RL_LOG_TIME_MS && precision != RL_LOG_TIME_US)
+    {
+        char err_msg[128] = {0};
+        snprintf(err_msg, sizeof(err_msg), "[rllog:%s:%d] precision=%d invalid", __FUNCTION__, __LINE__, precision);
+        perror(err_msg);
+        return RL_FAILED;
+    }
+    __atomic_store_n(&rl_log_time_precision, precision, __ATOMIC_RELAXED);
     return RL_SUCCESS;
 }
 
 // 仅允许在main.cpp中使用
+// 登记日志统计指标
+static void rl_log_stat_register()
+{
+    rl_log_stat_written = rl_stat_register("rllog.written", RL_STAT_COUNTER);
+    rl_log_stat_rotated = rl_stat_register("rllog.rotated", RL_STAT_COUNTER);
+    rl_log_stat_dropped = rl_stat_register("rllog.dropped", RL_STAT_COUNTER);
+    rl_log_stat_limited = rl_stat_register("rllog.rate_limited", RL_STAT_COUNTER);
+    rl_log_stat_repeated = rl_stat_register("rllog.repeated", RL_STAT_COUNTER);
+}
+
 int rl_log_init(RL_LOG_LEVEL level)
 {
     // 初始化lod等级
-    cur_rl_log_level = level;
+    __atomic_store_n(&rl_log_cur_level, level, __ATOMIC_RELAXED);
     // 只读打开 /proc/self/comm 文件以获取进程名称
     FILE *proc_file = fopen("/proc/self/comm", "r");
     if (!proc_file)
@@ -131,15 +2327,36 @@ int rl_log_init(RL_LOG_LEVEL level)
     fclose(proc_file);
     // 获取进程pid
     pid_now = getpid();
-    // O_WRONLY（只写）| O_CREAT（创建文件）| O_APPEND（追加模式）| 拥有者可以读写，其他人只能读
-    log_file_fd = open(RL_LOG_FILE_DIR, O_WRONLY | O_CREAT | O_APPEND, 0644);
+    // 生成日志头中固定不变的部分
+    rl_log_proc_prefix_len = snprintf(rl_log_proc_prefix, sizeof(rl_log_proc_prefix), "-%s-p%d-t", proc_name, pid_now);
+    // fork 后子进程需要重新获取进程号和线程号
+    static pthread_once_t atfork_once = PTHREAD_ONCE_INIT;
+    pthread_once(&atfork_once, rl_log_register_atfork);
+    static pthread_once_t stat_once = PTHREAD_ONCE_INIT;
+    pthread_once(&stat_once, rl_log_stat_register);
+    // 二进制日志会话编号
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    rl_log_bin_session = (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+    // O_WRONLY（只写）| O_CREAT（创建文件）| O_APPEND（追加模式）| O_CLOEXEC（不传给 exec 的子进程，例如轮转时的 gzip）| 拥有者可以读写，其他人只能读
+    log_file_base = RL_LOG_FILE_DIR;
+    log_file_path = RL_LOG_FILE_DIR;
+    log_file_lock = LOCK_SH;
+    log_file_fd = rl_log_file_open();
     if (log_file_fd == -1)
     {
         char err_msg[128] = {0};
-        snprintf(err_msg, sizeof(err_msg), "[rllog:rl_log_init:128] Failed to open:%s", RL_LOG_FILE_DIR);
+        snprintf(err_msg, sizeof(err_msg), "[rllog:rl_log_init:128] Failed to open:%s", log_file_path);
         perror(err_msg);
         return RL_FAILED;
     }
+    // 记录当前文件大小，之后由写入计数维护，不再逐条 stat
+    if (rl_log_file_seed() != RL_SUCCESS)
+    {
+        close(log_file_fd);
+        log_file_fd = -1;
+        return RL_FAILED;
+    }
     return RL_SUCCESS;
 }
 
@@ -152,6 +2369,18 @@ int rl_log_deint()
     }
     else
     {
+        // 输出尚未输出的重复/限速计数
+        rl_log_limit_flush();
+        // 写完异步缓冲区中的日志
+        rl_log_async_disable();
+        // 刷新所有线程的暂存缓冲区
+        rl_log_staged_disable();
+        // 映射区落盘并截掉预分配的空间
+        rl_log_mmap_disable();
+        // 等待后台轮转完成
+        rl_log_rotate_stop();
+        // 之后重新初始化时恢复文本日志
+        rl_log_bin_reset();
         // 强制将文件数据同步到磁盘后关闭
         if (fsync(log_file_fd) == -1 || close(log_file_fd) == -1)
         {
@@ -166,24 +2395,118 @@ int rl_log_deint()
 // 通用日志函数
 static int rl_log_generic(RL_LOG_LEVEL level, const char *fmt, va_list args)
 {
-    if (cur_rl_log_level < level)
+    // 等级未开启不算失败
+    if (__atomic_load_n(&rl_log_cur_level, __ATOMIC_RELAXED) < level)
     {
-        return RL_FAILED;
+        return RL_SUCCESS;
     }
-    char buf[RL_LOG_BUF_SIZE];
-    int len = vsnprintf(buf, sizeof(buf), fmt, args);
-    if (len < 0 || len >= RL_LOG_BUF_SIZE)
+    // NORMAL 为原样输出的内容，不限速也不合并
+    RL_LOG_LIMIT_T *entry = NULL;
+    unsigned long long now_us = 0;
+    unsigned long long limited = 0;
+    if (level != RL_LOG_LEVEL_NORMAL &&
+        (__atomic_load_n(&rl_log_limit_rate, __ATOMIC_RELAXED) != 0 || __atomic_load_n(&rl_log_limit_collapse, __ATOMIC_RELAXED) == RL_TRUE))
     {
-        perror("[rllog:rl_log_generic:166] Log message truncated or encoding error");
-        return RL_FAILED;
+        entry = rl_log_limit_get(fmt);
+    }
+    if (entry != NULL)
+    {
+        now_us = rl_log_monotonic_us();
+        rl_log_limit_lock(entry);
+        bool pass = rl_log_limit_take(entry, level, now_us, &limited);
+        rl_log_limit_unlock(entry);
+        if (pass == RL_FALSE)
+        {
+            rl_stat_add(rl_log_stat_limited, 1);
+            return RL_SUCCESS;
+        }
+    }
+
+    int ret = RL_FAILED;
+    // 二进制模式：不在设备上格式化，因此不做重复合并
+    if (__atomic_load_n(&rl_log_binary_state, __ATOMIC_ACQUIRE) == RL_TRUE)
+    {
+        if (limited > 0)
+        {
+            rl_log_emitf(level, "%llu messages suppressed by rate limit: %s", limited, fmt);
+        }
+        ret = rl_log_bin_write(level, fmt, args);
+    }
+    else
+    {
+        char buf[RL_LOG_BUF_SIZE];
+        int len = vsnprintf(buf, sizeof(buf), fmt, args);
+        if (len < 0 || len >= RL_LOG_BUF_SIZE)
+        {
+            perror("[rllog:rl_log_generic:166] Log message truncated or encoding error");
+            return RL_FAILED;
+        }
+        unsigned long long repeat = 0;
+        if (entry != NULL && __atomic_load_n(&rl_log_limit_collapse, __ATOMIC_RELAXED) == RL_TRUE)
+        {
+            uint64_t hash = rl_log_bin_hash(buf);
+            RL_LOG_LEVEL last_level;
+            bool same;
+            rl_log_limit_lock(entry);
+            last_level = entry->last_level;
+            same = (entry->last_hash == hash && last_level == level);
+            if (same)
+            {
+                if (entry->repeat++ == 0)
+                {
+                    entry->repeat_us = now_us;
+                }
+                // 重复持续太久则先输出一次计数
+                if (now_us - entry->repeat_us >= RL_LOG_REPEAT_FLUSH_MS * 1000ULL)
+                {
+                    repeat = entry->repeat;
+                    entry->repeat = 0;
+                }
+            }
+            else
+            {
+                repeat = entry->repeat;
+                entry->repeat = 0;
+                entry->last_hash = hash;
+                entry->last_level = level;
+            }
+            rl_log_limit_unlock(entry);
+            if (repeat > 0)
+            {
+                rl_log_emitf(last_level, "last message repeated %llu times", repeat);
+            }
+            if (same)
+            {
+                rl_stat_add(rl_log_stat_repeated, 1);
+                if (limited > 0)
+                {
+                    // 限速计数归还给调用点，等下一条不同的日志再输出
+                    rl_log_limit_lock(entry);
+                    entry->limited += limited;
+                    rl_log_limit_unlock(entry);
+                }
+                return RL_SUCCESS;
+            }
+        }
+        if (limited > 0)
+        {
+            rl_log_emitf(level, "%llu messages suppressed by rate limit: %s", limited, fmt);
+        }
+        ret = write_rl_log(level, buf, NULL, 0);
+    }
+    // 已计入丢弃的条数
+    if (ret == RL_LOG_DROPPED)
+    {
+        return RL_SUCCESS;
     }
-    if (write_rl_log(level, buf) != RL_SUCCESS)
+    if (ret != RL_SUCCESS)
     {
         char err_msg[128] = {0};
-        snprintf(err_msg, sizeof(err_msg), "[rllog:rl_log_generic:172] Failed to write log in:%s", RL_LOG_FILE_DIR);
+        snprintf(err_msg, sizeof(err_msg), "[rllog:rl_log_generic:172] Failed to write log in:%s", log_file_path);
         perror(err_msg);
         return RL_FAILED;
     }
+    rl_stat_add(rl_log_stat_written, 1);
     return RL_SUCCESS;
 }
 
@@ -0,0 +1,549 @@
+// rllog 二进制日志解码工具（主机端使用）
+// 编译：gcc -O2 -o rllog_decode rllog_decode.c
+// 用法：rllog_decode [-s] [-u] file1 [file2 ...]
+//   -s  按单调时间戳排序输出（线程暂存模式下恢复跨线程顺序）
+//   -u  时间显示到微秒
+// 轮转后的历史文件按从旧到新的顺序传入（例如 Messages.bin.2 Messages.bin.1 Messages.bin），压缩文件需先 gunzip
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+#include <unistd.h>
+
+// 以下定义与 rllog.c 保持一致
+typedef struct
+{
+    uint16_t magic;
+    uint8_t type;
+    uint8_t level;
+    uint32_t len;
+} __attribute__((packed)) RL_LOG_BIN_HEAD_T;
+
+typedef struct
+{
+    RL_LOG_BIN_HEAD_T head;
+    uint32_t version;
+    uint32_t pid;
+    uint8_t long_size;
+    uint8_t reserved[3];
+    uint64_t session;
+    char proc_name[16];
+} __attribute__((packed)) RL_LOG_BIN_SESSION_T;
+
+typedef struct
+{
+    RL_LOG_BIN_HEAD_T head;
+    uint64_t time_ns;
+    uint64_t mono_us;
+    uint32_t tid;
+    uint32_t fmt_id;
+} __attribute__((packed)) RL_LOG_BIN_RECORD_T;
+
+#define RL_LOG_BIN_MAGIC            0x4C52
+#define RL_LOG_BIN_TYPE_SESSION     1
+#define RL_LOG_BIN_TYPE_FORMAT      2
+#define RL_LOG_BIN_TYPE_RECORD      3
+#define RL_LOG_BIN_TYPE_TEXT        4
+
+// 单条解码后日志的最大长度
+#define DECODE_LINE_SIZE    4096
+
+// 会话
+typedef struct
+{
+    uint64_t session;
+    uint32_t pid;
+    uint8_t long_size;
+    char proc_name[17];
+} SESSION_T;
+
+// 格式串登记
+typedef struct
+{
+    int session;
+    uint32_t id;
+    const char *fmt;
+} FORMAT_T;
+
+// 待输出的日志（-s 排序时使用）
+typedef struct
+{
+    int session;
+    uint64_t mono_us;
+    size_t order;
+    char *line;
+} LINE_T;
+
+static SESSION_T *sessions = NULL;
+static int session_count = 0;
+static FORMAT_T *formats = NULL;
+static size_t format_count = 0;
+static int format_sorted = 0;
+static LINE_T *lines = NULL;
+static size_t line_count = 0;
+static int opt_sort = 0;
+static int opt_usec = 0;
+
+static void *xrealloc(void *ptr, size_t size)
+{
+    void *p = realloc(ptr, size);
+    if (p == NULL)
+    {
+        perror("realloc");
+        exit(EXIT_FAILURE);
+    }
+    return p;
+}
+
+// 读取整个文件
+static char *read_file(const char *path, size_t *len)
+{
+    FILE *fp = fopen(path, "rb");
+    if (fp == NULL)
+    {
+        perror(path);
+        return NULL;
+    }
+    size_t cap = 1 << 20;
+    size_t used = 0;
+    char *buf = xrealloc(NULL, cap);
+    size_t n;
+    while ((n = fread(buf + used, 1, cap - used, fp)) > 0)
+    {
+        used += n;
+        if (used == cap)
+        {
+            cap *= 2;
+            buf = xrealloc(buf, cap);
+        }
+    }
+    fclose(fp);
+    *len = used;
+    return buf;
+}
+
+// 查找或新增会话
+static int find_session(const RL_LOG_BIN_SESSION_T *s)
+{
+    for (int i = 0; i < session_count; i++)
+    {
+        if (sessions[i].session == s->session && sessions[i].pid == s->pid)
+        {
+            return i;
+        }
+    }
+    sessions = xrealloc(sessions, sizeof(SESSION_T) * (session_count + 1));
+    SESSION_T *cur = &sessions[session_count];
+    cur->session = s->session;
+    cur->pid = s->pid;
+    cur->long_size = s->long_size;
+    memcpy(cur->proc_name, s->proc_name, 16);
+    cur->proc_name[16] = '\0';
+    return session_count++;
+}
+
+static int format_cmp(const void *a, const void *b)
+{
+    const FORMAT_T *fa = (const FORMAT_T *)a;
+    const FORMAT_T *fb = (const FORMAT_T *)b;
+    if (fa->session != fb->session)
+    {
+        return (fa->session < fb->session) ? -1 : 1;
+    }
+    return (fa->id < fb->id) ? -1 : (fa->id > fb->id);
+}
+
+static const char *find_format(int session, uint32_t id)
+{
+    // 收集完成后已排序，使用二分查找
+    if (format_sorted != 0)
+    {
+        FORMAT_T key = {session, id, NULL};
+        FORMAT_T *found = bsearch(&key, formats, format_count, sizeof(FORMAT_T), format_cmp);
+        return (found != NULL) ? found->fmt : NULL;
+    }
+    for (size_t i = 0; i < format_count; i++)
+    {
+        if (formats[i].session == session && formats[i].id == id)
+        {
+            return formats[i].fmt;
+        }
+    }
+    return NULL;
+}
+
+// 从参数区读取定长数据
+static int take(const char **p, const char *end, void *out, size_t len)
+{
+    if (*p + len > end)
+    {
+        return -1;
+    }
+    memcpy(out, *p, len);
+    *p += len;
+    return 0;
+}
+
+// 按格式串还原日志内容
+static void decode_args(const char *fmt, const char *args, const char *end, uint8_t long_size, char *out, size_t size)
+{
+    size_t pos = 0;
+    for (const char *p = fmt; *p != '\0' && pos + 1 < size; p++)
+    {
+        if (*p != '%')
+        {
+            out[pos++] = *p;
+            continue;
+        }
+        if (p[1] == '%')
+        {
+            out[pos++] = '%';
+            p++;
+            continue;
+        }
+        // 复制标志、宽度和精度，去掉长度修饰符
+        char spec[64];
+        size_t spec_len = 0;
+        int stars[2];
+        int star_count = 0;
+        spec[spec_len++] = *p++;
+        while (*p != '\0' && strchr("-+ #0'123456789.*", *p) != NULL && spec_len < sizeof(spec) - 8)
+        {
+            if (*p == '*')
+            {
+                // 宽度和精度最多各一个 '*'，更多说明格式串已损坏
+                if (star_count == 2)
+                {
+                    goto malformed;
+                }
+                int64_t v = 0;
+                if (take(&args, end, &v, sizeof(v)) != 0)
+                {
+                    goto truncated;
+                }
+                stars[star_count++] = (int)v;
+            }
+            spec[spec_len++] = *p++;
+        }
+        int mod = 0;    // 0:无 1:hh 2:h 3:l 4:ll/q/L 5:z/j/t
+        if (*p == 'h')
+        {
+            mod = (p[1] == 'h') ? 1 : 2;
+            p += (p[1] == 'h') ? 2 : 1;
+        }
+        else if (*p == 'l')
+        {
+            mod = (p[1] == 'l') ? 4 : 3;
+            p += (p[1] == 'l') ? 2 : 1;
+        }
+        else if (*p == 'q' || *p == 'L')
+        {
+            mod = 4;
+            p++;
+        }
+        else if (*p == 'z' || *p == 'j' || *p == 't')
+        {
+            mod = 5;
+            p++;
+        }
+        char conv = *p;
+        if (conv == '\0')
+        {
+            break;
+        }
+        char tmp[DECODE_LINE_SIZE];
+        int n = 0;
+        if (strchr("diuxXo", conv) != NULL)
+        {
+            int64_t v = 0;
+            if (take(&args, end, &v, sizeof(v)) != 0)
+            {
+                goto truncated;
+            }
+            int bits = (mod == 1) ? 8 : (mod == 2) ? 16 : (mod == 0) ? 32 : (mod == 3) ? long_size * 8 : 64;
+            memcpy(spec + spec_len, "ll", 2);
+            spec[spec_len + 2] = conv;
+            spec[spec_len + 3] = '\0';
+            if (conv == 'd' || conv == 'i')
+            {
+                long long sv = (bits == 8) ? (signed char)v : (bits == 16) ? (short)v : (bits == 32) ? (int32_t)v : (long long)v;
+                n = (star_count == 0) ? snprintf(tmp, sizeof(tmp), spec, sv) :
+                    (star_count == 1) ? snprintf(tmp, sizeof(tmp), spec, stars[0], sv) :
+                    snprintf(tmp, sizeof(tmp), spec, stars[0], stars[1], sv);
+            }
+            else
+            {
+                unsigned long long uv = (bits == 8) ? (uint8_t)v : (bits == 16) ? (uint16_t)v : (bits == 32) ? (uint32_t)v : (uint64_t)v;
+                n = (star_count == 0) ? snprintf(tmp, sizeof(tmp), spec, uv) :
+                    (star_count == 1) ? snprintf(tmp, sizeof(tmp), spec, stars[0], uv) :
+                    snprintf(tmp, sizeof(tmp), spec, stars[0], stars[1], uv);
+            }
+        }
+        else if (strchr("fFeEgGaA", conv) != NULL)
+        {
+            double v = 0;
+            if (take(&args, end, &v, sizeof(v)) != 0)
+            {
+                goto truncated;
+            }
+            spec[spec_len] = conv;
+            spec[spec_len + 1] = '\0';
+            n = (star_count == 0) ? snprintf(tmp, sizeof(tmp), spec, v) :
+                (star_count == 1) ? snprintf(tmp, sizeof(tmp), spec, stars[0], v) :
+                snprintf(tmp, sizeof(tmp), spec, stars[0], stars[1], v);
+        }
+        else if (conv == 'c' || conv == 'p')
+        {
+            int64_t v = 0;
+            if (take(&args, end, &v, sizeof(v)) != 0)
+            {
+                goto truncated;
+            }
+            if (star_count == 2)
+            {
+                goto malformed;
+            }
+            spec[spec_len] = conv;
+            spec[spec_len + 1] = '\0';
+            if (conv == 'c')
+            {
+                n = (star_count == 0) ? snprintf(tmp, sizeof(tmp), spec, (int)v) :
+                    snprintf(tmp, sizeof(tmp), spec, stars[0], (int)v);
+            }
+            else
+            {
+                n = (star_count == 0) ? snprintf(tmp, sizeof(tmp), spec, (void *)(uintptr_t)v) :
+                    snprintf(tmp, sizeof(tmp), spec, stars[0], (void *)(uintptr_t)v);
+            }
+        }
+        else if (conv == 's')
+        {
+            uint16_t str_len = 0;
+            char str[65536 + 1];
+            if (take(&args, end, &str_len, sizeof(str_len)) != 0 || take(&args, end, str, str_len) != 0)
+            {
+                goto truncated;
+            }
+            str[str_len] = '\0';
+            spec[spec_len] = 's';
+            spec[spec_len + 1] = '\0';
+            n = (star_count == 0) ? snprintf(tmp, sizeof(tmp), spec, str) :
+                (star_count == 1) ? snprintf(tmp, sizeof(tmp), spec, stars[0], str) :
+                snprintf(tmp, sizeof(tmp), spec, stars[0], stars[1], str);
+        }
+        if (n < 0)
+        {
+            n = 0;
+        }
+        if ((size_t)n >= sizeof(tmp))
+        {
+            n = sizeof(tmp) - 1;
+        }
+        if (pos + n >= size)
+        {
+            n = size - 1 - pos;
+        }
+        memcpy(out + pos, tmp, n);
+        pos += n;
+    }
+    out[pos] = '\0';
+    return;
+
+truncated:
+    snprintf(out + pos, size - pos, "<truncated record>");
+    return;
+
+malformed:
+    snprintf(out + pos, size - pos, "<malformed format>");
+}
+
+// 输出或暂存一条日志
+static void emit_line(int session, uint64_t mono_us, char *line)
+{
+    if (opt_sort == 0)
+    {
+        fputs(line, stdout);
+        free(line);
+        return;
+    }
+    lines = xrealloc(lines, sizeof(LINE_T) * (line_count + 1));
+    lines[line_count].session = session;
+    lines[line_count].mono_us = mono_us;
+    lines[line_count].order = line_count;
+    lines[line_count].line = line;
+    line_count++;
+}
+
+static int line_cmp(const void *a, const void *b)
+{
+    const LINE_T *la = (const LINE_T *)a;
+    const LINE_T *lb = (const LINE_T *)b;
+    if (la->session != lb->session)
+    {
+        return (la->session < lb->session) ? -1 : 1;
+    }
+    if (la->mono_us != lb->mono_us)
+    {
+        return (la->mono_us < lb->mono_us) ? -1 : 1;
+    }
+    return (la->order < lb->order) ? -1 : (la->order > lb->order);
+}
+
+// 解码一条日志记录
+static void decode_record(int session, const RL_LOG_BIN_RECORD_T *rec, const char *payload, const char *end)
+{
+    static const char *level_str[] = {"", "error:", "warn:", "info:", "debug:"};
+    char message[DECODE_LINE_SIZE];
+    if (rec->head.type == RL_LOG_BIN_TYPE_TEXT)
+    {
+        size_t len = end - payload;
+        if (len >= sizeof(message))
+        {
+            len = sizeof(message) - 1;
+        }
+        memcpy(message, payload, len);
+        message[len] = '\0';
+    }
+    else
+    {
+        const char *fmt = (session >= 0) ? find_format(session, rec->fmt_id) : NULL;
+        if (fmt == NULL)
+        {
+            snprintf(message, sizeof(message), "<unknown format id %u>", rec->fmt_id);
+        }
+        else
+        {
+            decode_args(fmt, payload, end, (session >= 0) ? sessions[session].long_size : sizeof(long), message, sizeof(message));
+        }
+    }
+
+    char *line = xrealloc(NULL, DECODE_LINE_SIZE + 128);
+    // NORMAL 等级原样输出
+    if (rec->head.level == 0 || rec->head.level > 4)
+    {
+        snprintf(line, DECODE_LINE_SIZE + 128, "%s", message);
+    }
+    else
+    {
+        time_t sec = rec->time_ns / 1000000000ULL;
+        struct tm tm_info;
+        localtime_r(&sec, &tm_info);
+        char usec[16] = {0};
+        if (opt_usec != 0)
+        {
+            snprintf(usec, sizeof(usec), ".%06llu", (unsigned long long)(rec->time_ns % 1000000000ULL) / 1000);
+        }
+        snprintf(line, DECODE_LINE_SIZE + 128, "%02d:%02d:%02d%s-%s-p%u-t%u %s%s\n",
+                 tm_info.tm_hour, tm_info.tm_min, tm_info.tm_sec, usec,
+                 (session >= 0) ? sessions[session].proc_name : "?",
+                 (session >= 0) ? sessions[session].pid : 0,
+                 rec->tid, level_str[rec->head.level], message);
+    }
+    emit_line(session, rec->mono_us, line);
+}
+
+// 遍历一个文件，pass 为 0 时收集会话和格式串，为 1 时解码日志
+static void walk(const char *path, const char *data, size_t len, int pass)
+{
+    int session = -1;
+    size_t off = 0;
+    while (off + sizeof(RL_LOG_BIN_HEAD_T) <= len)
+    {
+        RL_LOG_BIN_HEAD_T head;
+        memcpy(&head, data + off, sizeof(head));
+        if (head.magic != RL_LOG_BIN_MAGIC || head.len < sizeof(head) || off + head.len > len)
+        {
+            if (pass == 0)
+            {
+                fprintf(stderr, "%s: corrupt record at offset %zu, resync\n", path, off);
+            }
+            off++;
+            continue;
+        }
+        const char *rec = data + off;
+        const char *end = rec + head.len;
+        if (head.type == RL_LOG_BIN_TYPE_SESSION && head.len >= sizeof(RL_LOG_BIN_SESSION_T))
+        {
+            RL_LOG_BIN_SESSION_T s;
+            memcpy(&s, rec, sizeof(s));
+            session = find_session(&s);
+        }
+        else if (head.type == RL_LOG_BIN_TYPE_FORMAT && pass == 0 && session >= 0 && head.len > sizeof(head) + sizeof(uint32_t))
+        {
+            uint32_t id;
+            memcpy(&id, rec + sizeof(head), sizeof(id));
+            if (find_format(session, id) == NULL)
+            {
+                formats = xrealloc(formats, sizeof(FORMAT_T) * (format_count + 1));
+                formats[format_count].session = session;
+                formats[format_count].id = id;
+                formats[format_count].fmt = rec + sizeof(head) + sizeof(id);
+                format_count++;
+            }
+        }
+        else if ((head.type == RL_LOG_BIN_TYPE_RECORD || head.type == RL_LOG_BIN_TYPE_TEXT) && pass == 1 &&
+                 head.len >= sizeof(RL_LOG_BIN_RECORD_T))
+        {
+            RL_LOG_BIN_RECORD_T r;
+            memcpy(&r, rec, sizeof(r));
+            decode_record(session, &r, rec + sizeof(r), end);
+        }
+        off += head.len;
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    int opt;
+    while ((opt = getopt(argc, argv, "su")) != -1)
+    {
+        if (opt == 's')
+        {
+            opt_sort = 1;
+        }
+        else if (opt == 'u')
+        {
+            opt_usec = 1;
+        }
+        else
+        {
+            fprintf(stderr, "usage: %s [-s] [-u] file...\n", argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+    if (optind >= argc)
+    {
+        fprintf(stderr, "usage: %s [-s] [-u] file...\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+    int file_count = argc - optind;
+    char **data = xrealloc(NULL, sizeof(char *) * file_count);
+    size_t *len = xrealloc(NULL, sizeof(size_t) * file_count);
+    // 先收集所有文件中的格式串，轮转前登记的格式串也能用于之后的文件
+    for (int i = 0; i < file_count; i++)
+    {
+        data[i] = read_file(argv[optind + i], &len[i]);
+        if (data[i] == NULL)
+        {
+            return EXIT_FAILURE;
+        }
+        walk(argv[optind + i], data[i], len[i], 0);
+    }
+    qsort(formats, format_count, sizeof(FORMAT_T), format_cmp);
+    format_sorted = 1;
+    for (int i = 0; i < file_count; i++)
+    {
+        walk(argv[optind + i], data[i], len[i], 1);
+    }
+    if (opt_sort != 0)
+    {
+        qsort(lines, line_count, sizeof(LINE_T), line_cmp);
+        for (size_t i = 0; i < line_count; i++)
+        {
+            fputs(lines[i].line, stdout);
+            free(lines[i].line);
+        }
+    }
+    return EXIT_SUCCESS;
+}
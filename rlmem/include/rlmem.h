@@ -5,25 +5,216 @@
 
 // 日志路径
 #define RL_MEM_TRACE_LOG_FILE_DIR   "../log/memory_trace"
+// 分配事件日志路径
+#define RL_MEM_JOURNAL_FILE_DIR     "../log/memory_journal"
+// 分配事件日志每个线程缓冲的事件数量（满一批写一次文件）
+#define RL_MEM_JOURNAL_BATCH        256
+// 内存跟踪表分片数量（必须为 2 的幂，每个分片一把锁）
+#define RL_MEM_TRACE_SHARD_COUNT    64
+// 每个分片哈希表的初始槽位数量（必须为 2 的幂，装载率超过一半时翻倍）
+#define RL_MEM_TRACE_SHARD_SIZE     256
+// 对象池每个线程缓存与共享仓库之间一次交换的对象数量（线程缓存超过 2 倍时归还一批）
+#define RL_POOL_CACHE_BATCH         32
+// 调用点（文件/函数/行号）登记表大小（必须为 2 的幂，表满后的调用点记为未知）
+#define RL_MEM_TRACE_SITE_COUNT     4096
+// 调用点分配大小直方图的桶数量（第 i 个桶统计 (8<<i, 16<<i] 字节的分配，最后一个桶包含更大的分配）
+#define RL_MEM_SITE_HIST_COUNT      16
+// 收到信号时输出调用点统计的文件
+#define RL_MEM_SITE_DUMP_FILE_DIR   "/tmp/memory_sites"
+// 采样分析默认的平均采样间隔（字节）
+#define RL_MEM_SAMPLE_INTERVAL      (512 * 1024)
+// 采样分析记录的最大调用栈深度
+#define RL_MEM_SAMPLE_DEPTH         32
+// 采样分析调用栈表大小（必须为 2 的幂，表满后新的调用栈不再记录）
+#define RL_MEM_SAMPLE_STACK_COUNT   1024
+// 采样内存块计数过滤器大小（必须为 2 的幂）
+#define RL_MEM_SAMPLE_FILTER_SIZE   16384
+// 保护页方式下隔离区最多保留的已释放内存块数量
+#define RL_MEM_GUARD_QUARANTINE_COUNT   4096
+// 保护页方式下隔离区默认最多保留的已释放字节数（按映射大小计算）
+#define RL_MEM_GUARD_QUARANTINE_BYTES   (64 * 1024 * 1024)
+// 堆使用快照默认的采样间隔（毫秒）
+#define RL_MEM_SNAPSHOT_INTERVAL        (10 * 1000)
+// 堆使用快照文件路径（超过 RL_MEM_SNAPSHOT_FILE_SIZE 字节时改名为 .1 后重新写入）
+#define RL_MEM_SNAPSHOT_FILE_DIR        "../log/memory_snapshot"
+#define RL_MEM_SNAPSHOT_FILE_SIZE       (1024 * 1024)
+// 调用点持续增长判断：每 RL_MEM_SNAPSHOT_WINDOW 个快照为一个窗口，窗口内最低值连续 RL_MEM_SNAPSHOT_GROWTH_WINDOWS 个窗口上升时标记
+#define RL_MEM_SNAPSHOT_WINDOW          6
+#define RL_MEM_SNAPSHOT_GROWTH_WINDOWS  3
+// 内存区默认每次映射的大小
+#define RL_ARENA_CHUNK_SIZE         (256 * 1024)
+// 大页大小（内存区开启大页及 rl_huge_alloc 时按此对齐）
+#define RL_ARENA_HUGE_PAGE_SIZE     (2 * 1024 * 1024)
 
 #ifdef __cplusplus
 extern "C"
 {
 #endif
 
+// 固定大小对象池
+typedef struct rl_pool rl_pool_t;
+
+// 内存区（按块从 mmap 获取，分配只移动指针，整体回退/重置，非线程安全）
+typedef struct rl_arena rl_arena_t;
+
+// 内存区位置标记（用于 rl_arena_rewind）
+typedef struct
+{
+    void *chunk;
+    size_t offset;
+} rl_arena_mark_t;
+
+// rlmem 统计信息
+typedef struct
+{
+    unsigned long long trace_blocks;        // 跟踪中的内存块数量
+    unsigned long long trace_bytes;         // 跟踪中的内存字节数
+    unsigned long long arena_count;         // 内存区数量
+    unsigned long long arena_reserved_bytes;// 内存区从系统映射的字节数
+    unsigned long long arena_used_bytes;    // 内存区已分配的字节数
+    unsigned long long arena_peak_bytes;    // 各内存区已分配字节数峰值之和
+} rl_mem_stats_t;
+
+// 调用点分配统计
+typedef struct
+{
+    const char *file;
+    const char *func;
+    int line;
+    unsigned long long cur_bytes;       // 当前未释放的字节数
+    unsigned long long cur_blocks;      // 当前未释放的块数
+    unsigned long long total_allocs;    // 累计分配次数
+    unsigned long long total_frees;     // 累计释放次数
+    unsigned long long peak_bytes;      // 未释放字节数峰值
+    unsigned long long hist[RL_MEM_SITE_HIST_COUNT];  // 分配大小直方图
+} rl_mem_site_stats_t;
+
+// 堆使用快照
+typedef struct
+{
+    unsigned long long time_ms;             // 快照时间（1970 年起的毫秒数）
+    unsigned long long trace_blocks;        // 跟踪中的内存块数量
+    unsigned long long trace_bytes;         // 跟踪中的内存字节数
+    unsigned long long arena_reserved_bytes;// 内存区从系统映射的字节数
+    unsigned long long rss_bytes;           // 进程常驻内存（VmRSS）
+    long long untracked_bytes;              // rss_bytes - trace_bytes - arena_reserved_bytes，持续增大说明是分配器碎片而不是自身分配
+    unsigned int growing_sites;             // 持续增长的调用点数量
+} rl_mem_snapshot_t;
+
+// 内存分配跟踪方式
+typedef enum
+{
+    RL_MEM_TRACE_TABLE,     // 按指针记录在独立的哈希表中（默认）
+    RL_MEM_TRACE_INLINE,    // 在每块内存前附加头部记录大小和调用点，释放时无需查表
+    RL_MEM_TRACE_GUARD      // 调试用：每块内存单独映射并紧挨保护页，释放后填充并禁止访问，放入隔离区一段时间再归还
+                            // 越界写和释放后使用在出错的指令处触发 SIGSEGV（每块至少占两页，只用于压力测试）
+} RL_MEM_TRACE_MODE;
+
+// 内存分配事件输出方式
+typedef enum
+{
+    RL_MEM_TRACE_OUTPUT_JOURNAL,    // 按线程批量写入二进制事件日志（默认），用 rlmem/tools/rlmem_journal_decode 还原为文本
+    RL_MEM_TRACE_OUTPUT_TEXT,       // 每个事件输出一行调试日志（开销大，仅调试时使用）
+    RL_MEM_TRACE_OUTPUT_NONE        // 不输出事件，只保留泄露报告和统计
+} RL_MEM_TRACE_OUTPUT;
+
+// 设置内存分配跟踪方式（仅在 rl_memory_trace_init 开启跟踪之前调用）
+int rl_memory_trace_set_mode(RL_MEM_TRACE_MODE mode);
+
+// 设置每次分配/释放事件的输出方式（仅在 rl_memory_trace_init 开启跟踪之前调用）
+int rl_memory_trace_set_output(RL_MEM_TRACE_OUTPUT output);
+
+// 设置保护页方式下隔离区最多保留的已释放字节数（默认 RL_MEM_GUARD_QUARANTINE_BYTES，0 表示释放后立即解除映射）
+int rl_memory_guard_set_quarantine(size_t max_bytes);
+
 // 仅程序初始化时调用
 void rl_memory_trace_init(bool state);
 
 // 仅程序结束时调用（输出内存泄露情况到文件）
 int rl_memory_trace_deinit();
 
-void *rl_malloc(unsigned int size, const char *file, const char *func, int line);
+void *rl_malloc(size_t size, const char *file, const char *func, int line);
 
 int rl_free(void *ptr, const char *file, const char *func, int line);
 
-void *rl_calloc(unsigned int block, unsigned int count, const char *file, const char *func, int line);
+// block * count 溢出时返回 NULL
+void *rl_calloc(size_t block, size_t count, const char *file, const char *func, int line);
+
+void *rl_realloc(void *ptr, size_t size, const char *file, const char *func, int line);
+
+// 与 reallocarray 相同：nmemb * size 溢出时返回 NULL，原内存块不变
+void *rl_reallocarray(void *ptr, size_t nmemb, size_t size, const char *file, const char *func, int line);
+
+// 按 align 对齐分配（align 必须为 2 的幂，例如 64 按缓存行对齐），使用 rl_free 释放
+void *rl_aligned_alloc(size_t size, size_t align, const char *file, const char *func, int line);
+
+// 使用 mmap 按大页对齐分配并建议内核使用透明大页（不支持时为普通页），使用 rl_free 释放，rl_realloc 会重新映射并复制
+void *rl_huge_alloc(size_t size, const char *file, const char *func, int line);
+
+// 创建对象池：每次从系统分配一个包含 objs_per_slab 个对象的内存块，name 用于泄露报告
+// 每个线程有自己的缓存，分配/释放无需加锁；对象不会归还给系统，直到 rl_pool_destroy
+rl_pool_t *rl_pool_create(unsigned int obj_size, unsigned int objs_per_slab, const char *name);
+
+// 从对象池分配一个对象（内容未初始化）
+void *rl_pool_alloc(rl_pool_t *pool);
+
+// 将对象归还到对象池（必须是同一个对象池分配的对象）
+int rl_pool_free(rl_pool_t *pool, void *obj);
+
+// 销毁对象池并释放所有内存（调用时其他线程不能再使用该对象池）
+int rl_pool_destroy(rl_pool_t *pool);
+
+// 创建内存区：chunk_size 为 0 时使用默认值，huge_page 为 RL_TRUE 时按大页对齐并建议内核使用透明大页
+rl_arena_t *rl_arena_create(size_t chunk_size, bool huge_page);
+
+// 从内存区分配 size 字节，align 为 0 时按 16 字节对齐（必须为 2 的幂）
+void *rl_arena_alloc(rl_arena_t *arena, size_t size, size_t align);
+
+// 记录当前位置
+rl_arena_mark_t rl_arena_mark(rl_arena_t *arena);
+
+// 回退到 mark 记录的位置，之后分配的内存全部失效
+int rl_arena_rewind(rl_arena_t *arena, rl_arena_mark_t mark);
+
+// 释放全部分配（保留第一块映射供复用）
+int rl_arena_reset(rl_arena_t *arena);
+
+// 销毁内存区并归还所有映射
+int rl_arena_destroy(rl_arena_t *arena);
+
+// 获取 rlmem 统计信息
+int rl_memory_get_stats(rl_mem_stats_t *stats);
+
+// 获取按调用点汇总的分配统计（需开启内存分配跟踪），按当前未释放字节数从大到小取前 max_count 个，返回实际个数
+int rl_memory_get_site_stats(rl_mem_site_stats_t *stats, unsigned int max_count);
+
+// 将所有调用点的分配统计以文本写入 fd（只使用 write，可在信号处理函数中调用）
+int rl_memory_dump_site_stats(int fd);
+
+// 收到 signo 信号时把调用点统计写入 RL_MEM_SITE_DUMP_FILE_DIR（例如 SIGUSR1）
+int rl_memory_site_dump_on_signal(int signo);
+
+// 开启采样分析：平均每分配 interval 字节采样一次（0 使用 RL_MEM_SAMPLE_INTERVAL），不依赖 rl_memory_trace_init
+int rl_memory_sample_start(unsigned int interval);
+
+// 停止采样（已采样的内存块仍会在释放时记录）
+int rl_memory_sample_stop();
+
+// 输出采样的堆分析文件（gperftools heap profile 格式，可用 pprof 查看）
+int rl_memory_sample_dump(const char *path);
+
+// 开启堆使用快照线程：每 interval_ms 毫秒（0 使用 RL_MEM_SNAPSHOT_INTERVAL）记录一次到 RL_MEM_SNAPSHOT_FILE_DIR
+// 跟踪字节数和调用点增长判断需开启内存分配跟踪，否则只记录常驻内存
+int rl_memory_snapshot_start(unsigned int interval_ms);
+
+// 停止堆使用快照线程
+int rl_memory_snapshot_stop();
+
+// 获取最近一次快照（未开启时返回 RL_FAILED）
+int rl_memory_snapshot_get(rl_mem_snapshot_t *snapshot);
 
-void *rl_realloc(void *ptr, unsigned int size, const char *file, const char *func, int line);
+// 获取被标记为持续增长的调用点，按当前未释放字节数从大到小取前 max_count 个，返回实际个数
+int rl_memory_get_growing_sites(rl_mem_site_stats_t *stats, unsigned int max_count);
 
 #ifdef __cplusplus
 }
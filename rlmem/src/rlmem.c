@@ -1,352 +1,2958 @@
+#include <stdint.h>
+#include <time.h>
+#include <sys/syscall.h>
+#include <limits.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <signal.h>
+#include <execinfo.h>
 #include "rlmem.h"
 #include "rl/rlsys.h"
 #include "rl/rlstr.h"
 #include "rl/rltime.h"
+#include "rl/rlstat.h"
 
 #define __FILENAME__ "rlmem"
 
 // 是否开启内存分配跟踪
 static bool rl_memory_trace_state = RL_FALSE;
+// 内存分配跟踪方式
+static RL_MEM_TRACE_MODE rl_memory_trace_mode = RL_MEM_TRACE_TABLE;
+// 分配事件输出方式
+static RL_MEM_TRACE_OUTPUT rl_memory_trace_output = RL_MEM_TRACE_OUTPUT_JOURNAL;
 
-// 内存分配跟踪
-static pthread_mutex_t mem_lock;
-typedef struct MEM_NODE
+// 内存分配跟踪记录（ptr 为 NULL 表示空槽位）
+typedef struct
 {
     void *ptr;
-    unsigned int size;
+    size_t size;
     const char *file;
     const char *func;
     int line;
-    struct MEM_NODE *next;
+    unsigned int site;
 } MEM_NODE_T;
-static MEM_NODE_T *g_mem_header;
-static unsigned int g_alloc_block_count = 0;
-static unsigned int g_alloc_total_bytes = 0;
+
+// 跟踪表分片：按指针哈希分散到各分片，分片内为线性探测的开放寻址哈希表
+typedef struct
+{
+    pthread_mutex_t lock;
+    MEM_NODE_T *table;
+    unsigned int capacity;
+    unsigned int count;
+} __attribute__((aligned(64))) MEM_SHARD_T;
+
+static MEM_SHARD_T g_mem_shard[RL_MEM_TRACE_SHARD_COUNT];
+// 跟踪中的内存块数量和字节数：开启跟踪后改为存放在 rlstat 指标中（导出到共享内存），之前使用本地变量
+static unsigned long long g_alloc_local[2] = {0, 0};
+static unsigned long long *g_alloc_block_count = &g_alloc_local[0];
+static unsigned long long *g_alloc_total_bytes = &g_alloc_local[1];
+static pthread_once_t g_alloc_stat_once = PTHREAD_ONCE_INIT;
+
+// 读取当前计数位置（指针只在首次开启跟踪前发布一次）
+static inline unsigned long long *rl_mem_block_counter(void)
+{
+    return __atomic_load_n(&g_alloc_block_count, __ATOMIC_ACQUIRE);
+}
+
+static inline unsigned long long *rl_mem_bytes_counter(void)
+{
+    return __atomic_load_n(&g_alloc_total_bytes, __ATOMIC_ACQUIRE);
+}
+
+// 注册 rlstat 指标并发布计数指针：在 rl_memory_trace_state 置位前执行，此时尚无线程更新计数
+static void rl_mem_alloc_stat_init(void)
+{
+    rl_stat_t *blocks = rl_stat_register("rlmem.trace_blocks", RL_STAT_GAUGE);
+    rl_stat_t *bytes = rl_stat_register("rlmem.trace_bytes", RL_STAT_GAUGE);
+    if (blocks == NULL || bytes == NULL)
+    {
+        return;
+    }
+    rl_stat_set(blocks, __atomic_load_n(&g_alloc_local[0], __ATOMIC_RELAXED));
+    rl_stat_set(bytes, __atomic_load_n(&g_alloc_local[1], __ATOMIC_RELAXED));
+    __atomic_store_n(&g_alloc_block_count, (unsigned long long *)&blocks->value, __ATOMIC_RELEASE);
+    __atomic_store_n(&g_alloc_total_bytes, (unsigned long long *)&bytes->value, __ATOMIC_RELEASE);
+}
+
+// 指针哈希（低位用于选择分片，高位用于分片内定位）
+static uint64_t rl_mem_hash(const void *ptr)
+{
+    uint64_t hash = (uintptr_t)ptr;
+    hash ^= hash >> 33;
+    hash *= 0xff51afd7ed558ccdULL;
+    hash ^= hash >> 33;
+    hash *= 0xc4ceb9fe1a85ec53ULL;
+    hash ^= hash >> 33;
+    return hash;
+}
+
+static MEM_SHARD_T *rl_mem_shard(MEM_SHARD_T *shards, uint64_t hash)
+{
+    return &shards[hash & (RL_MEM_TRACE_SHARD_COUNT - 1)];
+}
+
+static unsigned int rl_mem_slot(uint64_t hash, unsigned int capacity)
+{
+    return (unsigned int)(hash >> 16) & (capacity - 1);
+}
+
+// 调用点登记表（只增不删，state：0 空槽位，1 正在写入，2 可用），同时按调用点汇总分配统计
+typedef struct
+{
+    const char *file;
+    const char *func;
+    int line;
+    unsigned int state;
+    unsigned int journaled;     // 是否已写入当前的分配事件日志
+    unsigned long long cur_bytes;
+    unsigned long long cur_blocks;
+    unsigned long long total_allocs;
+    unsigned long long total_frees;
+    unsigned long long peak_bytes;
+    unsigned long long hist[RL_MEM_SITE_HIST_COUNT];
+} MEM_SITE_T;
+
+static MEM_SITE_T g_mem_site[RL_MEM_TRACE_SITE_COUNT];
+
+// 获取调用点编号（从 1 开始，表满时返回 0）
+static unsigned int rl_mem_site_id(const char *file, const char *func, int line)
+{
+    uintptr_t key = (uintptr_t)file ^ ((uintptr_t)func << 1) ^ ((uintptr_t)line * 0x9E3779B97F4A7C15ULL);
+    unsigned int index = (unsigned int)rl_mem_hash((const void *)key) & (RL_MEM_TRACE_SITE_COUNT - 1);
+    for (int probe = 0; probe < 64; probe++)
+    {
+        MEM_SITE_T *site = &g_mem_site[(index + probe) & (RL_MEM_TRACE_SITE_COUNT - 1)];
+        unsigned int state = __atomic_load_n(&site->state, __ATOMIC_ACQUIRE);
+        if (state == 0)
+        {
+            if (__atomic_compare_exchange_n(&site->state, &state, 1, RL_FALSE, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE))
+            {
+                site->file = file;
+                site->func = func;
+                site->line = line;
+                __atomic_store_n(&site->state, 2, __ATOMIC_RELEASE);
+                return ((index + probe) & (RL_MEM_TRACE_SITE_COUNT - 1)) + 1;
+            }
+        }
+        // 其他线程正在登记该槽位
+        while (state == 1)
+        {
+            sched_yield();
+            state = __atomic_load_n(&site->state, __ATOMIC_ACQUIRE);
+        }
+        if (site->file == file && site->func == func && site->line == line)
+        {
+            return ((index + probe) & (RL_MEM_TRACE_SITE_COUNT - 1)) + 1;
+        }
+    }
+    return 0;
+}
+
+// 根据调用点编号获取调用点（编号为 0 时返回 NULL）
+static const MEM_SITE_T *rl_mem_site_get(unsigned int id)
+{
+    if (id == 0 || id > RL_MEM_TRACE_SITE_COUNT)
+    {
+        return NULL;
+    }
+    return &g_mem_site[id - 1];
+}
+
+// 调用点统计一次分配
+static void rl_mem_site_alloc(unsigned int id, size_t size)
+{
+    if (id == 0)
+    {
+        return;
+    }
+    MEM_SITE_T *site = &g_mem_site[id - 1];
+    unsigned int bucket = (size <= 16) ? 0 : 64 - __builtin_clzll(size - 1) - 4;
+    if (bucket >= RL_MEM_SITE_HIST_COUNT)
+    {
+        bucket = RL_MEM_SITE_HIST_COUNT - 1;
+    }
+    __atomic_add_fetch(&site->hist[bucket], 1, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&site->total_allocs, 1, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&site->cur_blocks, 1, __ATOMIC_RELAXED);
+    unsigned long long cur = __atomic_add_fetch(&site->cur_bytes, size, __ATOMIC_RELAXED);
+    unsigned long long peak = __atomic_load_n(&site->peak_bytes, __ATOMIC_RELAXED);
+    while (cur > peak && !__atomic_compare_exchange_n(&site->peak_bytes, &peak, cur, RL_TRUE, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+    {
+    }
+}
+
+// 调用点统计一次释放
+static void rl_mem_site_free(unsigned int id, size_t size)
+{
+    if (id == 0)
+    {
+        return;
+    }
+    MEM_SITE_T *site = &g_mem_site[id - 1];
+    __atomic_add_fetch(&site->total_frees, 1, __ATOMIC_RELAXED);
+    __atomic_sub_fetch(&site->cur_blocks, 1, __ATOMIC_RELAXED);
+    __atomic_sub_fetch(&site->cur_bytes, size, __ATOMIC_RELAXED);
+}
+
+// 扩容分片哈希表（调用者需持有分片锁）
+static int rl_mem_shard_grow(MEM_SHARD_T *shard)
+{
+    unsigned int capacity = (shard->capacity == 0) ? RL_MEM_TRACE_SHARD_SIZE : shard->capacity * 2;
+    MEM_NODE_T *table = (MEM_NODE_T *)calloc(capacity, sizeof(MEM_NODE_T));
+    if (table == NULL)
+    {
+        return RL_FAILED;
+    }
+    for (unsigned int i = 0; i < shard->capacity; i++)
+    {
+        if (shard->table[i].ptr == NULL)
+        {
+            continue;
+        }
+        unsigned int slot = rl_mem_slot(rl_mem_hash(shard->table[i].ptr), capacity);
+        while (table[slot].ptr != NULL)
+        {
+            slot = (slot + 1) & (capacity - 1);
+        }
+        table[slot] = shard->table[i];
+    }
+    free(shard->table);
+    shard->table = table;
+    shard->capacity = capacity;
+    return RL_SUCCESS;
+}
+
+// 添加一条跟踪记录
+static int rl_mem_track_insert(MEM_SHARD_T *shards, void *ptr, size_t size, const char *file, const char *func, int line, unsigned int site)
+{
+    uint64_t hash = rl_mem_hash(ptr);
+    MEM_SHARD_T *shard = rl_mem_shard(shards, hash);
+    pthread_mutex_lock(&shard->lock);
+    if ((shard->count + 1) * 2 > shard->capacity && rl_mem_shard_grow(shard) == RL_FAILED)
+    {
+        pthread_mutex_unlock(&shard->lock);
+        return RL_FAILED;
+    }
+    unsigned int mask = shard->capacity - 1;
+    unsigned int slot = rl_mem_slot(hash, shard->capacity);
+    while (shard->table[slot].ptr != NULL)
+    {
+        slot = (slot + 1) & mask;
+    }
+    MEM_NODE_T *node = &shard->table[slot];
+    node->ptr = ptr;
+    node->size = size;
+    node->file = file;
+    node->func = func;
+    node->line = line;
+    node->site = site;
+    shard->count++;
+    pthread_mutex_unlock(&shard->lock);
+    return RL_SUCCESS;
+}
+
+// 查找一条跟踪记录，找到时通过 node 返回
+static int rl_mem_track_find(MEM_SHARD_T *shards, void *ptr, MEM_NODE_T *node)
+{
+    uint64_t hash = rl_mem_hash(ptr);
+    MEM_SHARD_T *shard = rl_mem_shard(shards, hash);
+    pthread_mutex_lock(&shard->lock);
+    if (shard->count == 0)
+    {
+        pthread_mutex_unlock(&shard->lock);
+        return RL_FAILED;
+    }
+    unsigned int slot = rl_mem_slot(hash, shard->capacity);
+    while (shard->table[slot].ptr != ptr)
+    {
+        if (shard->table[slot].ptr == NULL)
+        {
+            pthread_mutex_unlock(&shard->lock);
+            return RL_FAILED;
+        }
+        slot = (slot + 1) & (shard->capacity - 1);
+    }
+    *node = shard->table[slot];
+    pthread_mutex_unlock(&shard->lock);
+    return RL_SUCCESS;
+}
+
+// 删除一条跟踪记录，找到时通过 node 返回删除的记录
+static int rl_mem_track_remove(MEM_SHARD_T *shards, void *ptr, MEM_NODE_T *node)
+{
+    uint64_t hash = rl_mem_hash(ptr);
+    MEM_SHARD_T *shard = rl_mem_shard(shards, hash);
+    pthread_mutex_lock(&shard->lock);
+    if (shard->count == 0)
+    {
+        pthread_mutex_unlock(&shard->lock);
+        return RL_FAILED;
+    }
+    unsigned int mask = shard->capacity - 1;
+    unsigned int slot = rl_mem_slot(hash, shard->capacity);
+    while (shard->table[slot].ptr != ptr)
+    {
+        if (shard->table[slot].ptr == NULL)
+        {
+            pthread_mutex_unlock(&shard->lock);
+            return RL_FAILED;
+        }
+        slot = (slot + 1) & mask;
+    }
+    *node = shard->table[slot];
+    // 后移删除：把探测链上后面的记录前移，保持查找不需要墓碑标记
+    unsigned int hole = slot;
+    unsigned int next = slot;
+    while (1)
+    {
+        next = (next + 1) & mask;
+        if (shard->table[next].ptr == NULL)
+        {
+            break;
+        }
+        unsigned int home = rl_mem_slot(rl_mem_hash(shard->table[next].ptr), shard->capacity);
+        // home 不在 (hole, next] 区间内时才能前移到 hole
+        if (((next - home) & mask) >= ((next - hole) & mask))
+        {
+            shard->table[hole] = shard->table[next];
+            hole = next;
+        }
+    }
+    shard->table[hole].ptr = NULL;
+    shard->count--;
+    pthread_mutex_unlock(&shard->lock);
+    return RL_SUCCESS;
+}
+
+// 头部校验值（与头部地址异或，旧数据残留不会被误判）
+#define RL_MEM_INLINE_MAGIC     0x524C4D454D484452ULL
+#define RL_MEM_INLINE_FREED     0x524C4D454D465245ULL
+
+// 头部中大小字段的位数（调用点编号占用剩余的 16 位，头部保持 32 字节）
+#define RL_MEM_INLINE_SIZE_BITS 48
+#define RL_MEM_INLINE_SIZE_MAX  ((1ULL << RL_MEM_INLINE_SIZE_BITS) - 1)
+#if RL_MEM_TRACE_SITE_COUNT > 65535
+#error "RL_MEM_TRACE_SITE_COUNT must fit in the 16-bit site field of MEM_INLINE_HDR_T"
+#endif
+
+// 头部跟踪方式下附加在每块内存前的头部（大小为 16 的倍数，不影响返回地址的对齐）
+// magic 必须位于最后，紧挨返回给调用者的地址，这样检查外部指针时只会读到系统分配器自己的块头
+typedef struct MEM_INLINE_HDR
+{
+    struct MEM_INLINE_HDR *prev;
+    struct MEM_INLINE_HDR *next;
+    uint64_t size : RL_MEM_INLINE_SIZE_BITS;
+    uint64_t site : 64 - RL_MEM_INLINE_SIZE_BITS;
+    uint64_t magic;
+} MEM_INLINE_HDR_T;
+
+// 头部跟踪方式下按头部地址分片的双向链表（仅用于输出泄露报告）
+typedef struct
+{
+    pthread_mutex_t lock;
+    MEM_INLINE_HDR_T *head;
+} __attribute__((aligned(64))) MEM_INLINE_SHARD_T;
+
+static MEM_INLINE_SHARD_T g_mem_inline_shard[RL_MEM_TRACE_SHARD_COUNT];
+// 是否使用过头部跟踪方式（一旦使用，之后的 rl_free/rl_realloc 都需要识别带头部的内存块）
+static bool rl_mem_inline_used = RL_FALSE;
+
+// 初始化头部跟踪分片（只初始化一次，之后不再销毁，已分配的内存块在跟踪关闭后仍可释放）
+static void rl_mem_inline_init()
+{
+    for (int i = 0; i < RL_MEM_TRACE_SHARD_COUNT; i++)
+    {
+        pthread_mutex_init(&g_mem_inline_shard[i].lock, NULL);
+        g_mem_inline_shard[i].head = NULL;
+    }
+}
+
+// 初始化头部并加入分片链表，返回给调用者的地址
+static void *rl_mem_inline_link(void *raw, size_t size, unsigned int site)
+{
+    MEM_INLINE_HDR_T *hdr = (MEM_INLINE_HDR_T *)raw;
+    MEM_INLINE_SHARD_T *shard = &g_mem_inline_shard[rl_mem_hash(hdr) & (RL_MEM_TRACE_SHARD_COUNT - 1)];
+    hdr->size = size;
+    hdr->site = site;
+    hdr->magic = RL_MEM_INLINE_MAGIC ^ (uintptr_t)hdr;
+    hdr->prev = NULL;
+    pthread_mutex_lock(&shard->lock);
+    hdr->next = shard->head;
+    if (shard->head != NULL)
+    {
+        shard->head->prev = hdr;
+    }
+    shard->head = hdr;
+    pthread_mutex_unlock(&shard->lock);
+    return hdr + 1;
+}
+
+// 从分片链表中移除
+static void rl_mem_inline_unlink(MEM_INLINE_HDR_T *hdr)
+{
+    MEM_INLINE_SHARD_T *shard = &g_mem_inline_shard[rl_mem_hash(hdr) & (RL_MEM_TRACE_SHARD_COUNT - 1)];
+    pthread_mutex_lock(&shard->lock);
+    if (hdr->prev != NULL)
+    {
+        hdr->prev->next = hdr->next;
+    }
+    else
+    {
+        shard->head = hdr->next;
+    }
+    if (hdr->next != NULL)
+    {
+        hdr->next->prev = hdr->prev;
+    }
+    pthread_mutex_unlock(&shard->lock);
+}
+
+// 检查 ptr 是否为带头部的内存块：是则返回头部，已释放过时 freed 置为 RL_TRUE
+// 外部指针前 8 字节属于系统分配器的块头，读取是安全的，但需要让 AddressSanitizer 忽略
+__attribute__((no_sanitize_address))
+static MEM_INLINE_HDR_T *rl_mem_inline_hdr(void *ptr, bool *freed)
+{
+    *freed = RL_FALSE;
+    if (__atomic_load_n(&rl_mem_inline_used, __ATOMIC_ACQUIRE) == RL_FALSE)
+    {
+        return NULL;
+    }
+    MEM_INLINE_HDR_T *hdr = (MEM_INLINE_HDR_T *)ptr - 1;
+    uint64_t magic = ((uint64_t *)ptr)[-1];
+    if (magic == (RL_MEM_INLINE_MAGIC ^ (uintptr_t)hdr))
+    {
+        return hdr;
+    }
+    if (magic == (RL_MEM_INLINE_FREED ^ (uintptr_t)hdr))
+    {
+        *freed = RL_TRUE;
+    }
+    return NULL;
+}
+
+// 对象池线程缓存（count 只由所属线程修改，泄露报告时由其他线程读取）
+typedef struct RL_POOL_CACHE
+{
+    rl_pool_t *pool;
+    void *head;
+    unsigned int count;
+    struct RL_POOL_CACHE *prev;
+    struct RL_POOL_CACHE *next;
+} RL_POOL_CACHE_T;
+
+// 对象池：空闲对象的第一个指针指向下一个空闲对象；
+// 共享仓库中按批存放，每批第一个对象的第二个指针指向下一批
+struct rl_pool
+{
+    char name[32];
+    unsigned int obj_size;
+    unsigned int objs_per_slab;
+    pthread_key_t key;
+    // 保护以下成员
+    pthread_mutex_t lock;
+    void *batches;
+    void *slabs;
+    unsigned int slab_count;
+    RL_POOL_CACHE_T *caches;
+    struct rl_pool *next;
+};
+
+// 对象池内存块头部大小（保证对象 16 字节对齐）
+#define RL_POOL_SLAB_HEAD   16
+
+// 所有对象池（用于泄露报告）
+static pthread_mutex_t g_pool_lock = PTHREAD_MUTEX_INITIALIZER;
+static rl_pool_t *g_pool_header = NULL;
+
+// 统计对象池中正在使用的对象数量（调用者需持有 pool->lock）
+static unsigned int rl_pool_in_use_locked(rl_pool_t *pool)
+{
+    unsigned int free_count = 0;
+    for (void *batch = pool->batches; batch != NULL; batch = ((void **)batch)[1])
+    {
+        for (void *obj = batch; obj != NULL; obj = *(void **)obj)
+        {
+            free_count++;
+        }
+    }
+    for (RL_POOL_CACHE_T *cache = pool->caches; cache != NULL; cache = cache->next)
+    {
+        free_count += __atomic_load_n(&cache->count, __ATOMIC_RELAXED);
+    }
+    return pool->slab_count * pool->objs_per_slab - free_count;
+}
+
+// 生成跟踪输出文件路径：程序目录下的 dir 追加 _进程名.suffix
+static int rl_mem_trace_file_path(char *path, unsigned int size, const char *dir, const char *suffix)
+{
+    int ret = rl_get_file_abs_path(path, size, dir);
+    if (ret == RL_FAILED || rl_str_isempty(path) == RL_TRUE)
+    {
+        rl_log_error("[%s:%s:%d] get log path failed", __FILENAME__, __FUNCTION__, __LINE__);
+        return RL_FAILED;
+    }
+    char name[32] = {0};
+    if (rl_get_proc_name(name, sizeof(name)) == RL_FAILED)
+    {
+        rl_log_error("[%s:%s:%d] get proc name failed", __FILENAME__, __FUNCTION__, __LINE__);
+        return RL_FAILED;
+    }
+    // 追加进程名和后缀，确保不会越界
+    unsigned int used = strlen(path);
+    int remain = size - used;
+    if (remain <= 0 || snprintf(path + used, remain, "_%s.%s", name, suffix) >= remain)
+    {
+        rl_log_error("[%s:%s:%d] log file path too long", __FILENAME__, __FUNCTION__, __LINE__);
+        return RL_FAILED;
+    }
+    return RL_SUCCESS;
+}
+
+// 分配事件日志：每个线程先把事件写入自己的缓冲区，满一批后一次写入文件
+// 文件由记录组成，每条记录以 MEM_JOURNAL_HEAD_T 开头（布局与 rlmem/tools/rlmem_journal_decode.c 保持一致）
+#define RL_MEM_JOURNAL_MAGIC            0x4D52
+#define RL_MEM_JOURNAL_VERSION          2
+#define RL_MEM_JOURNAL_TYPE_SESSION     1
+#define RL_MEM_JOURNAL_TYPE_SITE        2
+#define RL_MEM_JOURNAL_TYPE_EVENT       3
+
+// 事件类型
+#define RL_MEM_EVENT_MALLOC     1
+#define RL_MEM_EVENT_CALLOC     2
+#define RL_MEM_EVENT_FREE       3
+#define RL_MEM_EVENT_REALLOC    4
+#define RL_MEM_EVENT_ALIGNED    5
+#define RL_MEM_EVENT_HUGE       6
+
+typedef struct
+{
+    uint16_t magic;
+    uint8_t type;
+    uint8_t reserved;
+    uint32_t len;       // 包含记录头的总长度
+} __attribute__((packed)) MEM_JOURNAL_HEAD_T;
+
+// 会话记录（文件开头）：事件使用单调时间，解码时用这里的两个时间换算为实际时间
+typedef struct
+{
+    MEM_JOURNAL_HEAD_T head;
+    uint32_t version;
+    uint32_t pid;
+    uint64_t real_ns;
+    uint64_t mono_ns;
+    char proc_name[16];
+} __attribute__((packed)) MEM_JOURNAL_SESSION_T;
+
+// 调用点记录：第一次使用某个调用点时写入，后接 file\0func\0
+typedef struct
+{
+    MEM_JOURNAL_HEAD_T head;
+    uint32_t id;
+    int32_t line;
+} __attribute__((packed)) MEM_JOURNAL_SITE_T;
+
+// 单个事件
+typedef struct
+{
+    uint64_t mono_ns;
+    uint64_t ptr;
+    uint64_t old_ptr;       // realloc 的原地址
+    uint64_t size;
+    uint64_t block_count;
+    uint64_t total_bytes;
+    uint32_t site;          // 调用 rl_malloc/rl_free 等接口的调用点编号
+    uint8_t op;
+    uint8_t reserved[3];
+} __attribute__((packed)) MEM_JOURNAL_EVENT_T;
+
+// 线程事件缓冲区（head 之后的部分与文件中的事件记录布局一致且没有填充，一次 write 写出）
+typedef struct MEM_JOURNAL_BUF
+{
+    struct MEM_JOURNAL_BUF *next;
+    MEM_JOURNAL_HEAD_T head;
+    uint32_t tid;
+    uint32_t count;
+    MEM_JOURNAL_EVENT_T event[RL_MEM_JOURNAL_BATCH];
+} MEM_JOURNAL_BUF_T;
+
+static int g_mem_journal_fd = -1;
+// 保护文件写入和线程缓冲区链表
+static pthread_mutex_t g_mem_journal_lock = PTHREAD_MUTEX_INITIALIZER;
+static MEM_JOURNAL_BUF_T *g_mem_journal_header = NULL;
+static pthread_key_t g_mem_journal_key;
+static pthread_once_t g_mem_journal_once = PTHREAD_ONCE_INIT;
+static __thread MEM_JOURNAL_BUF_T *rl_mem_journal_self = NULL;
+
+// 写出缓冲区中的事件（调用者需持有 g_mem_journal_lock）
+static void rl_mem_journal_flush_locked(MEM_JOURNAL_BUF_T *buf)
+{
+    if (buf->count == 0)
+    {
+        return;
+    }
+    if (g_mem_journal_fd != -1)
+    {
+        uint32_t len = sizeof(MEM_JOURNAL_HEAD_T) + 2 * sizeof(uint32_t) + buf->count * sizeof(MEM_JOURNAL_EVENT_T);
+        buf->head.len = len;
+        if (write(g_mem_journal_fd, &buf->head, len) != (ssize_t)len)
+        {
+            rl_log_error("[%s:%s:%d] write memory journal failed", __FILENAME__, __FUNCTION__, __LINE__);
+        }
+    }
+    buf->count = 0;
+}
+
+// 线程退出时写出剩余事件并释放缓冲区
+static void rl_mem_journal_destructor(void *arg)
+{
+    MEM_JOURNAL_BUF_T *buf = (MEM_JOURNAL_BUF_T *)arg;
+    pthread_mutex_lock(&g_mem_journal_lock);
+    rl_mem_journal_flush_locked(buf);
+    for (MEM_JOURNAL_BUF_T **cur = &g_mem_journal_header; *cur != NULL; cur = &(*cur)->next)
+    {
+        if (*cur == buf)
+        {
+            *cur = buf->next;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&g_mem_journal_lock);
+    free(buf);
+}
+
+static void rl_mem_journal_key_create()
+{
+    pthread_key_create(&g_mem_journal_key, rl_mem_journal_destructor);
+}
+
+// 获取当前线程的事件缓冲区（首次使用时创建）
+static MEM_JOURNAL_BUF_T *rl_mem_journal_buf()
+{
+    if (rl_mem_journal_self != NULL)
+    {
+        return rl_mem_journal_self;
+    }
+    MEM_JOURNAL_BUF_T *buf = (MEM_JOURNAL_BUF_T *)malloc(sizeof(MEM_JOURNAL_BUF_T));
+    if (buf == NULL)
+    {
+        return NULL;
+    }
+    buf->head.magic = RL_MEM_JOURNAL_MAGIC;
+    buf->head.type = RL_MEM_JOURNAL_TYPE_EVENT;
+    buf->head.reserved = 0;
+    buf->tid = syscall(SYS_gettid);
+    buf->count = 0;
+    pthread_once(&g_mem_journal_once, rl_mem_journal_key_create);
+    pthread_setspecific(g_mem_journal_key, buf);
+    pthread_mutex_lock(&g_mem_journal_lock);
+    buf->next = g_mem_journal_header;
+    g_mem_journal_header = buf;
+    pthread_mutex_unlock(&g_mem_journal_lock);
+    rl_mem_journal_self = buf;
+    return buf;
+}
+
+// 第一次使用调用点时把调用点的文件/函数/行号写入日志
+static void rl_mem_journal_site(unsigned int id)
+{
+    if (id == 0)
+    {
+        return;
+    }
+    MEM_SITE_T *site = &g_mem_site[id - 1];
+    if (__atomic_load_n(&site->journaled, __ATOMIC_RELAXED) != 0 || __atomic_exchange_n(&site->journaled, 1, __ATOMIC_ACQ_REL) != 0)
+    {
+        return;
+    }
+    char record[sizeof(MEM_JOURNAL_SITE_T) + 512];
+    MEM_JOURNAL_SITE_T *head = (MEM_JOURNAL_SITE_T *)record;
+    size_t file_len = strnlen(site->file != NULL ? site->file : "", 255);
+    size_t func_len = strnlen(site->func != NULL ? site->func : "", 255);
+    char *str = record + sizeof(MEM_JOURNAL_SITE_T);
+    memcpy(str, site->file, file_len);
+    str[file_len] = '\0';
+    memcpy(str + file_len + 1, site->func, func_len);
+    str[file_len + 1 + func_len] = '\0';
+    head->head.magic = RL_MEM_JOURNAL_MAGIC;
+    head->head.type = RL_MEM_JOURNAL_TYPE_SITE;
+    head->head.reserved = 0;
+    head->head.len = sizeof(MEM_JOURNAL_SITE_T) + file_len + func_len + 2;
+    head->id = id;
+    head->line = site->line;
+    pthread_mutex_lock(&g_mem_journal_lock);
+    if (g_mem_journal_fd != -1 && write(g_mem_journal_fd, record, head->head.len) != (ssize_t)head->head.len)
+    {
+        rl_log_error("[%s:%s:%d] write memory journal failed", __FILENAME__, __FUNCTION__, __LINE__);
+    }
+    pthread_mutex_unlock(&g_mem_journal_lock);
+}
+
+// 打开分配事件日志并写入会话记录
+static int rl_mem_journal_open()
+{
+    char path[1024] = {0};
+    if (rl_mem_trace_file_path(path, sizeof(path), RL_MEM_JOURNAL_FILE_DIR, "bin") == RL_FAILED)
+    {
+        return RL_FAILED;
+    }
+    int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd == -1)
+    {
+        rl_log_error("[%s:%s:%d] open memory journal:%s failed", __FILENAME__, __FUNCTION__, __LINE__, path);
+        return RL_FAILED;
+    }
+    MEM_JOURNAL_SESSION_T session;
+    memset(&session, 0, sizeof(session));
+    session.head.magic = RL_MEM_JOURNAL_MAGIC;
+    session.head.type = RL_MEM_JOURNAL_TYPE_SESSION;
+    session.head.len = sizeof(session);
+    session.version = RL_MEM_JOURNAL_VERSION;
+    session.pid = getpid();
+    struct timespec real_ts;
+    struct timespec mono_ts;
+    clock_gettime(CLOCK_REALTIME, &real_ts);
+    clock_gettime(CLOCK_MONOTONIC, &mono_ts);
+    session.real_ns = (uint64_t)real_ts.tv_sec * 1000000000ULL + real_ts.tv_nsec;
+    session.mono_ns = (uint64_t)mono_ts.tv_sec * 1000000000ULL + mono_ts.tv_nsec;
+    rl_get_proc_name(session.proc_name, sizeof(session.proc_name));
+    if (write(fd, &session, sizeof(session)) != (ssize_t)sizeof(session))
+    {
+        rl_log_error("[%s:%s:%d] write memory journal:%s failed", __FILENAME__, __FUNCTION__, __LINE__, path);
+        close(fd);
+        return RL_FAILED;
+    }
+    // 新文件需要重新写入调用点
+    for (int i = 0; i < RL_MEM_TRACE_SITE_COUNT; i++)
+    {
+        __atomic_store_n(&g_mem_site[i].journaled, 0, __ATOMIC_RELAXED);
+    }
+    pthread_mutex_lock(&g_mem_journal_lock);
+    g_mem_journal_fd = fd;
+    pthread_mutex_unlock(&g_mem_journal_lock);
+    RL_LOGD("[%s:%s:%d] memory journal:%s", __FILENAME__, __FUNCTION__, __LINE__, path);
+    return RL_SUCCESS;
+}
+
+// 写出所有线程缓冲区中的事件并关闭日志（程序结束时调用，此时其他线程不应再分配内存）
+static void rl_mem_journal_close()
+{
+    pthread_mutex_lock(&g_mem_journal_lock);
+    for (MEM_JOURNAL_BUF_T *buf = g_mem_journal_header; buf != NULL; buf = buf->next)
+    {
+        rl_mem_journal_flush_locked(buf);
+    }
+    if (g_mem_journal_fd != -1)
+    {
+        close(g_mem_journal_fd);
+        g_mem_journal_fd = -1;
+    }
+    pthread_mutex_unlock(&g_mem_journal_lock);
+}
+
+// 输出一次分配/释放事件
+static void rl_mem_trace_event(unsigned char op, void *ptr, void *old_ptr, size_t size, const char *file, const char *func, int line,
+                               unsigned long long block_count, unsigned long long total_bytes)
+{
+    if (rl_memory_trace_output == RL_MEM_TRACE_OUTPUT_TEXT)
+    {
+        if (op == RL_MEM_EVENT_FREE)
+        {
+            RL_LOGD("[%s:%s:%d][free] addr=%p, remain blocks=%llu, remain bytes=%llu", file, func, line, ptr, block_count, total_bytes);
+        }
+        else if (op == RL_MEM_EVENT_REALLOC)
+        {
+            RL_LOGD("[%s:%s:%d][realloc] old=%p, new=%p, size=%zu, total blocks=%llu, total bytes=%llu", file, func, line, old_ptr, ptr, size, block_count, total_bytes);
+        }
+        else
+        {
+            static const char *name[] = {"", "malloc", "calloc", "free", "realloc", "aligned_alloc", "huge_alloc"};
+            RL_LOGD("[%s:%s:%d][%s] addr=%p(%zu bytes), total blocks=%llu, total bytes=%llu", file, func, line, name[op], ptr, size, block_count, total_bytes);
+        }
+        return;
+    }
+    if (rl_memory_trace_output != RL_MEM_TRACE_OUTPUT_JOURNAL || g_mem_journal_fd == -1)
+    {
+        return;
+    }
+    MEM_JOURNAL_BUF_T *buf = rl_mem_journal_buf();
+    if (buf == NULL)
+    {
+        return;
+    }
+    unsigned int site = rl_mem_site_id(file, func, line);
+    rl_mem_journal_site(site);
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    MEM_JOURNAL_EVENT_T *event = &buf->event[buf->count];
+    event->mono_ns = (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+    event->ptr = (uintptr_t)ptr;
+    event->old_ptr = (uintptr_t)old_ptr;
+    event->size = size;
+    event->site = site;
+    event->block_count = block_count;
+    event->total_bytes = total_bytes;
+    event->op = op;
+    memset(event->reserved, 0, sizeof(event->reserved));
+    if (++buf->count == RL_MEM_JOURNAL_BATCH)
+    {
+        pthread_mutex_lock(&g_mem_journal_lock);
+        rl_mem_journal_flush_locked(buf);
+        pthread_mutex_unlock(&g_mem_journal_lock);
+    }
+}
+
+// 保护页方式：每块内存单独映射，数据区按 16 字节对齐后紧挨末尾的保护页（PROT_NONE），越界写在出错的指令处触发 SIGSEGV
+// 对齐留下的不足 16 字节的空隙填充校验字节，释放时检查；释放后的内存块填充毒化字节并禁止访问，放入隔离区先进先出
+#define RL_MEM_GUARD_ALIGN      16
+#define RL_MEM_GUARD_CANARY     0xAB
+#define RL_MEM_GUARD_POISON     0xDD
+
+// 隔离区中的内存块（记录返回给调用者的地址和申请大小，映射区由两者计算）
+typedef struct
+{
+    void *ptr;
+    size_t size;
+} MEM_GUARD_QUARANTINE_T;
+
+// 保护页内存块登记表（记录申请大小）：rl_free 需要在检查头部之前识别，初始化后一直保留
+static MEM_SHARD_T g_mem_guard_shard[RL_MEM_TRACE_SHARD_COUNT];
+// 是否使用过保护页方式（一旦使用，之后的 rl_free/rl_realloc 都需要先查登记表）
+static bool rl_mem_guard_used = RL_FALSE;
+static size_t g_mem_guard_page = 0;
+// 隔离区环形队列（由 g_mem_guard_lock 保护）
+static pthread_mutex_t g_mem_guard_lock = PTHREAD_MUTEX_INITIALIZER;
+static MEM_GUARD_QUARANTINE_T g_mem_guard_quarantine[RL_MEM_GUARD_QUARANTINE_COUNT];
+static unsigned int g_mem_guard_quarantine_head = 0;
+static unsigned int g_mem_guard_quarantine_count = 0;
+static size_t g_mem_guard_quarantine_bytes = 0;
+static size_t g_mem_guard_quarantine_max = RL_MEM_GUARD_QUARANTINE_BYTES;
+
+static void rl_mem_guard_init()
+{
+    for (int i = 0; i < RL_MEM_TRACE_SHARD_COUNT; i++)
+    {
+        pthread_mutex_init(&g_mem_guard_shard[i].lock, NULL);
+        g_mem_guard_shard[i].table = NULL;
+        g_mem_guard_shard[i].capacity = 0;
+        g_mem_guard_shard[i].count = 0;
+    }
+    g_mem_guard_page = (size_t)sysconf(_SC_PAGESIZE);
+}
+
+// 计算内存块的映射区：数据区按页向上取整，之后是一页保护页
+static void rl_mem_guard_span(void *ptr, size_t size, char **base, size_t *data_len)
+{
+    size_t aligned = (size + RL_MEM_GUARD_ALIGN - 1) & ~(size_t)(RL_MEM_GUARD_ALIGN - 1);
+    *data_len = (aligned + g_mem_guard_page - 1) & ~(g_mem_guard_page - 1);
+    *base = (char *)ptr + aligned - *data_len;
+}
+
+// 解除隔离区中最早的内存块的映射（调用者需持有 g_mem_guard_lock）
+static void rl_mem_guard_evict_locked()
+{
+    MEM_GUARD_QUARANTINE_T *oldest = &g_mem_guard_quarantine[g_mem_guard_quarantine_head];
+    char *base = NULL;
+    size_t data_len = 0;
+    rl_mem_guard_span(oldest->ptr, oldest->size, &base, &data_len);
+    munmap(base, data_len + g_mem_guard_page);
+    g_mem_guard_quarantine_bytes -= data_len + g_mem_guard_page;
+    g_mem_guard_quarantine_head = (g_mem_guard_quarantine_head + 1) % RL_MEM_GUARD_QUARANTINE_COUNT;
+    g_mem_guard_quarantine_count--;
+}
+
+// 清空隔离区（程序结束时调用）
+static void rl_mem_guard_flush()
+{
+    pthread_mutex_lock(&g_mem_guard_lock);
+    while (g_mem_guard_quarantine_count > 0)
+    {
+        rl_mem_guard_evict_locked();
+    }
+    pthread_mutex_unlock(&g_mem_guard_lock);
+}
+
+// 设置内存分配跟踪方式（仅在开启跟踪之前调用）
+int rl_memory_trace_set_mode(RL_MEM_TRACE_MODE mode)
+{
+    if (mode != RL_MEM_TRACE_TABLE && mode != RL_MEM_TRACE_INLINE && mode != RL_MEM_TRACE_GUARD)
+    {
+        rl_log_error("[%s:%s:%d] mode=%d invalid", __FILENAME__, __FUNCTION__, __LINE__, mode);
+        return RL_FAILED;
+    }
+    if (rl_memory_trace_state == RL_TRUE)
+    {
+        rl_log_error("[%s:%s:%d] memory trace already enabled", __FILENAME__, __FUNCTION__, __LINE__);
+        return RL_FAILED;
+    }
+    rl_memory_trace_mode = mode;
+    return RL_SUCCESS;
+}
+
+// 设置分配事件输出方式（仅在开启跟踪之前调用）
+int rl_memory_trace_set_output(RL_MEM_TRACE_OUTPUT output)
+{
+    if (output != RL_MEM_TRACE_OUTPUT_JOURNAL && output != RL_MEM_TRACE_OUTPUT_TEXT && output != RL_MEM_TRACE_OUTPUT_NONE)
+    {
+        rl_log_error("[%s:%s:%d] output=%d invalid", __FILENAME__, __FUNCTION__, __LINE__, output);
+        return RL_FAILED;
+    }
+    if (rl_memory_trace_state == RL_TRUE)
+    {
+        rl_log_error("[%s:%s:%d] memory trace already enabled", __FILENAME__, __FUNCTION__, __LINE__);
+        return RL_FAILED;
+    }
+    rl_memory_trace_output = output;
+    return RL_SUCCESS;
+}
+
+// 设置保护页方式下隔离区最多保留的已释放字节数
+int rl_memory_guard_set_quarantine(size_t max_bytes)
+{
+    pthread_mutex_lock(&g_mem_guard_lock);
+    g_mem_guard_quarantine_max = max_bytes;
+    pthread_mutex_unlock(&g_mem_guard_lock);
+    return RL_SUCCESS;
+}
 
 // 仅程序初始化时调用
 void rl_memory_trace_init(bool state)
 {
-    if (rl_memory_trace_state == RL_TRUE)
+    if (rl_memory_trace_state == RL_TRUE)
+    {
+        RL_LOGD("[%s:%s:%d] alread enable memory trace", __FILENAME__, __FUNCTION__, __LINE__);
+        return;
+    }
+
+    if (state == RL_TRUE)
+    {
+        for (int i = 0; i < RL_MEM_TRACE_SHARD_COUNT; i++)
+        {
+            pthread_mutex_init(&g_mem_shard[i].lock, NULL);
+            g_mem_shard[i].table = NULL;
+            g_mem_shard[i].capacity = 0;
+            g_mem_shard[i].count = 0;
+        }
+        if (rl_memory_trace_mode == RL_MEM_TRACE_INLINE && rl_mem_inline_used == RL_FALSE)
+        {
+            rl_mem_inline_init();
+            __atomic_store_n(&rl_mem_inline_used, RL_TRUE, __ATOMIC_RELEASE);
+        }
+        if (rl_memory_trace_mode == RL_MEM_TRACE_GUARD && rl_mem_guard_used == RL_FALSE)
+        {
+            rl_mem_guard_init();
+            __atomic_store_n(&rl_mem_guard_used, RL_TRUE, __ATOMIC_RELEASE);
+        }
+        // 跟踪计数改为存放在 rlstat 指标中（只切换一次，之后重新开启跟踪继续累计）
+        pthread_once(&g_alloc_stat_once, rl_mem_alloc_stat_init);
+        if (rl_memory_trace_output == RL_MEM_TRACE_OUTPUT_JOURNAL && rl_mem_journal_open() == RL_FAILED)
+        {
+            rl_log_error("[%s:%s:%d] open memory journal failed, allocation events will not be recorded", __FILENAME__, __FUNCTION__, __LINE__);
+        }
+        rl_memory_trace_state = RL_TRUE;
+        RL_LOGD("[%s:%s:%d] enable memory trace", __FILENAME__, __FUNCTION__, __LINE__);
+    }
+    else
+    {
+        for (int i = 0; i < RL_MEM_TRACE_SHARD_COUNT; i++)
+        {
+            pthread_mutex_destroy(&g_mem_shard[i].lock);
+        }
+        rl_memory_trace_state = RL_FALSE;
+        RL_LOGD("[%s:%s:%d] disable memory trace", __FILENAME__, __FUNCTION__, __LINE__);
+    }
+}
+
+// 仅程序结束时调用（输出内存泄露情况到文件）
+int rl_memory_trace_deinit()
+{
+    if (rl_memory_trace_state == RL_FALSE)
+    {
+        RL_LOGD("[%s:%s:%d] not enabled memory trace", __FILENAME__, __FUNCTION__, __LINE__);
+        return RL_FAILED;
+    }
+    // 获取日志路径
+    char path[1024] = {0};
+    if (rl_mem_trace_file_path(path, sizeof(path), RL_MEM_TRACE_LOG_FILE_DIR, "log") == RL_FAILED)
+    {
+        return RL_FAILED;
+    }
+    // 获取时间
+    rl_time_t time;
+    if (rl_get_time(&time) == RL_FAILED)
+    {
+        rl_log_error("[%s:%s:%d] get time failed", __FILENAME__, __FUNCTION__, __LINE__);
+        return RL_FAILED;
+    }
+    FILE *fp = fopen(path, "w");
+    if (fp == NULL)
+    {
+        RL_LOGD("[%s:%s:%d] open memory trace file:%s failed", __FILENAME__, __FUNCTION__, __LINE__, path);
+        return RL_FAILED;
+    }
+
+    fprintf(fp, "==== Memory Leak Report ====\n");
+    fprintf(fp, "%04d-%02d-%02d %02d:%02d:%02d\n", time.tm_year + 1900, time.tm_mon + 1, time.tm_mday, time.tm_hour, time.tm_min, time.tm_sec);
+    RL_LOGD("[%s:%s:%d] ==== Memory Leak Report ====", __FILENAME__, __FUNCTION__, __LINE__);
+    unsigned int leak_count = 0;
+    unsigned long long leak_bytes = 0;
+
+    // 遍历所有分片输出未释放的记录，并释放跟踪表
+    for (int i = 0; i < RL_MEM_TRACE_SHARD_COUNT; i++)
+    {
+        MEM_SHARD_T *shard = &g_mem_shard[i];
+        pthread_mutex_lock(&shard->lock);
+        for (unsigned int j = 0; j < shard->capacity; j++)
+        {
+            MEM_NODE_T *node = &shard->table[j];
+            if (node->ptr == NULL)
+            {
+                continue;
+            }
+            fprintf(fp, "[LEAK] %p (%zu bytes) from %s:%s:%d\n", node->ptr, node->size, node->file, node->func, node->line);
+            RL_LOGD("[%s:%s:%d] [LEAK] %p (%zu bytes) from %s:%s:%d", __FILENAME__, __FUNCTION__, __LINE__, node->ptr, node->size, node->file, node->func, node->line);
+            leak_count++;
+            leak_bytes += node->size;
+        }
+        free(shard->table);
+        shard->table = NULL;
+        shard->capacity = 0;
+        shard->count = 0;
+        pthread_mutex_unlock(&shard->lock);
+        pthread_mutex_destroy(&shard->lock);
+    }
+    // 头部跟踪方式：遍历分片链表（链表保留，泄露的内存块之后仍可能被释放）
+    for (int i = 0; rl_mem_inline_used == RL_TRUE && i < RL_MEM_TRACE_SHARD_COUNT; i++)
+    {
+        MEM_INLINE_SHARD_T *shard = &g_mem_inline_shard[i];
+        pthread_mutex_lock(&shard->lock);
+        for (MEM_INLINE_HDR_T *hdr = shard->head; hdr != NULL; hdr = hdr->next)
+        {
+            const MEM_SITE_T *site = rl_mem_site_get(hdr->site);
+            const char *site_file = (site != NULL) ? site->file : "unknown";
+            const char *site_func = (site != NULL) ? site->func : "unknown";
+            int site_line = (site != NULL) ? site->line : 0;
+            fprintf(fp, "[LEAK] %p (%zu bytes) from %s:%s:%d\n", (void *)(hdr + 1), (size_t)hdr->size, site_file, site_func, site_line);
+            RL_LOGD("[%s:%s:%d] [LEAK] %p (%zu bytes) from %s:%s:%d", __FILENAME__, __FUNCTION__, __LINE__, (void *)(hdr + 1), (size_t)hdr->size, site_file, site_func, site_line);
+            leak_count++;
+            leak_bytes += hdr->size;
+        }
+        pthread_mutex_unlock(&shard->lock);
+    }
+    // 对象池：按对象池统计未归还的对象
+    pthread_mutex_lock(&g_pool_lock);
+    for (rl_pool_t *pool = g_pool_header; pool != NULL; pool = pool->next)
+    {
+        pthread_mutex_lock(&pool->lock);
+        unsigned int in_use = rl_pool_in_use_locked(pool);
+        pthread_mutex_unlock(&pool->lock);
+        if (in_use == 0)
+        {
+            continue;
+        }
+        fprintf(fp, "[LEAK] pool %s: %u objects (%u bytes each) not returned\n", pool->name, in_use, pool->obj_size);
+        RL_LOGD("[%s:%s:%d] [LEAK] pool %s: %u objects (%u bytes each) not returned", __FILENAME__, __FUNCTION__, __LINE__, pool->name, in_use, pool->obj_size);
+        leak_count += in_use;
+        leak_bytes += (unsigned long long)in_use * pool->obj_size;
+    }
+    pthread_mutex_unlock(&g_pool_lock);
+    // 如果没有内存泄露
+    if (leak_count == 0)
+    {
+        fprintf(fp, "No leaks detected\n");
+        RL_LOGD("[%s:%s:%d] No leaks detected", __FILENAME__, __FUNCTION__, __LINE__);
+    }
+    // 如果发生内存泄露
+    else
+    {
+        fprintf(fp, "Total leaks: %u blocks, %llu bytes\n", leak_count, leak_bytes);
+        RL_LOGD("[%s:%s:%d] Total leaks: %u blocks, %llu bytes", __FILENAME__, __FUNCTION__, __LINE__, leak_count, leak_bytes);
+    }
+
+    fprintf(fp, "============================\n");
+    RL_LOGD("[%s:%s:%d] ============================", __FILENAME__, __FUNCTION__, __LINE__);
+    fclose(fp);
+
+    RL_LOGD("[%s:%s:%d] memory trace complete, Leaks: %u blocks, %llu bytes",__FILENAME__, __FUNCTION__, __LINE__, leak_count, leak_bytes);
+
+    rl_memory_trace_state = RL_FALSE;
+    rl_mem_journal_close();
+    rl_mem_guard_flush();
+    return RL_SUCCESS;
+}
+
+// 采样分析：按调用栈汇总的采样记录（编号从 1 开始，存放在采样跟踪表记录的 site 字段）
+typedef struct
+{
+    uint64_t hash;
+    const char *file;
+    const char *func;
+    int line;
+    int depth;
+    void *stack[RL_MEM_SAMPLE_DEPTH];
+    unsigned long long alloc_count;
+    unsigned long long alloc_bytes;
+    unsigned long long free_count;
+    unsigned long long free_bytes;
+} MEM_SAMPLE_STACK_T;
+
+// 平均采样间隔（0 表示未开启采样），输出文件中记录最近一次开启时的间隔
+static unsigned int g_mem_sample_interval = 0;
+static unsigned int g_mem_sample_rate = 0;
+// 采样内存块的跟踪表（与全量跟踪表独立，首次开启采样时初始化，之后一直保留）
+static MEM_SHARD_T g_mem_sample_shard[RL_MEM_TRACE_SHARD_COUNT];
+static bool g_mem_sample_inited = RL_FALSE;
+// 调用栈表（由 g_mem_sample_lock 保护）
+static MEM_SAMPLE_STACK_T g_mem_sample_stack[RL_MEM_SAMPLE_STACK_COUNT];
+static unsigned long long g_mem_sample_dropped = 0;
+static pthread_mutex_t g_mem_sample_lock = PTHREAD_MUTEX_INITIALIZER;
+// 计数过滤器：按指针哈希统计未释放的采样内存块，释放时计数为 0 就不用查采样跟踪表
+static unsigned int g_mem_sample_filter[RL_MEM_SAMPLE_FILTER_SIZE];
+// 本线程距离下一个采样点的字节数和随机数状态
+static __thread long long rl_mem_sample_left = 0;
+static __thread uint64_t rl_mem_sample_rng = 0;
+// 跳过的调用栈层数（rl_mem_sample_record 和 rl_malloc 等入口函数）
+#define RL_MEM_SAMPLE_SKIP      2
+
+static unsigned int *rl_mem_sample_filter(const void *ptr)
+{
+    return &g_mem_sample_filter[(rl_mem_hash(ptr) >> 48) & (RL_MEM_SAMPLE_FILTER_SIZE - 1)];
+}
+
+// 生成下一个采样间隔：服从均值为 interval 的指数分布，采样点在分配的字节流上构成泊松过程
+static long long rl_mem_sample_next(unsigned int interval)
+{
+    uint64_t x = rl_mem_sample_rng;
+    if (x == 0)
+    {
+        x = rl_mem_hash(&rl_mem_sample_rng) | 1;
+    }
+    x ^= x >> 12;
+    x ^= x << 25;
+    x ^= x >> 27;
+    rl_mem_sample_rng = x;
+    // 26 位均匀随机数 q ∈ [1, 2^26]，间隔 = -ln(q / 2^26) * interval = (26 - log2(q)) * ln2 * interval
+    // log2 的小数部分用三次多项式近似（误差约 0.0013），避免依赖 libm
+    uint64_t q = ((x * 0x2545F4914F6CDD1DULL) >> 38) + 1;
+    int exp = 63 - __builtin_clzll(q);
+    double f = (double)q / (double)(1ULL << exp) - 1.0;
+    double log2_q = exp + f * (1.4234853 + f * (-0.5877338 + f * 0.1655588));
+    long long next = (long long)((26.0 - log2_q) * 0.6931471805599453 * interval);
+    return (next < 1) ? 1 : next;
+}
+
+// 记录一次采样（不内联，保证需要跳过的调用栈层数固定）
+static void __attribute__((noinline)) rl_mem_sample_record(void *ptr, size_t size, const char *file, const char *func, int line)
+{
+    void *stack[RL_MEM_SAMPLE_DEPTH + RL_MEM_SAMPLE_SKIP];
+    int depth = backtrace(stack, RL_MEM_SAMPLE_DEPTH + RL_MEM_SAMPLE_SKIP) - RL_MEM_SAMPLE_SKIP;
+    if (depth < 0)
+    {
+        depth = 0;
+    }
+    uint64_t hash = rl_mem_hash((const void *)((uintptr_t)file ^ (uintptr_t)line));
+    for (int i = 0; i < depth; i++)
+    {
+        hash = rl_mem_hash((const void *)(hash ^ (uintptr_t)stack[RL_MEM_SAMPLE_SKIP + i]));
+    }
+
+    pthread_mutex_lock(&g_mem_sample_lock);
+    MEM_SAMPLE_STACK_T *bucket = NULL;
+    for (unsigned int probe = 0; probe < RL_MEM_SAMPLE_STACK_COUNT; probe++)
+    {
+        MEM_SAMPLE_STACK_T *entry = &g_mem_sample_stack[(hash + probe) & (RL_MEM_SAMPLE_STACK_COUNT - 1)];
+        // 空槽位：登记新的调用栈
+        if (entry->alloc_count == 0)
+        {
+            entry->hash = hash;
+            entry->file = file;
+            entry->func = func;
+            entry->line = line;
+            entry->depth = depth;
+            memcpy(entry->stack, &stack[RL_MEM_SAMPLE_SKIP], depth * sizeof(void *));
+            bucket = entry;
+            break;
+        }
+        if (entry->hash == hash && entry->depth == depth && entry->line == line && entry->file == file && entry->func == func &&
+            memcmp(entry->stack, &stack[RL_MEM_SAMPLE_SKIP], depth * sizeof(void *)) == 0)
+        {
+            bucket = entry;
+            break;
+        }
+    }
+    if (bucket == NULL)
+    {
+        g_mem_sample_dropped++;
+        pthread_mutex_unlock(&g_mem_sample_lock);
+        return;
+    }
+    bucket->alloc_count++;
+    bucket->alloc_bytes += size;
+    unsigned int id = (unsigned int)(bucket - g_mem_sample_stack) + 1;
+    pthread_mutex_unlock(&g_mem_sample_lock);
+
+    if (rl_mem_track_insert(g_mem_sample_shard, ptr, size, file, func, line, id) == RL_FAILED)
+    {
+        // 无法跟踪释放，直接按已释放处理，避免一直显示为未释放
+        pthread_mutex_lock(&g_mem_sample_lock);
+        bucket->free_count++;
+        bucket->free_bytes += size;
+        pthread_mutex_unlock(&g_mem_sample_lock);
+        return;
+    }
+    __atomic_add_fetch(rl_mem_sample_filter(ptr), 1, __ATOMIC_RELAXED);
+}
+
+// 分配成功后调用：统计本线程分配的字节数，到达采样点时记录
+static inline __attribute__((always_inline)) void rl_mem_sample_alloc(void *ptr, size_t size, const char *file, const char *func, int line)
+{
+    unsigned int interval = __atomic_load_n(&g_mem_sample_interval, __ATOMIC_RELAXED);
+    if (interval == 0)
+    {
+        return;
+    }
+    rl_mem_sample_left -= (long long)size;
+    if (rl_mem_sample_left > 0)
+    {
+        return;
+    }
+    // 线程第一次到达时先随机一个间隔，否则每个线程的第一次分配都会被采样
+    if (rl_mem_sample_rng == 0)
+    {
+        rl_mem_sample_left += rl_mem_sample_next(interval);
+        if (rl_mem_sample_left > 0)
+        {
+            return;
+        }
+    }
+    rl_mem_sample_left = rl_mem_sample_next(interval);
+    rl_mem_sample_record(ptr, size, file, func, line);
+}
+
+// 释放前调用：如果是采样的内存块则记录释放
+static void rl_mem_sample_release(void *ptr)
+{
+    unsigned int *filter = rl_mem_sample_filter(ptr);
+    if (__atomic_load_n(filter, __ATOMIC_RELAXED) == 0)
+    {
+        return;
+    }
+    MEM_NODE_T node;
+    if (rl_mem_track_remove(g_mem_sample_shard, ptr, &node) == RL_FAILED)
+    {
+        return;
+    }
+    __atomic_sub_fetch(filter, 1, __ATOMIC_RELAXED);
+    pthread_mutex_lock(&g_mem_sample_lock);
+    MEM_SAMPLE_STACK_T *bucket = &g_mem_sample_stack[node.site - 1];
+    bucket->free_count++;
+    bucket->free_bytes += node.size;
+    pthread_mutex_unlock(&g_mem_sample_lock);
+}
+
+// 在跟踪表中记录一次分配（未开启跟踪时直接返回成功）
+static int rl_mem_track_alloc(unsigned char op, void *ptr, size_t size, const char *file, const char *func, int line)
+{
+    if (rl_memory_trace_state == RL_FALSE)
+    {
+        return RL_SUCCESS;
+    }
+    unsigned int site = rl_mem_site_id(file, func, line);
+    if (rl_mem_track_insert(g_mem_shard, ptr, size, file, func, line, site) == RL_FAILED)
+    {
+        rl_log_error("[%s:%s:%d] memory trace record ptr=%p failed", __FILENAME__, __FUNCTION__, __LINE__, ptr);
+        return RL_FAILED;
+    }
+    rl_mem_site_alloc(site, size);
+    // 记录总分配内存
+    unsigned long long block_count = __atomic_add_fetch(rl_mem_block_counter(), 1, __ATOMIC_RELAXED);
+    unsigned long long total_bytes = __atomic_add_fetch(rl_mem_bytes_counter(), size, __ATOMIC_RELAXED);
+    rl_mem_trace_event(op, ptr, NULL, size, file, func, line, block_count, total_bytes);
+    return RL_SUCCESS;
+}
+
+// 从跟踪表删除一次分配（未开启跟踪时直接返回成功）
+static int rl_mem_track_free(void *ptr, const char *file, const char *func, int line)
+{
+    if (rl_memory_trace_state == RL_FALSE)
+    {
+        return RL_SUCCESS;
+    }
+    MEM_NODE_T node;
+    if (rl_mem_track_remove(g_mem_shard, ptr, &node) == RL_FAILED)
+    {
+        rl_log_warn("[%s:%s:%d] ptr=%p not found in trace list, maybe double free or external malloc", file, func, line, ptr);
+        return RL_FAILED;
+    }
+    // 统计释放的内存
+    rl_mem_site_free(node.site, node.size);
+    unsigned long long block_count = __atomic_sub_fetch(rl_mem_block_counter(), 1, __ATOMIC_RELAXED);
+    unsigned long long total_bytes = __atomic_sub_fetch(rl_mem_bytes_counter(), node.size, __ATOMIC_RELAXED);
+    rl_mem_trace_event(RL_MEM_EVENT_FREE, ptr, NULL, 0, file, func, line, block_count, total_bytes);
+    return RL_SUCCESS;
+}
+
+// 按 align 对齐映射 size 字节（size 必须为页大小的倍数，为 align 的倍数时才能完整使用大页），并建议内核使用透明大页
+static void *rl_mem_map_huge(size_t size, size_t align)
+{
+    // 多映射一个 align 再裁掉首尾，得到对齐的区域
+    char *addr = (char *)mmap(NULL, size + align, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (addr == MAP_FAILED)
+    {
+        return NULL;
+    }
+    char *start = (char *)(((uintptr_t)addr + align - 1) & ~(uintptr_t)(align - 1));
+    if (start > addr)
+    {
+        munmap(addr, start - addr);
+    }
+    if (start + size < addr + size + align)
+    {
+        munmap(start + size, addr + size + align - (start + size));
+    }
+#ifdef MADV_HUGEPAGE
+    // 内核不支持透明大页时仍可使用普通页
+    madvise(start, size, MADV_HUGEPAGE);
+#endif
+    return start;
+}
+
+// 大页分配登记表（记录映射大小）：rl_free 需要识别 rl_huge_alloc 返回的地址，与是否开启跟踪无关
+static MEM_SHARD_T g_mem_huge_shard[RL_MEM_TRACE_SHARD_COUNT];
+static pthread_once_t g_mem_huge_once = PTHREAD_ONCE_INIT;
+static unsigned long long g_mem_huge_count = 0;
+static size_t g_mem_page_size = 0;
+
+static void rl_mem_huge_init()
+{
+    for (int i = 0; i < RL_MEM_TRACE_SHARD_COUNT; i++)
+    {
+        pthread_mutex_init(&g_mem_huge_shard[i].lock, NULL);
+        g_mem_huge_shard[i].table = NULL;
+        g_mem_huge_shard[i].capacity = 0;
+        g_mem_huge_shard[i].count = 0;
+    }
+    g_mem_page_size = (size_t)sysconf(_SC_PAGESIZE);
+}
+
+// 是否可能是大页分配的地址（都按页对齐，没有大页分配或地址未按页对齐时不用查表）
+static inline bool rl_mem_huge_maybe(const void *ptr)
+{
+    return __atomic_load_n(&g_mem_huge_count, __ATOMIC_ACQUIRE) != 0 && ((uintptr_t)ptr & (g_mem_page_size - 1)) == 0;
+}
+
+// 如果 ptr 是大页分配的内存块，通过 map_size 返回映射大小
+static int rl_mem_huge_find(void *ptr, size_t *map_size)
+{
+    MEM_NODE_T node;
+    if (rl_mem_huge_maybe(ptr) == RL_FALSE || rl_mem_track_find(g_mem_huge_shard, ptr, &node) == RL_FAILED)
+    {
+        return RL_FAILED;
+    }
+    *map_size = node.size;
+    return RL_SUCCESS;
+}
+
+// 如果 ptr 是大页分配的内存块，从登记表删除并通过 map_size 返回映射大小
+static int rl_mem_huge_remove(void *ptr, size_t *map_size)
+{
+    MEM_NODE_T node;
+    if (rl_mem_huge_maybe(ptr) == RL_FALSE || rl_mem_track_remove(g_mem_huge_shard, ptr, &node) == RL_FAILED)
+    {
+        return RL_FAILED;
+    }
+    __atomic_sub_fetch(&g_mem_huge_count, 1, __ATOMIC_RELAXED);
+    *map_size = node.size;
+    return RL_SUCCESS;
+}
+
+// 如果 ptr 是保护页方式分配的内存块，通过 size 返回申请大小
+static int rl_mem_guard_find(void *ptr, size_t *size)
+{
+    MEM_NODE_T node;
+    if (__atomic_load_n(&rl_mem_guard_used, __ATOMIC_ACQUIRE) == RL_FALSE || rl_mem_track_find(g_mem_guard_shard, ptr, &node) == RL_FAILED)
+    {
+        return RL_FAILED;
+    }
+    *size = node.size;
+    return RL_SUCCESS;
+}
+
+// 如果 ptr 是保护页方式分配的内存块，从登记表删除并通过 size 返回申请大小
+static int rl_mem_guard_remove(void *ptr, size_t *size)
+{
+    MEM_NODE_T node;
+    if (__atomic_load_n(&rl_mem_guard_used, __ATOMIC_ACQUIRE) == RL_FALSE || rl_mem_track_remove(g_mem_guard_shard, ptr, &node) == RL_FAILED)
+    {
+        return RL_FAILED;
+    }
+    *size = node.size;
+    return RL_SUCCESS;
+}
+
+// 保护页方式分配（映射区本身为 0，calloc 无需再清零）
+static void *rl_mem_guard_alloc(unsigned char op, size_t size, const char *file, const char *func, int line)
+{
+    if (size > SIZE_MAX - 2 * g_mem_guard_page - RL_MEM_GUARD_ALIGN)
+    {
+        rl_log_error("[%s:%s:%d] size=%zu too large", __FILENAME__, __FUNCTION__, __LINE__, size);
+        return NULL;
+    }
+    size_t aligned = (size + RL_MEM_GUARD_ALIGN - 1) & ~(size_t)(RL_MEM_GUARD_ALIGN - 1);
+    size_t data_len = (aligned + g_mem_guard_page - 1) & ~(g_mem_guard_page - 1);
+    char *base = (char *)mmap(NULL, data_len + g_mem_guard_page, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (base == MAP_FAILED)
+    {
+        rl_log_error("[%s:%s:%d] mmap=%zu bytes failed", __FILENAME__, __FUNCTION__, __LINE__, data_len + g_mem_guard_page);
+        return NULL;
+    }
+    if (mprotect(base + data_len, g_mem_guard_page, PROT_NONE) != 0)
+    {
+        rl_log_error("[%s:%s:%d] mprotect guard page failed, errno=%d", __FILENAME__, __FUNCTION__, __LINE__, errno);
+        munmap(base, data_len + g_mem_guard_page);
+        return NULL;
+    }
+    char *ptr = base + data_len - aligned;
+    memset(ptr + size, RL_MEM_GUARD_CANARY, aligned - size);
+    if (rl_mem_track_insert(g_mem_guard_shard, ptr, size, file, func, line, 0) == RL_FAILED)
+    {
+        rl_log_error("[%s:%s:%d] guard alloc record ptr=%p failed", __FILENAME__, __FUNCTION__, __LINE__, (void *)ptr);
+        munmap(base, data_len + g_mem_guard_page);
+        return NULL;
+    }
+    if (rl_mem_track_alloc(op, ptr, size, file, func, line) == RL_FAILED)
+    {
+        MEM_NODE_T node;
+        rl_mem_track_remove(g_mem_guard_shard, ptr, &node);
+        munmap(base, data_len + g_mem_guard_page);
+        return NULL;
+    }
+    rl_mem_sample_alloc(ptr, size, file, func, line);
+    return ptr;
+}
+
+// 保护页方式释放：检查校验字节，填充毒化字节后禁止访问，放入隔离区，隔离区超出限制时解除最早的映射
+static void rl_mem_guard_release(void *ptr, size_t size, const char *file, const char *func, int line)
+{
+    char *base = NULL;
+    size_t data_len = 0;
+    rl_mem_guard_span(ptr, size, &base, &data_len);
+    size_t aligned = (size + RL_MEM_GUARD_ALIGN - 1) & ~(size_t)(RL_MEM_GUARD_ALIGN - 1);
+    const unsigned char *tail = (const unsigned char *)ptr + size;
+    for (size_t i = 0; i < aligned - size; i++)
+    {
+        if (tail[i] != RL_MEM_GUARD_CANARY)
+        {
+            rl_log_error("[%s:%s:%d] ptr=%p (%zu bytes) overrun detected at offset %zu", file, func, line, ptr, size, size + i);
+            break;
+        }
+    }
+    // 毒化字节便于在 core 文件中识别已释放的内存
+    memset(ptr, RL_MEM_GUARD_POISON, aligned);
+    mprotect(base, data_len, PROT_NONE);
+
+    pthread_mutex_lock(&g_mem_guard_lock);
+    if (g_mem_guard_quarantine_max == 0)
+    {
+        pthread_mutex_unlock(&g_mem_guard_lock);
+        munmap(base, data_len + g_mem_guard_page);
+        return;
+    }
+    if (g_mem_guard_quarantine_count == RL_MEM_GUARD_QUARANTINE_COUNT)
+    {
+        rl_mem_guard_evict_locked();
+    }
+    MEM_GUARD_QUARANTINE_T *entry = &g_mem_guard_quarantine[(g_mem_guard_quarantine_head + g_mem_guard_quarantine_count) % RL_MEM_GUARD_QUARANTINE_COUNT];
+    entry->ptr = ptr;
+    entry->size = size;
+    g_mem_guard_quarantine_count++;
+    g_mem_guard_quarantine_bytes += data_len + g_mem_guard_page;
+    // 超出字节数限制时解除最早的映射（至少保留刚放入的一块）
+    while (g_mem_guard_quarantine_bytes > g_mem_guard_quarantine_max && g_mem_guard_quarantine_count > 1)
+    {
+        rl_mem_guard_evict_locked();
+    }
+    pthread_mutex_unlock(&g_mem_guard_lock);
+}
+
+// ptr 是否在隔离区中（用于区分重复释放，只在登记表中找不到时调用）
+static bool rl_mem_guard_quarantined(const void *ptr)
+{
+    bool found = RL_FALSE;
+    pthread_mutex_lock(&g_mem_guard_lock);
+    for (unsigned int i = 0; i < g_mem_guard_quarantine_count; i++)
+    {
+        if (g_mem_guard_quarantine[(g_mem_guard_quarantine_head + i) % RL_MEM_GUARD_QUARANTINE_COUNT].ptr == ptr)
+        {
+            found = RL_TRUE;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&g_mem_guard_lock);
+    return found;
+}
+
+void *rl_malloc(size_t size, const char *file, const char *func, int line)
+{
+    if (size == 0)
+    {
+        rl_log_error("[%s:%s:%d] size=%zu invalid", __FILENAME__, __FUNCTION__, __LINE__, size);
+        return NULL;
+    }
+    // 头部跟踪方式：多分配一个头部记录大小和调用点
+    if (rl_memory_trace_state == RL_TRUE && rl_memory_trace_mode == RL_MEM_TRACE_INLINE)
+    {
+        if (size > RL_MEM_INLINE_SIZE_MAX)
+        {
+            rl_log_error("[%s:%s:%d] size=%zu too large", __FILENAME__, __FUNCTION__, __LINE__, size);
+            return NULL;
+        }
+        void *raw = malloc(sizeof(MEM_INLINE_HDR_T) + size);
+        if (raw == NULL)
+        {
+            rl_log_error("[%s:%s:%d] malloc=%zu bytes failed", __FILENAME__, __FUNCTION__, __LINE__, size);
+            return NULL;
+        }
+        unsigned int site = rl_mem_site_id(file, func, line);
+        void *ptr = rl_mem_inline_link(raw, size, site);
+        rl_mem_site_alloc(site, size);
+        unsigned long long block_count = __atomic_add_fetch(rl_mem_block_counter(), 1, __ATOMIC_RELAXED);
+        unsigned long long total_bytes = __atomic_add_fetch(rl_mem_bytes_counter(), size, __ATOMIC_RELAXED);
+        rl_mem_trace_event(RL_MEM_EVENT_MALLOC, ptr, NULL, size, file, func, line, block_count, total_bytes);
+        rl_mem_sample_alloc(ptr, size, file, func, line);
+        return ptr;
+    }
+    if (rl_memory_trace_state == RL_TRUE && rl_memory_trace_mode == RL_MEM_TRACE_GUARD)
+    {
+        return rl_mem_guard_alloc(RL_MEM_EVENT_MALLOC, size, file, func, line);
+    }
+    // 尝试分配内存
+    void *ptr = malloc(size);
+    if (ptr == NULL)
+    {
+        rl_log_error("[%s:%s:%d] malloc=%zu bytes failed", __FILENAME__, __FUNCTION__, __LINE__, size);
+        return NULL;
+    }
+    // 如果启用内存分配跟踪，跟踪表记录本次的内存分配
+    if (rl_mem_track_alloc(RL_MEM_EVENT_MALLOC, ptr, size, file, func, line) == RL_FAILED)
+    {
+        free(ptr);
+        return NULL;
+    }
+    rl_mem_sample_alloc(ptr, size, file, func, line);
+    return ptr;
+}
+
+int rl_free(void *ptr, const char *file, const char *func, int line)
+{
+    if (ptr == NULL)
+    {
+        rl_log_error("[%s:%s:%d] free failed, ptr is null", __FILENAME__, __FUNCTION__, __LINE__);
+        return RL_FAILED;
+    }
+    // 大页分配的内存块（需在检查头部之前，映射区之前的地址可能不可读）
+    size_t map_size = 0;
+    if (rl_mem_huge_remove(ptr, &map_size) == RL_SUCCESS)
+    {
+        rl_mem_track_free(ptr, file, func, line);
+        rl_mem_sample_release(ptr);
+        munmap(ptr, map_size);
+        return RL_SUCCESS;
+    }
+    // 保护页方式分配的内存块（同样需在检查头部之前，页首地址之前可能是保护页或已解除的映射）
+    size_t guard_size = 0;
+    if (rl_mem_guard_remove(ptr, &guard_size) == RL_SUCCESS)
+    {
+        rl_mem_track_free(ptr, file, func, line);
+        rl_mem_sample_release(ptr);
+        rl_mem_guard_release(ptr, guard_size, file, func, line);
+        return RL_SUCCESS;
+    }
+    if (rl_mem_guard_used == RL_TRUE && rl_mem_guard_quarantined(ptr) == RL_TRUE)
+    {
+        rl_log_warn("[%s:%s:%d] ptr=%p already freed (in quarantine), double free", file, func, line, ptr);
+        return RL_FAILED;
+    }
+    // 带头部的内存块：直接从头部取得记录
+    bool freed = RL_FALSE;
+    MEM_INLINE_HDR_T *hdr = rl_mem_inline_hdr(ptr, &freed);
+    if (hdr != NULL)
+    {
+        rl_mem_inline_unlink(hdr);
+        rl_mem_site_free(hdr->site, hdr->size);
+        unsigned long long block_count = __atomic_sub_fetch(rl_mem_block_counter(), 1, __ATOMIC_RELAXED);
+        unsigned long long total_bytes = __atomic_sub_fetch(rl_mem_bytes_counter(), hdr->size, __ATOMIC_RELAXED);
+        rl_mem_trace_event(RL_MEM_EVENT_FREE, ptr, NULL, 0, file, func, line, block_count, total_bytes);
+        // 标记为已释放用于发现重复释放（volatile 防止编译器认为 free 前的写入无用而删除）
+        *(volatile uint64_t *)&hdr->magic = RL_MEM_INLINE_FREED ^ (uintptr_t)hdr;
+        rl_mem_sample_release(ptr);
+        free(hdr);
+        return RL_SUCCESS;
+    }
+    if (freed == RL_TRUE)
+    {
+        rl_log_warn("[%s:%s:%d] ptr=%p already freed, double free", file, func, line, ptr);
+        return RL_FAILED;
+    }
+
+    // 如果启用内存分配跟踪，跟踪表删除本次释放的内存
+    if (rl_mem_track_free(ptr, file, func, line) == RL_FAILED)
+    {
+        return RL_FAILED;
+    }
+    // 释放实际的内存
+    rl_mem_sample_release(ptr);
+    free(ptr);
+    return RL_SUCCESS;
+}
+
+void *rl_calloc(size_t block, size_t count, const char *file, const char *func, int line)
+{
+    if (block == 0 || count == 0)
+    {
+        rl_log_error("[%s:%s:%d] block=%zu or count=%zu invalid", __FILENAME__, __FUNCTION__, __LINE__, block, count);
+        return NULL;
+    }
+    size_t size;
+    if (__builtin_mul_overflow(block, count, &size))
+    {
+        rl_log_error("[%s:%s:%d] block=%zu count=%zu overflow", __FILENAME__, __FUNCTION__, __LINE__, block, count);
+        return NULL;
+    }
+    // 头部跟踪方式：多分配一个头部记录大小和调用点
+    if (rl_memory_trace_state == RL_TRUE && rl_memory_trace_mode == RL_MEM_TRACE_INLINE)
+    {
+        if (size > RL_MEM_INLINE_SIZE_MAX)
+        {
+            rl_log_error("[%s:%s:%d] size=%zu too large", __FILENAME__, __FUNCTION__, __LINE__, size);
+            return NULL;
+        }
+        void *raw = calloc(1, sizeof(MEM_INLINE_HDR_T) + size);
+        if (raw == NULL)
+        {
+            rl_log_error("[%s:%s:%d] calloc=%zu bytes failed", __FILENAME__, __FUNCTION__, __LINE__, size);
+            return NULL;
+        }
+        unsigned int site = rl_mem_site_id(file, func, line);
+        void *ptr = rl_mem_inline_link(raw, size, site);
+        rl_mem_site_alloc(site, size);
+        unsigned long long block_count = __atomic_add_fetch(rl_mem_block_counter(), 1, __ATOMIC_RELAXED);
+        unsigned long long total_bytes = __atomic_add_fetch(rl_mem_bytes_counter(), size, __ATOMIC_RELAXED);
+        rl_mem_trace_event(RL_MEM_EVENT_CALLOC, ptr, NULL, size, file, func, line, block_count, total_bytes);
+        rl_mem_sample_alloc(ptr, size, file, func, line);
+        return ptr;
+    }
+    if (rl_memory_trace_state == RL_TRUE && rl_memory_trace_mode == RL_MEM_TRACE_GUARD)
+    {
+        return rl_mem_guard_alloc(RL_MEM_EVENT_CALLOC, size, file, func, line);
+    }
+    // 分配内存
+    void *ptr = calloc(block, count);
+    if (ptr == NULL)
+    {
+        rl_log_error("[%s:%s:%d] calloc=%zu bytes failed", __FILENAME__, __FUNCTION__, __LINE__, size);
+        return NULL;
+    }
+
+    // 如果启用内存分配跟踪，跟踪表记录本次的内存分配
+    if (rl_mem_track_alloc(RL_MEM_EVENT_CALLOC, ptr, size, file, func, line) == RL_FAILED)
+    {
+        free(ptr);
+        return NULL;
+    }
+    rl_mem_sample_alloc(ptr, size, file, func, line);
+    return ptr;
+}
+
+void *rl_realloc(void *ptr, size_t size, const char *file, const char *func, int line)
+{
+    if (size == 0)
+    {
+        rl_log_error("[%s:%s:%d] size=0, invalid realloc", __FILENAME__, __FUNCTION__, __LINE__);
+        return NULL;
+    }
+    if (ptr == NULL)
+    {
+        return rl_malloc(size, file, func, line);
+    }
+    // 大页分配的内存块：重新分配大页内存并复制
+    size_t map_size = 0;
+    if (rl_mem_huge_find(ptr, &map_size) == RL_SUCCESS)
+    {
+        void *new_ptr = rl_huge_alloc(size, file, func, line);
+        if (new_ptr == NULL)
+        {
+            return NULL;
+        }
+        memcpy(new_ptr, ptr, (map_size < size) ? map_size : size);
+        rl_free(ptr, file, func, line);
+        return new_ptr;
+    }
+    // 保护页方式分配的内存块：总是分配新的内存块并复制，原内存块进入隔离区，继续使用旧地址会立即出错
+    size_t guard_size = 0;
+    if (rl_mem_guard_find(ptr, &guard_size) == RL_SUCCESS)
+    {
+        void *new_ptr = rl_malloc(size, file, func, line);
+        if (new_ptr == NULL)
+        {
+            return NULL;
+        }
+        memcpy(new_ptr, ptr, (guard_size < size) ? guard_size : size);
+        rl_free(ptr, file, func, line);
+        return new_ptr;
+    }
+    if (rl_mem_guard_used == RL_TRUE && rl_mem_guard_quarantined(ptr) == RL_TRUE)
+    {
+        rl_log_error("[%s:%s:%d] realloc ptr=%p already freed (in quarantine)", file, func, line, ptr);
+        return NULL;
+    }
+    // 带头部的内存块：移出链表后连同头部一起 realloc，再重新加入链表
+    bool freed = RL_FALSE;
+    MEM_INLINE_HDR_T *hdr = rl_mem_inline_hdr(ptr, &freed);
+    if (hdr != NULL)
+    {
+        if (size > RL_MEM_INLINE_SIZE_MAX)
+        {
+            rl_log_error("[%s:%s:%d] size=%zu too large", __FILENAME__, __FUNCTION__, __LINE__, size);
+            return NULL;
+        }
+        size_t old_size = hdr->size;
+        unsigned int site = hdr->site;
+        rl_mem_inline_unlink(hdr);
+        rl_mem_sample_release(ptr);
+        void *raw = realloc(hdr, sizeof(MEM_INLINE_HDR_T) + size);
+        if (raw == NULL)
+        {
+            rl_log_error("[%s:%s:%d] realloc=%p bytes=%zu failed", __FILENAME__, __FUNCTION__, __LINE__, ptr, size);
+            rl_mem_inline_link(hdr, old_size, site);
+            return NULL;
+        }
+        unsigned int new_site = rl_mem_site_id(file, func, line);
+        void *new_ptr = rl_mem_inline_link(raw, size, new_site);
+        rl_mem_site_free(site, old_size);
+        rl_mem_site_alloc(new_site, size);
+        unsigned long long block_count = __atomic_load_n(rl_mem_block_counter(), __ATOMIC_RELAXED);
+        unsigned long long total_bytes = __atomic_add_fetch(rl_mem_bytes_counter(), size - old_size, __ATOMIC_RELAXED);
+        rl_mem_trace_event(RL_MEM_EVENT_REALLOC, new_ptr, ptr, size, file, func, line, block_count, total_bytes);
+        rl_mem_sample_alloc(new_ptr, size, file, func, line);
+        return new_ptr;
+    }
+    if (freed == RL_TRUE)
+    {
+        rl_log_error("[%s:%s:%d] realloc ptr=%p already freed", file, func, line, ptr);
+        return NULL;
+    }
+
+    // 如果启用内存分配跟踪，先删除原来 ptr 对应的记录（realloc 之后该地址可能立即被其他线程重新分配）
+    bool trace = rl_memory_trace_state;
+    MEM_NODE_T old_node = {0};
+    bool found_node = RL_FALSE;
+    if (trace == RL_TRUE)
+    {
+        found_node = (rl_mem_track_remove(g_mem_shard, ptr, &old_node) == RL_SUCCESS);
+        // 头部跟踪方式下跟踪表只记录对齐分配的内存块，其他外部内存块无法得知大小，不能转换为带头部的内存块
+        if (found_node == RL_FALSE && rl_memory_trace_mode == RL_MEM_TRACE_INLINE)
+        {
+            rl_log_error("[%s:%s:%d] realloc ptr=%p not allocated by rl_malloc", file, func, line, ptr);
+            return NULL;
+        }
+        // 如果原来找不到 ptr（比如是从系统 malloc），就添加一条新记录
+        if (found_node == RL_FALSE)
+        {
+            rl_log_warn("[%s:%s:%d] realloc original ptr=%p not found in trace list, new record created", file, func, line, ptr);
+        }
+    }
+
+    // 采样记录同样要在 realloc 之前删除（realloc 失败时原内存块不再计入采样）
+    rl_mem_sample_release(ptr);
+    // 尝试分配内存
+    void *new_ptr = realloc(ptr, size);
+    if (new_ptr == NULL)
+    {
+        rl_log_error("[%s:%s:%d] realloc=%p bytes=%zu failed", __FILENAME__, __FUNCTION__, __LINE__, ptr, size);
+        // 原内存未释放，恢复原来的记录
+        if (found_node == RL_TRUE)
+        {
+            rl_mem_track_insert(g_mem_shard, old_node.ptr, old_node.size, old_node.file, old_node.func, old_node.line, old_node.site);
+        }
+        return NULL;
+    }
+    if (trace == RL_TRUE)
+    {
+        if (found_node == RL_TRUE)
+        {
+            rl_mem_site_free(old_node.site, old_node.size);
+        }
+        unsigned int site = rl_mem_site_id(file, func, line);
+        if (rl_mem_track_insert(g_mem_shard, new_ptr, size, file, func, line, site) == RL_FAILED)
+        {
+            rl_log_error("[%s:%s:%d] memory trace record ptr=%p failed", __FILENAME__, __FUNCTION__, __LINE__, new_ptr);
+            free(new_ptr);
+            if (found_node == RL_TRUE)
+            {
+                __atomic_sub_fetch(rl_mem_block_counter(), 1, __ATOMIC_RELAXED);
+                __atomic_sub_fetch(rl_mem_bytes_counter(), old_node.size, __ATOMIC_RELAXED);
+            }
+            return NULL;
+        }
+        rl_mem_site_alloc(site, size);
+        // 更新总字节数：先减去旧的，再加上新的；新记录则增加块数
+        unsigned long long block_count = (found_node == RL_TRUE) ? __atomic_load_n(rl_mem_block_counter(), __ATOMIC_RELAXED) : __atomic_add_fetch(rl_mem_block_counter(), 1, __ATOMIC_RELAXED);
+        unsigned long long total_bytes = __atomic_add_fetch(rl_mem_bytes_counter(), size - old_node.size, __ATOMIC_RELAXED);
+        rl_mem_trace_event(RL_MEM_EVENT_REALLOC, new_ptr, ptr, size, file, func, line, block_count, total_bytes);
+    }
+    rl_mem_sample_alloc(new_ptr, size, file, func, line);
+    return new_ptr;
+}
+
+// 重新分配 nmemb 个 size 字节的元素，乘法溢出时返回 NULL 且原内存块不变
+void *rl_reallocarray(void *ptr, size_t nmemb, size_t size, const char *file, const char *func, int line)
+{
+    size_t total;
+    if (__builtin_mul_overflow(nmemb, size, &total))
+    {
+        rl_log_error("[%s:%s:%d] nmemb=%zu size=%zu overflow", file, func, line, nmemb, size);
+        return NULL;
+    }
+    return rl_realloc(ptr, total, file, func, line);
+}
+
+// 按 align 对齐分配
+void *rl_aligned_alloc(size_t size, size_t align, const char *file, const char *func, int line)
+{
+    if (size == 0 || align == 0 || (align & (align - 1)) != 0)
+    {
+        rl_log_error("[%s:%s:%d] size=%zu or align=%zu invalid", __FILENAME__, __FUNCTION__, __LINE__, size, align);
+        return NULL;
+    }
+    // posix_memalign 要求对齐至少为指针大小
+    if (align < sizeof(void *))
+    {
+        align = sizeof(void *);
+    }
+    void *ptr = NULL;
+    int ret = posix_memalign(&ptr, align, size);
+    if (ret != 0)
+    {
+        rl_log_error("[%s:%s:%d] posix_memalign=%zu bytes align=%zu failed, ret=%d", __FILENAME__, __FUNCTION__, __LINE__, size, align, ret);
+        return NULL;
+    }
+    // 无论哪种跟踪方式都记录在跟踪表中（头部会破坏对齐）
+    if (rl_mem_track_alloc(RL_MEM_EVENT_ALIGNED, ptr, size, file, func, line) == RL_FAILED)
+    {
+        free(ptr);
+        return NULL;
+    }
+    rl_mem_sample_alloc(ptr, size, file, func, line);
+    return ptr;
+}
+
+// 按大页映射分配
+void *rl_huge_alloc(size_t size, const char *file, const char *func, int line)
+{
+    if (size == 0 || size > SIZE_MAX - 2 * RL_ARENA_HUGE_PAGE_SIZE)
+    {
+        rl_log_error("[%s:%s:%d] size=%zu invalid", __FILENAME__, __FUNCTION__, __LINE__, size);
+        return NULL;
+    }
+    pthread_once(&g_mem_huge_once, rl_mem_huge_init);
+    size_t map_size = (size + RL_ARENA_HUGE_PAGE_SIZE - 1) & ~(size_t)(RL_ARENA_HUGE_PAGE_SIZE - 1);
+    void *ptr = rl_mem_map_huge(map_size, RL_ARENA_HUGE_PAGE_SIZE);
+    if (ptr == NULL)
+    {
+        // 地址空间不足以按大页对齐时直接按普通页映射
+        map_size = (size + g_mem_page_size - 1) & ~(g_mem_page_size - 1);
+        ptr = mmap(NULL, map_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (ptr == MAP_FAILED)
+        {
+            rl_log_error("[%s:%s:%d] mmap=%zu bytes failed", __FILENAME__, __FUNCTION__, __LINE__, map_size);
+            return NULL;
+        }
+    }
+    if (rl_mem_track_insert(g_mem_huge_shard, ptr, map_size, file, func, line, 0) == RL_FAILED)
+    {
+        rl_log_error("[%s:%s:%d] huge alloc record ptr=%p failed", __FILENAME__, __FUNCTION__, __LINE__, ptr);
+        munmap(ptr, map_size);
+        return NULL;
+    }
+    __atomic_add_fetch(&g_mem_huge_count, 1, __ATOMIC_RELEASE);
+    // 无论哪种跟踪方式都记录在跟踪表中
+    if (rl_mem_track_alloc(RL_MEM_EVENT_HUGE, ptr, size, file, func, line) == RL_FAILED)
+    {
+        rl_mem_huge_remove(ptr, &map_size);
+        munmap(ptr, map_size);
+        return NULL;
+    }
+    rl_mem_sample_alloc(ptr, size, file, func, line);
+    return ptr;
+}
+
+// 线程退出时把线程缓存中的对象归还到共享仓库
+static void rl_pool_cache_destructor(void *arg)
+{
+    RL_POOL_CACHE_T *cache = (RL_POOL_CACHE_T *)arg;
+    rl_pool_t *pool = cache->pool;
+    pthread_mutex_lock(&pool->lock);
+    if (cache->head != NULL)
+    {
+        ((void **)cache->head)[1] = pool->batches;
+        pool->batches = cache->head;
+    }
+    if (cache->prev != NULL)
+    {
+        cache->prev->next = cache->next;
+    }
+    else
+    {
+        pool->caches = cache->next;
+    }
+    if (cache->next != NULL)
+    {
+        cache->next->prev = cache->prev;
+    }
+    pthread_mutex_unlock(&pool->lock);
+    free(cache);
+}
+
+// 获取当前线程的缓存，不存在则创建
+static RL_POOL_CACHE_T *rl_pool_cache_get(rl_pool_t *pool)
+{
+    RL_POOL_CACHE_T *cache = (RL_POOL_CACHE_T *)pthread_getspecific(pool->key);
+    if (cache != NULL)
+    {
+        return cache;
+    }
+    cache = (RL_POOL_CACHE_T *)calloc(1, sizeof(RL_POOL_CACHE_T));
+    if (cache == NULL)
+    {
+        return NULL;
+    }
+    cache->pool = pool;
+    pthread_mutex_lock(&pool->lock);
+    cache->next = pool->caches;
+    if (pool->caches != NULL)
+    {
+        pool->caches->prev = cache;
+    }
+    pool->caches = cache;
+    pthread_mutex_unlock(&pool->lock);
+    pthread_setspecific(pool->key, cache);
+    return cache;
+}
+
+// 从系统分配一个新内存块并按批放入共享仓库（调用者需持有 pool->lock）
+static int rl_pool_grow_locked(rl_pool_t *pool)
+{
+    char *slab = (char *)malloc(RL_POOL_SLAB_HEAD + (size_t)pool->obj_size * pool->objs_per_slab);
+    if (slab == NULL)
+    {
+        return RL_FAILED;
+    }
+    *(void **)slab = pool->slabs;
+    pool->slabs = slab;
+    pool->slab_count++;
+    char *obj = slab + RL_POOL_SLAB_HEAD;
+    for (unsigned int i = 0; i < pool->objs_per_slab; i += RL_POOL_CACHE_BATCH)
+    {
+        unsigned int n = (pool->objs_per_slab - i < RL_POOL_CACHE_BATCH) ? pool->objs_per_slab - i : RL_POOL_CACHE_BATCH;
+        char *batch = obj + (size_t)i * pool->obj_size;
+        for (unsigned int j = 0; j < n; j++)
+        {
+            *(void **)(batch + (size_t)j * pool->obj_size) = (j + 1 < n) ? batch + (size_t)(j + 1) * pool->obj_size : NULL;
+        }
+        ((void **)batch)[1] = pool->batches;
+        pool->batches = batch;
+    }
+    return RL_SUCCESS;
+}
+
+rl_pool_t *rl_pool_create(unsigned int obj_size, unsigned int objs_per_slab, const char *name)
+{
+    if (obj_size == 0 || objs_per_slab == 0)
+    {
+        rl_log_error("[%s:%s:%d] obj_size=%u or objs_per_slab=%u invalid", __FILENAME__, __FUNCTION__, __LINE__, obj_size, objs_per_slab);
+        return NULL;
+    }
+    // 对象至少能存放两个指针，并按 16 字节对齐
+    unsigned int size = (obj_size < 2 * sizeof(void *)) ? 2 * sizeof(void *) : obj_size;
+    size = (size + 15) & ~15U;
+    if (size < obj_size || (size_t)size * objs_per_slab > UINT_MAX)
+    {
+        rl_log_error("[%s:%s:%d] obj_size=%u objs_per_slab=%u too large", __FILENAME__, __FUNCTION__, __LINE__, obj_size, objs_per_slab);
+        return NULL;
+    }
+    rl_pool_t *pool = (rl_pool_t *)calloc(1, sizeof(rl_pool_t));
+    if (pool == NULL)
+    {
+        rl_log_error("[%s:%s:%d] malloc=%zu bytes failed", __FILENAME__, __FUNCTION__, __LINE__, sizeof(rl_pool_t));
+        return NULL;
+    }
+    if (pthread_key_create(&pool->key, rl_pool_cache_destructor) != 0)
+    {
+        rl_log_error("[%s:%s:%d] create pool key failed", __FILENAME__, __FUNCTION__, __LINE__);
+        free(pool);
+        return NULL;
+    }
+    snprintf(pool->name, sizeof(pool->name), "%s", (name != NULL) ? name : "unnamed");
+    pool->obj_size = size;
+    pool->objs_per_slab = objs_per_slab;
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_mutex_lock(&g_pool_lock);
+    pool->next = g_pool_header;
+    g_pool_header = pool;
+    pthread_mutex_unlock(&g_pool_lock);
+    RL_LOGD("[%s:%s:%d] create pool %s, obj_size=%u, objs_per_slab=%u", __FILENAME__, __FUNCTION__, __LINE__, pool->name, size, objs_per_slab);
+    return pool;
+}
+
+void *rl_pool_alloc(rl_pool_t *pool)
+{
+    if (pool == NULL)
+    {
+        rl_log_error("[%s:%s:%d] pool is null", __FILENAME__, __FUNCTION__, __LINE__);
+        return NULL;
+    }
+    RL_POOL_CACHE_T *cache = rl_pool_cache_get(pool);
+    if (cache == NULL)
+    {
+        rl_log_error("[%s:%s:%d] pool %s create thread cache failed", __FILENAME__, __FUNCTION__, __LINE__, pool->name);
+        return NULL;
+    }
+    // 线程缓存为空：从共享仓库取一批
+    if (cache->head == NULL)
+    {
+        pthread_mutex_lock(&pool->lock);
+        if (pool->batches == NULL && rl_pool_grow_locked(pool) == RL_FAILED)
+        {
+            pthread_mutex_unlock(&pool->lock);
+            rl_log_error("[%s:%s:%d] pool %s malloc slab failed", __FILENAME__, __FUNCTION__, __LINE__, pool->name);
+            return NULL;
+        }
+        void *batch = pool->batches;
+        pool->batches = ((void **)batch)[1];
+        pthread_mutex_unlock(&pool->lock);
+        unsigned int count = 0;
+        for (void *obj = batch; obj != NULL; obj = *(void **)obj)
+        {
+            count++;
+        }
+        cache->head = batch;
+        __atomic_store_n(&cache->count, count, __ATOMIC_RELAXED);
+    }
+    void *obj = cache->head;
+    cache->head = *(void **)obj;
+    __atomic_store_n(&cache->count, cache->count - 1, __ATOMIC_RELAXED);
+    return obj;
+}
+
+int rl_pool_free(rl_pool_t *pool, void *obj)
+{
+    if (pool == NULL || obj == NULL)
+    {
+        rl_log_error("[%s:%s:%d] pool or obj is null", __FILENAME__, __FUNCTION__, __LINE__);
+        return RL_FAILED;
+    }
+    RL_POOL_CACHE_T *cache = rl_pool_cache_get(pool);
+    if (cache == NULL)
+    {
+        // 无法创建线程缓存时直接归还到共享仓库
+        *(void **)obj = NULL;
+        pthread_mutex_lock(&pool->lock);
+        ((void **)obj)[1] = pool->batches;
+        pool->batches = obj;
+        pthread_mutex_unlock(&pool->lock);
+        return RL_SUCCESS;
+    }
+    *(void **)obj = cache->head;
+    cache->head = obj;
+    __atomic_store_n(&cache->count, cache->count + 1, __ATOMIC_RELAXED);
+    // 线程缓存过多：把前一批归还到共享仓库
+    if (cache->count >= 2 * RL_POOL_CACHE_BATCH)
+    {
+        void *batch = cache->head;
+        void *tail = batch;
+        for (int i = 1; i < RL_POOL_CACHE_BATCH; i++)
+        {
+            tail = *(void **)tail;
+        }
+        cache->head = *(void **)tail;
+        *(void **)tail = NULL;
+        pthread_mutex_lock(&pool->lock);
+        ((void **)batch)[1] = pool->batches;
+        pool->batches = batch;
+        __atomic_store_n(&cache->count, cache->count - RL_POOL_CACHE_BATCH, __ATOMIC_RELAXED);
+        pthread_mutex_unlock(&pool->lock);
+    }
+    return RL_SUCCESS;
+}
+
+int rl_pool_destroy(rl_pool_t *pool)
+{
+    if (pool == NULL)
+    {
+        rl_log_error("[%s:%s:%d] pool is null", __FILENAME__, __FUNCTION__, __LINE__);
+        return RL_FAILED;
+    }
+    pthread_mutex_lock(&g_pool_lock);
+    rl_pool_t **cur = &g_pool_header;
+    while (*cur != NULL && *cur != pool)
+    {
+        cur = &((*cur)->next);
+    }
+    if (*cur == NULL)
+    {
+        pthread_mutex_unlock(&g_pool_lock);
+        rl_log_error("[%s:%s:%d] pool=%p not found", __FILENAME__, __FUNCTION__, __LINE__, (void *)pool);
+        return RL_FAILED;
+    }
+    *cur = pool->next;
+    pthread_mutex_unlock(&g_pool_lock);
+
+    pthread_key_delete(pool->key);
+    pthread_mutex_lock(&pool->lock);
+    unsigned int in_use = rl_pool_in_use_locked(pool);
+    if (in_use > 0)
+    {
+        rl_log_warn("[%s:%s:%d] pool %s destroyed with %u objects in use", __FILENAME__, __FUNCTION__, __LINE__, pool->name, in_use);
+    }
+    while (pool->caches != NULL)
+    {
+        RL_POOL_CACHE_T *cache = pool->caches;
+        pool->caches = cache->next;
+        free(cache);
+    }
+    while (pool->slabs != NULL)
+    {
+        void *slab = pool->slabs;
+        pool->slabs = *(void **)slab;
+        free(slab);
+    }
+    pthread_mutex_unlock(&pool->lock);
+    pthread_mutex_destroy(&pool->lock);
+    RL_LOGD("[%s:%s:%d] destroy pool %s", __FILENAME__, __FUNCTION__, __LINE__, pool->name);
+    free(pool);
+    return RL_SUCCESS;
+}
+
+// 内存区映射块头部
+typedef struct RL_ARENA_CHUNK
+{
+    struct RL_ARENA_CHUNK *prev;
+    // 映射大小
+    size_t size;
+    // 该块成为当前块时内存区已分配的字节数（不含块头部）
+    size_t base_used;
+} RL_ARENA_CHUNK_T;
+
+// 映射块头部大小（保证首个分配 16 字节对齐）
+#define RL_ARENA_CHUNK_HEAD     ((sizeof(RL_ARENA_CHUNK_T) + 15) & ~(size_t)15)
+
+struct rl_arena
+{
+    size_t chunk_size;
+    bool huge_page;
+    // 当前块及块内偏移
+    RL_ARENA_CHUNK_T *chunk;
+    size_t offset;
+    // 回退后保留一个标准大小的块供复用
+    RL_ARENA_CHUNK_T *spare;
+    // 统计（仅所属线程修改，获取统计信息时由其他线程读取）
+    size_t used;
+    size_t peak;
+    size_t reserved;
+    struct rl_arena *next;
+};
+
+// 所有内存区（用于统计）
+static pthread_mutex_t g_arena_lock = PTHREAD_MUTEX_INITIALIZER;
+static rl_arena_t *g_arena_header = NULL;
+
+// 映射一个块（起始地址至少按 align 对齐）
+static RL_ARENA_CHUNK_T *rl_arena_chunk_map(rl_arena_t *arena, size_t size, size_t align)
+{
+    size_t page = arena->huge_page ? RL_ARENA_HUGE_PAGE_SIZE : (size_t)sysconf(_SC_PAGESIZE);
+    size = (size + page - 1) & ~(page - 1);
+    if (arena->huge_page == RL_FALSE && align <= page)
+    {
+        void *addr = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (addr == MAP_FAILED)
+        {
+            return NULL;
+        }
+        ((RL_ARENA_CHUNK_T *)addr)->size = size;
+        return (RL_ARENA_CHUNK_T *)addr;
+    }
+    void *start = rl_mem_map_huge(size, (align > page) ? align : page);
+    if (start == NULL)
+    {
+        return NULL;
+    }
+    ((RL_ARENA_CHUNK_T *)start)->size = size;
+    return (RL_ARENA_CHUNK_T *)start;
+}
+
+static void rl_arena_chunk_unmap(rl_arena_t *arena, RL_ARENA_CHUNK_T *chunk)
+{
+    __atomic_store_n(&arena->reserved, arena->reserved - chunk->size, __ATOMIC_RELAXED);
+    munmap(chunk, chunk->size);
+}
+
+// 释放一个块：标准大小的块保留一个供复用，其他归还系统
+static void rl_arena_chunk_release(rl_arena_t *arena, RL_ARENA_CHUNK_T *chunk)
+{
+    if (arena->spare == NULL && chunk->size == arena->chunk_size)
+    {
+        arena->spare = chunk;
+        return;
+    }
+    rl_arena_chunk_unmap(arena, chunk);
+}
+
+rl_arena_t *rl_arena_create(size_t chunk_size, bool huge_page)
+{
+    rl_arena_t *arena = (rl_arena_t *)calloc(1, sizeof(rl_arena_t));
+    if (arena == NULL)
+    {
+        rl_log_error("[%s:%s:%d] malloc=%zu bytes failed", __FILENAME__, __FUNCTION__, __LINE__, sizeof(rl_arena_t));
+        return NULL;
+    }
+    size_t align = huge_page ? RL_ARENA_HUGE_PAGE_SIZE : (size_t)sysconf(_SC_PAGESIZE);
+    chunk_size = (chunk_size == 0) ? RL_ARENA_CHUNK_SIZE : chunk_size;
+    arena->chunk_size = (chunk_size + align - 1) & ~(align - 1);
+    arena->huge_page = huge_page;
+    pthread_mutex_lock(&g_arena_lock);
+    arena->next = g_arena_header;
+    g_arena_header = arena;
+    pthread_mutex_unlock(&g_arena_lock);
+    RL_LOGD("[%s:%s:%d] create arena, chunk_size=%zu, huge_page=%d", __FILENAME__, __FUNCTION__, __LINE__, arena->chunk_size, huge_page);
+    return arena;
+}
+
+void *rl_arena_alloc(rl_arena_t *arena, size_t size, size_t align)
+{
+    if (arena == NULL || size == 0)
+    {
+        rl_log_error("[%s:%s:%d] arena is null or size=%zu invalid", __FILENAME__, __FUNCTION__, __LINE__, size);
+        return NULL;
+    }
+    align = (align == 0) ? 16 : align;
+    if ((align & (align - 1)) != 0)
+    {
+        rl_log_error("[%s:%s:%d] align=%zu invalid", __FILENAME__, __FUNCTION__, __LINE__, align);
+        return NULL;
+    }
+    // 当前块剩余空间足够：只移动偏移（按地址对齐，块本身只保证页对齐）
+    if (arena->chunk != NULL)
     {
-        rl_log_debug("[%s:%s:%d] alread enable memory trace", __FILENAME__, __FUNCTION__, __LINE__);
-        return;
+        uintptr_t base = (uintptr_t)arena->chunk;
+        size_t offset = ((base + arena->offset + align - 1) & ~(uintptr_t)(align - 1)) - base;
+        if (offset <= arena->chunk->size && size <= arena->chunk->size - offset)
+        {
+            arena->offset = offset + size;
+            size_t used = arena->chunk->base_used + arena->offset - RL_ARENA_CHUNK_HEAD;
+            __atomic_store_n(&arena->used, used, __ATOMIC_RELAXED);
+            if (used > arena->peak)
+            {
+                __atomic_store_n(&arena->peak, used, __ATOMIC_RELAXED);
+            }
+            return (char *)arena->chunk + offset;
+        }
     }
-
-    if (state == RL_TRUE)
+    // 换一个新块（超过标准大小的分配单独映射）：新块至少按 align 对齐，分配位于块头部之后第一个对齐的位置
+    size_t page = arena->huge_page ? RL_ARENA_HUGE_PAGE_SIZE : (size_t)sysconf(_SC_PAGESIZE);
+    size_t head = (RL_ARENA_CHUNK_HEAD + align - 1) & ~(align - 1);
+    size_t need = head + size;
+    if (head < RL_ARENA_CHUNK_HEAD || need < size)
     {
-        pthread_mutex_init(&mem_lock, NULL);
-        g_mem_header = NULL;
-        rl_memory_trace_state = RL_TRUE;
-        rl_log_debug("[%s:%s:%d] enable memory trace", __FILENAME__, __FUNCTION__, __LINE__);
+        rl_log_error("[%s:%s:%d] size=%zu align=%zu too large", __FILENAME__, __FUNCTION__, __LINE__, size, align);
+        return NULL;
+    }
+    RL_ARENA_CHUNK_T *chunk = NULL;
+    // 保留的块只按页对齐
+    if (need <= arena->chunk_size && arena->spare != NULL && align <= page)
+    {
+        chunk = arena->spare;
+        arena->spare = NULL;
     }
     else
     {
-        pthread_mutex_destroy(&mem_lock);
-        rl_memory_trace_state = RL_FALSE;
-        rl_log_debug("[%s:%s:%d] disable memory trace", __FILENAME__, __FUNCTION__, __LINE__);
+        chunk = rl_arena_chunk_map(arena, (need <= arena->chunk_size) ? arena->chunk_size : need, align);
+        if (chunk == NULL)
+        {
+            rl_log_error("[%s:%s:%d] mmap arena chunk for size=%zu failed", __FILENAME__, __FUNCTION__, __LINE__, size);
+            return NULL;
+        }
+        __atomic_store_n(&arena->reserved, arena->reserved + chunk->size, __ATOMIC_RELAXED);
     }
+    chunk->prev = arena->chunk;
+    chunk->base_used = (arena->chunk != NULL) ? arena->chunk->base_used + arena->offset - RL_ARENA_CHUNK_HEAD : 0;
+    arena->chunk = chunk;
+    arena->offset = RL_ARENA_CHUNK_HEAD;
+    return rl_arena_alloc(arena, size, align);
 }
 
-// 仅程序结束时调用（输出内存泄露情况到文件）
-int rl_memory_trace_deinit()
+rl_arena_mark_t rl_arena_mark(rl_arena_t *arena)
 {
-    if (rl_memory_trace_state == RL_FALSE)
+    rl_arena_mark_t mark = {NULL, 0};
+    if (arena != NULL)
+    {
+        mark.chunk = arena->chunk;
+        mark.offset = arena->offset;
+    }
+    return mark;
+}
+
+int rl_arena_rewind(rl_arena_t *arena, rl_arena_mark_t mark)
+{
+    if (arena == NULL)
     {
-        rl_log_debug("[%s:%s:%d] not enabled memory trace", __FILENAME__, __FUNCTION__, __LINE__);
+        rl_log_error("[%s:%s:%d] arena is null", __FILENAME__, __FUNCTION__, __LINE__);
         return RL_FAILED;
     }
-    // 获取日志路径
-    char path[1024] = {0};
-    int ret = rl_get_file_abs_path(path, 1024, RL_MEM_TRACE_LOG_FILE_DIR);
-    if (ret == RL_FAILED || rl_str_isempty(path) == RL_TRUE)
+    // 释放标记之后映射的块
+    while (arena->chunk != NULL && arena->chunk != mark.chunk)
     {
-        rl_log_error("[%s:%s:%d] get log path failed", __FILENAME__, __FUNCTION__, __LINE__);
+        RL_ARENA_CHUNK_T *chunk = arena->chunk;
+        arena->chunk = chunk->prev;
+        rl_arena_chunk_release(arena, chunk);
+    }
+    if (arena->chunk != mark.chunk)
+    {
+        rl_log_error("[%s:%s:%d] mark chunk=%p not found in arena", __FILENAME__, __FUNCTION__, __LINE__, mark.chunk);
+        arena->offset = 0;
+        __atomic_store_n(&arena->used, 0, __ATOMIC_RELAXED);
         return RL_FAILED;
     }
-    char name[32] = {0};
-    if (rl_get_proc_name(name, sizeof(name)) == RL_FAILED)
+    arena->offset = mark.offset;
+    __atomic_store_n(&arena->used, (arena->chunk != NULL) ? arena->chunk->base_used + arena->offset - RL_ARENA_CHUNK_HEAD : 0, __ATOMIC_RELAXED);
+    return RL_SUCCESS;
+}
+
+int rl_arena_reset(rl_arena_t *arena)
+{
+    if (arena == NULL)
     {
-        rl_log_error("[%s:%s:%d] get proc name failed", __FILENAME__, __FUNCTION__, __LINE__);
+        rl_log_error("[%s:%s:%d] arena is null", __FILENAME__, __FUNCTION__, __LINE__);
         return RL_FAILED;
     }
-    // 追加进程名和 .log，确保不会越界
-    unsigned int used = strlen(path);
-    int remain = sizeof(path) - used;
-    if (remain > 0)
+    if (arena->chunk == NULL)
     {
-        snprintf(path + used, remain, "_%s.log", name);
+        return RL_SUCCESS;
     }
-    else
+    // 回退到第一块的起始位置
+    RL_ARENA_CHUNK_T *first = arena->chunk;
+    while (first->prev != NULL)
     {
-        rl_log_error("[%s:%s:%d] log file path too long", __FILENAME__, __FUNCTION__, __LINE__);
-        return RL_FAILED;
+        first = first->prev;
     }
-    // 获取时间
-    rl_time_t time;
-    if (rl_get_time(&time) == RL_FAILED)
+    rl_arena_mark_t mark = {first, RL_ARENA_CHUNK_HEAD};
+    return rl_arena_rewind(arena, mark);
+}
+
+int rl_arena_destroy(rl_arena_t *arena)
+{
+    if (arena == NULL)
     {
-        rl_log_error("[%s:%s:%d] get time failed", __FILENAME__, __FUNCTION__, __LINE__);
+        rl_log_error("[%s:%s:%d] arena is null", __FILENAME__, __FUNCTION__, __LINE__);
         return RL_FAILED;
     }
-    pthread_mutex_lock(&mem_lock);
-    FILE *fp = fopen(path, "w");
-    if (fp == NULL)
+    pthread_mutex_lock(&g_arena_lock);
+    rl_arena_t **cur = &g_arena_header;
+    while (*cur != NULL && *cur != arena)
+    {
+        cur = &((*cur)->next);
+    }
+    if (*cur != NULL)
+    {
+        *cur = arena->next;
+    }
+    pthread_mutex_unlock(&g_arena_lock);
+    while (arena->chunk != NULL)
+    {
+        RL_ARENA_CHUNK_T *chunk = arena->chunk;
+        arena->chunk = chunk->prev;
+        rl_arena_chunk_unmap(arena, chunk);
+    }
+    if (arena->spare != NULL)
     {
-        pthread_mutex_unlock(&mem_lock);
-        rl_log_debug("[%s:%s:%d] open memory trace file:%s failed", __FILENAME__, __FUNCTION__, __LINE__, path);
+        rl_arena_chunk_unmap(arena, arena->spare);
+    }
+    RL_LOGD("[%s:%s:%d] destroy arena, peak=%zu bytes", __FILENAME__, __FUNCTION__, __LINE__, arena->peak);
+    free(arena);
+    return RL_SUCCESS;
+}
+
+// 获取 rlmem 统计信息
+int rl_memory_get_stats(rl_mem_stats_t *stats)
+{
+    if (stats == NULL)
+    {
+        rl_log_error("[%s:%s:%d] stats is null", __FILENAME__, __FUNCTION__, __LINE__);
         return RL_FAILED;
     }
+    memset(stats, 0, sizeof(rl_mem_stats_t));
+    stats->trace_blocks = __atomic_load_n(rl_mem_block_counter(), __ATOMIC_RELAXED);
+    stats->trace_bytes = __atomic_load_n(rl_mem_bytes_counter(), __ATOMIC_RELAXED);
+    pthread_mutex_lock(&g_arena_lock);
+    for (rl_arena_t *arena = g_arena_header; arena != NULL; arena = arena->next)
+    {
+        stats->arena_count++;
+        stats->arena_reserved_bytes += __atomic_load_n(&arena->reserved, __ATOMIC_RELAXED);
+        stats->arena_used_bytes += __atomic_load_n(&arena->used, __ATOMIC_RELAXED);
+        stats->arena_peak_bytes += __atomic_load_n(&arena->peak, __ATOMIC_RELAXED);
+    }
+    pthread_mutex_unlock(&g_arena_lock);
+    return RL_SUCCESS;
+}
 
-    fprintf(fp, "==== Memory Leak Report ====\n");
-    fprintf(fp, "%04d-%02d-%02d %02d:%02d:%02d\n", time.tm_year + 1900, time.tm_mon + 1, time.tm_mday, time.tm_hour, time.tm_min, time.tm_sec);
-    rl_log_debug("[%s:%s:%d] ==== Memory Leak Report ====", __FILENAME__, __FUNCTION__, __LINE__);
-    unsigned int leak_count = 0;
-    unsigned int leak_bytes = 0;
+// 读取一个调用点的统计
+static void rl_mem_site_read(const MEM_SITE_T *site, rl_mem_site_stats_t *stats)
+{
+    stats->file = site->file;
+    stats->func = site->func;
+    stats->line = site->line;
+    stats->cur_bytes = __atomic_load_n(&site->cur_bytes, __ATOMIC_RELAXED);
+    stats->cur_blocks = __atomic_load_n(&site->cur_blocks, __ATOMIC_RELAXED);
+    stats->total_allocs = __atomic_load_n(&site->total_allocs, __ATOMIC_RELAXED);
+    stats->total_frees = __atomic_load_n(&site->total_frees, __ATOMIC_RELAXED);
+    stats->peak_bytes = __atomic_load_n(&site->peak_bytes, __ATOMIC_RELAXED);
+    for (int i = 0; i < RL_MEM_SITE_HIST_COUNT; i++)
+    {
+        stats->hist[i] = __atomic_load_n(&site->hist[i], __ATOMIC_RELAXED);
+    }
+}
 
-    // 如果没有内存泄露
-    if (g_mem_header == NULL)
+static int rl_mem_site_stats_compare(const void *a, const void *b)
+{
+    const rl_mem_site_stats_t *sa = (const rl_mem_site_stats_t *)a;
+    const rl_mem_site_stats_t *sb = (const rl_mem_site_stats_t *)b;
+    return (sa->cur_bytes < sb->cur_bytes) ? 1 : (sa->cur_bytes > sb->cur_bytes) ? -1 : 0;
+}
+
+// 获取按调用点汇总的分配统计
+int rl_memory_get_site_stats(rl_mem_site_stats_t *stats, unsigned int max_count)
+{
+    if (stats == NULL || max_count == 0)
     {
-        fprintf(fp, "No leaks detected\n");
-        rl_log_debug("[%s:%s:%d] No leaks detected", __FILENAME__, __FUNCTION__, __LINE__);
+        rl_log_error("[%s:%s:%d] stats is null or max_count=%u invalid", __FILENAME__, __FUNCTION__, __LINE__, max_count);
+        return RL_FAILED;
     }
-    // 如果发生内存泄露
-    else
+    unsigned int count = 0;
+    for (int i = 0; i < RL_MEM_TRACE_SITE_COUNT; i++)
     {
-        MEM_NODE_T *node = g_mem_header;
-        while (node != NULL)
+        const MEM_SITE_T *site = &g_mem_site[i];
+        if (__atomic_load_n(&site->state, __ATOMIC_ACQUIRE) != 2)
         {
-            fprintf(fp, "[LEAK] %p (%d bytes) from %s:%s:%d\n", node->ptr, node->size, node->file, node->func, node->line);
-            rl_log_debug("[%s:%s:%d] [LEAK] %p (%d bytes) from %s:%s:%d", __FILENAME__, __FUNCTION__, __LINE__, node->ptr, node->size, node->file, node->func, node->line);
-            leak_count++;
-            leak_bytes += node->size;
-            // 释放记录的节点
-            MEM_NODE_T *temp = node;
-            node = node->next;
-            free(temp);
+            continue;
+        }
+        if (count < max_count)
+        {
+            rl_mem_site_read(site, &stats[count++]);
+            continue;
+        }
+        // 已满：替换当前未释放字节数最小的一项
+        unsigned int min = 0;
+        for (unsigned int j = 1; j < count; j++)
+        {
+            if (stats[j].cur_bytes < stats[min].cur_bytes)
+            {
+                min = j;
+            }
+        }
+        if (__atomic_load_n(&site->cur_bytes, __ATOMIC_RELAXED) > stats[min].cur_bytes)
+        {
+            rl_mem_site_read(site, &stats[min]);
         }
-        g_mem_header = NULL;
-        fprintf(fp, "Total leaks: %d blocks, %d bytes\n", leak_count, leak_bytes);
-        rl_log_debug("[%s:%s:%d] Total leaks: %d blocks, %d bytes", __FILENAME__, __FUNCTION__, __LINE__, leak_count, leak_bytes);
     }
+    qsort(stats, count, sizeof(rl_mem_site_stats_t), rl_mem_site_stats_compare);
+    return count;
+}
 
-    fprintf(fp, "============================\n");
-    rl_log_debug("[%s:%s:%d] ============================", __FILENAME__, __FUNCTION__, __LINE__);
-    fclose(fp);
-    pthread_mutex_unlock(&mem_lock);
-    pthread_mutex_destroy(&mem_lock);
+// 追加字符串（信号处理函数中不能使用 snprintf）
+static unsigned int rl_mem_dump_str(char *buf, unsigned int pos, unsigned int size, const char *str)
+{
+    while (str != NULL && *str != '\0' && pos < size)
+    {
+        buf[pos++] = *str++;
+    }
+    return pos;
+}
 
-    rl_log_debug("[%s:%s:%d] memory trace complete, Leaks: %zu blocks, %zu bytes",__FILENAME__, __FUNCTION__, __LINE__, leak_count, leak_bytes);
+// 追加十进制数字
+static unsigned int rl_mem_dump_num(char *buf, unsigned int pos, unsigned int size, unsigned long long value)
+{
+    char tmp[20];
+    int len = 0;
+    do
+    {
+        tmp[len++] = '0' + value % 10;
+        value /= 10;
+    } while (value != 0);
+    while (len > 0 && pos < size)
+    {
+        buf[pos++] = tmp[--len];
+    }
+    return pos;
+}
 
-    rl_memory_trace_state = RL_FALSE;
+// 将所有调用点的分配统计以文本写入 fd
+int rl_memory_dump_site_stats(int fd)
+{
+    if (fd < 0)
+    {
+        return RL_FAILED;
+    }
+    char buf[512];
+    for (int i = 0; i < RL_MEM_TRACE_SITE_COUNT; i++)
+    {
+        const MEM_SITE_T *site = &g_mem_site[i];
+        if (__atomic_load_n(&site->state, __ATOMIC_ACQUIRE) != 2)
+        {
+            continue;
+        }
+        unsigned int pos = 0;
+        unsigned int size = sizeof(buf) - 1;
+        pos = rl_mem_dump_str(buf, pos, size, site->file);
+        pos = rl_mem_dump_str(buf, pos, size, ":");
+        pos = rl_mem_dump_str(buf, pos, size, site->func);
+        pos = rl_mem_dump_str(buf, pos, size, ":");
+        pos = rl_mem_dump_num(buf, pos, size, site->line);
+        pos = rl_mem_dump_str(buf, pos, size, " cur_bytes=");
+        pos = rl_mem_dump_num(buf, pos, size, __atomic_load_n(&site->cur_bytes, __ATOMIC_RELAXED));
+        pos = rl_mem_dump_str(buf, pos, size, " cur_blocks=");
+        pos = rl_mem_dump_num(buf, pos, size, __atomic_load_n(&site->cur_blocks, __ATOMIC_RELAXED));
+        pos = rl_mem_dump_str(buf, pos, size, " allocs=");
+        pos = rl_mem_dump_num(buf, pos, size, __atomic_load_n(&site->total_allocs, __ATOMIC_RELAXED));
+        pos = rl_mem_dump_str(buf, pos, size, " frees=");
+        pos = rl_mem_dump_num(buf, pos, size, __atomic_load_n(&site->total_frees, __ATOMIC_RELAXED));
+        pos = rl_mem_dump_str(buf, pos, size, " peak_bytes=");
+        pos = rl_mem_dump_num(buf, pos, size, __atomic_load_n(&site->peak_bytes, __ATOMIC_RELAXED));
+        pos = rl_mem_dump_str(buf, pos, size, " hist=");
+        for (int j = 0; j < RL_MEM_SITE_HIST_COUNT; j++)
+        {
+            pos = rl_mem_dump_str(buf, pos, size, (j == 0) ? "" : ",");
+            pos = rl_mem_dump_num(buf, pos, size, __atomic_load_n(&site->hist[j], __ATOMIC_RELAXED));
+        }
+        buf[pos++] = '\n';
+        if (write(fd, buf, pos) != (ssize_t)pos)
+        {
+            return RL_FAILED;
+        }
+    }
     return RL_SUCCESS;
 }
 
-void *rl_malloc(unsigned int size, const char *file, const char *func, int line)
+// 信号处理函数：输出调用点统计
+static void rl_mem_site_dump_handler(int signo)
 {
-    if (size == 0)
+    (void)signo;
+    int saved_errno = errno;
+    int fd = open(RL_MEM_SITE_DUMP_FILE_DIR, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd != -1)
     {
-        rl_log_error("[%s:%s:%d] size=%d invalid", __FILENAME__, __FUNCTION__, __LINE__, size);
-        return NULL;
+        rl_memory_dump_site_stats(fd);
+        close(fd);
     }
-    // 尝试分配内存
-    void *ptr = malloc(size);
-    if (ptr == NULL)
+    errno = saved_errno;
+}
+
+// 收到 signo 信号时输出调用点统计
+int rl_memory_site_dump_on_signal(int signo)
+{
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = rl_mem_site_dump_handler;
+    sigemptyset(&action.sa_mask);
+    action.sa_flags = SA_RESTART;
+    if (sigaction(signo, &action, NULL) == -1)
     {
-        rl_log_error("[%s:%s:%d] malloc=%d bytes failed", __FILENAME__, __FUNCTION__, __LINE__, size);
-        return NULL;
+        rl_log_error("[%s:%s:%d] sigaction signo=%d failed", __FILENAME__, __FUNCTION__, __LINE__, signo);
+        return RL_FAILED;
     }
+    return RL_SUCCESS;
+}
 
-    // 如果启用内存分配跟踪
-    if (rl_memory_trace_state == RL_TRUE)
+// 开启采样分析
+int rl_memory_sample_start(unsigned int interval)
+{
+    pthread_mutex_lock(&g_mem_sample_lock);
+    if (g_mem_sample_inited == RL_FALSE)
     {
-        // 链表记录本次的内存分配
-        MEM_NODE_T *node = (MEM_NODE_T *)malloc(sizeof(MEM_NODE_T));
-        if (node == NULL)
+        for (int i = 0; i < RL_MEM_TRACE_SHARD_COUNT; i++)
         {
-            free(ptr);
-            rl_log_error("[%s:%s:%d] memory trace malloc=%d bytes failed", __FILENAME__, __FUNCTION__, __LINE__, sizeof(MEM_NODE_T));
-            return NULL;
+            pthread_mutex_init(&g_mem_sample_shard[i].lock, NULL);
+            g_mem_sample_shard[i].table = NULL;
+            g_mem_sample_shard[i].capacity = 0;
+            g_mem_sample_shard[i].count = 0;
         }
-        node->ptr = ptr;
-        node->size = size;
-        node->file = file;
-        node->func = func;
-        node->line = line;
-        pthread_mutex_lock(&mem_lock);
-        node->next = g_mem_header;
-        g_mem_header = node;
-        // 记录总分配内存
-        g_alloc_block_count++;
-        g_alloc_total_bytes += size;
-        pthread_mutex_unlock(&mem_lock);
-        rl_log_debug("[%s:%s:%d][malloc] addr=%p(%d bytes), total blocks=%d, total bytes=%d", file, func, line, ptr, size, g_alloc_block_count, g_alloc_total_bytes);
+        // 第一次调用 backtrace 会加载 libgcc，提前调用避免在分配路径上加载
+        void *stack[1];
+        backtrace(stack, 1);
+        g_mem_sample_inited = RL_TRUE;
     }
-    return ptr;
+    g_mem_sample_rate = (interval == 0) ? RL_MEM_SAMPLE_INTERVAL : interval;
+    __atomic_store_n(&g_mem_sample_interval, g_mem_sample_rate, __ATOMIC_RELEASE);
+    pthread_mutex_unlock(&g_mem_sample_lock);
+    RL_LOGD("[%s:%s:%d] enable memory sample, interval=%u bytes", __FILENAME__, __FUNCTION__, __LINE__, g_mem_sample_rate);
+    return RL_SUCCESS;
 }
 
-int rl_free(void *ptr, const char *file, const char *func, int line)
+// 停止采样
+int rl_memory_sample_stop()
 {
-    if (ptr == NULL)
+    __atomic_store_n(&g_mem_sample_interval, 0, __ATOMIC_RELEASE);
+    RL_LOGD("[%s:%s:%d] disable memory sample", __FILENAME__, __FUNCTION__, __LINE__);
+    return RL_SUCCESS;
+}
+
+// 输出采样的堆分析文件
+int rl_memory_sample_dump(const char *path)
+{
+    if (path == NULL)
     {
-        rl_log_error("[%s:%s:%d] free failed, ptr is null", __FILENAME__, __FUNCTION__, __LINE__);
+        rl_log_error("[%s:%s:%d] path is null", __FILENAME__, __FUNCTION__, __LINE__);
+        return RL_FAILED;
+    }
+    FILE *fp = fopen(path, "w");
+    if (fp == NULL)
+    {
+        rl_log_error("[%s:%s:%d] open sample file:%s failed", __FILENAME__, __FUNCTION__, __LINE__, path);
         return RL_FAILED;
     }
 
-    // 如果启用内存分配跟踪
-    if (rl_memory_trace_state == RL_TRUE)
+    pthread_mutex_lock(&g_mem_sample_lock);
+    unsigned long long inuse_count = 0;
+    unsigned long long inuse_bytes = 0;
+    unsigned long long alloc_count = 0;
+    unsigned long long alloc_bytes = 0;
+    for (int i = 0; i < RL_MEM_SAMPLE_STACK_COUNT; i++)
     {
-        // 链表记录释放内存
-        pthread_mutex_lock(&mem_lock);
-        bool found_node = RL_FALSE;
-        MEM_NODE_T **cur = &g_mem_header;
-        while (*cur != NULL)
+        MEM_SAMPLE_STACK_T *entry = &g_mem_sample_stack[i];
+        inuse_count += entry->alloc_count - entry->free_count;
+        inuse_bytes += entry->alloc_bytes - entry->free_bytes;
+        alloc_count += entry->alloc_count;
+        alloc_bytes += entry->alloc_bytes;
+    }
+    // 格式：未释放块数: 未释放字节数 [累计块数: 累计字节数] @ 调用栈；heap_v2 告诉 pprof 按采样间隔还原真实数值
+    fprintf(fp, "heap profile: %llu: %llu [%llu: %llu] @ heap_v2/%u\n", inuse_count, inuse_bytes, alloc_count, alloc_bytes, g_mem_sample_rate);
+    for (int i = 0; i < RL_MEM_SAMPLE_STACK_COUNT; i++)
+    {
+        MEM_SAMPLE_STACK_T *entry = &g_mem_sample_stack[i];
+        if (entry->alloc_count == 0)
         {
-            if ((*cur)->ptr == ptr)
-            {
-                MEM_NODE_T *temp = *cur;
-                *cur = temp->next;
-                unsigned int temp_size = temp->size;
-                // 释放链表节点
-                free(temp);
-                found_node = RL_TRUE;
-                // 统计释放的内存
-                g_alloc_block_count--;
-                g_alloc_total_bytes -= temp_size;
-                break;
-            }
-            cur = &((*cur)->next);
+            continue;
         }
-        // 未找到
-        if (found_node == RL_FALSE)
+        fprintf(fp, "# %s:%s:%d\n", entry->file, entry->func, entry->line);
+        fprintf(fp, "%llu: %llu [%llu: %llu] @", entry->alloc_count - entry->free_count, entry->alloc_bytes - entry->free_bytes,
+                entry->alloc_count, entry->alloc_bytes);
+        for (int j = 0; j < entry->depth; j++)
         {
-            pthread_mutex_unlock(&mem_lock);
-            rl_log_warn("[%s:%s:%d] ptr=%p not found in trace list, maybe double free or external malloc", file, func, line, ptr);
-            return RL_FAILED;
+            fprintf(fp, " %p", entry->stack[j]);
         }
-        pthread_mutex_unlock(&mem_lock);
-        rl_log_debug("[%s:%s:%d][free] addr=%p, remain blocks=%d, remain bytes=%d", file, func, line, ptr, g_alloc_block_count, g_alloc_total_bytes);
+        fprintf(fp, "\n");
+    }
+    unsigned long long dropped = g_mem_sample_dropped;
+    pthread_mutex_unlock(&g_mem_sample_lock);
+
+    // 附上内存映射，pprof 据此把地址还原为符号
+    fprintf(fp, "\nMAPPED_LIBRARIES:\n");
+    FILE *maps = fopen("/proc/self/maps", "r");
+    if (maps != NULL)
+    {
+        char buf[4096];
+        size_t len;
+        while ((len = fread(buf, 1, sizeof(buf), maps)) > 0)
+        {
+            fwrite(buf, 1, len, fp);
+        }
+        fclose(maps);
+    }
+    fclose(fp);
+    if (dropped > 0)
+    {
+        rl_log_warn("[%s:%s:%d] sample stack table full, %llu samples dropped", __FILENAME__, __FUNCTION__, __LINE__, dropped);
     }
-    // 释放实际的内存
-    free(ptr);
     return RL_SUCCESS;
 }
 
-void *rl_calloc(unsigned int block, unsigned int count, const char *file, const char *func, int line)
+// 调用点增长趋势（只由快照线程更新，g_mem_snapshot_lock 保护）
+// 只比较每个窗口内的最低值，缓存等周期性涨落的调用点不会被误判为持续增长
+typedef struct
 {
-    if (block == 0 || count == 0)
+    unsigned long long window_min;  // 当前窗口内的最低值
+    unsigned long long last_min;    // 上一个窗口的最低值
+    unsigned int rising;            // 最低值连续上升的窗口数
+} MEM_SNAPSHOT_TREND_T;
+
+static MEM_SNAPSHOT_TREND_T g_mem_snapshot_trend[RL_MEM_TRACE_SITE_COUNT];
+static pthread_mutex_t g_mem_snapshot_lock = PTHREAD_MUTEX_INITIALIZER;
+static rl_mem_snapshot_t g_mem_snapshot_last;
+static unsigned long long g_mem_snapshot_tick = 0;
+static FILE *g_mem_snapshot_fp = NULL;
+static char g_mem_snapshot_path[1024];
+// 快照线程
+static bool g_mem_snapshot_state = RL_FALSE;
+static unsigned int g_mem_snapshot_interval = 0;
+static pthread_t g_mem_snapshot_thread;
+static pthread_mutex_t g_mem_snapshot_wait_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t g_mem_snapshot_wait_cond = PTHREAD_COND_INITIALIZER;
+// 导出到 rlstat 的快照指标
+static rl_stat_t *g_mem_snapshot_stat_rss = NULL;
+static rl_stat_t *g_mem_snapshot_stat_untracked = NULL;
+static rl_stat_t *g_mem_snapshot_stat_growing = NULL;
+
+// 快照文件超过大小限制时改名为 .1 后重新打开（调用者需持有 g_mem_snapshot_lock）
+static void rl_mem_snapshot_rotate_locked()
+{
+    if (g_mem_snapshot_fp == NULL || ftell(g_mem_snapshot_fp) < RL_MEM_SNAPSHOT_FILE_SIZE)
     {
-        rl_log_error("[%s:%s:%d] block=%d or count=%d invalid", __FILENAME__, __FUNCTION__, __LINE__, block, count);
-        return NULL;
+        return;
     }
-    // 分配内存
-    unsigned int size = block * count;
-    void *ptr = calloc(block, count);
-    if (ptr == NULL)
+    fclose(g_mem_snapshot_fp);
+    char old_path[1100];
+    snprintf(old_path, sizeof(old_path), "%s.1", g_mem_snapshot_path);
+    if (rename(g_mem_snapshot_path, old_path) == -1)
     {
-        rl_log_error("[%s:%s:%d] calloc=%d bytes failed", __FILENAME__, __FUNCTION__, __LINE__, size);
-        return NULL;
+        rl_log_error("[%s:%s:%d] rename %s failed", __FILENAME__, __FUNCTION__, __LINE__, g_mem_snapshot_path);
     }
+    g_mem_snapshot_fp = fopen(g_mem_snapshot_path, "w");
+}
 
-    // 如果启用内存分配跟踪
-    if (rl_memory_trace_state == RL_TRUE)
+// 更新各调用点的增长趋势，返回持续增长的调用点数量（调用者需持有 g_mem_snapshot_lock）
+static unsigned int rl_mem_snapshot_trend_locked(const char *stamp)
+{
+    unsigned int window_pos = g_mem_snapshot_tick % RL_MEM_SNAPSHOT_WINDOW;
+    unsigned int growing = 0;
+    for (int i = 0; i < RL_MEM_TRACE_SITE_COUNT; i++)
     {
-        MEM_NODE_T *node = (MEM_NODE_T *)malloc(sizeof(MEM_NODE_T));
-        if (node == NULL)
+        const MEM_SITE_T *site = &g_mem_site[i];
+        if (__atomic_load_n(&site->state, __ATOMIC_ACQUIRE) != 2)
         {
-            free(ptr);
-            rl_log_error("[%s:%s:%d] memory trace malloc=%d bytes failed", __FILENAME__, __FUNCTION__, __LINE__, sizeof(MEM_NODE_T));
-            return NULL;
+            continue;
+        }
+        MEM_SNAPSHOT_TREND_T *trend = &g_mem_snapshot_trend[i];
+        unsigned long long cur = __atomic_load_n(&site->cur_bytes, __ATOMIC_RELAXED);
+        if (window_pos == 0 || cur < trend->window_min)
+        {
+            trend->window_min = cur;
+        }
+        if (window_pos == RL_MEM_SNAPSHOT_WINDOW - 1)
+        {
+            trend->rising = (trend->window_min > trend->last_min) ? trend->rising + 1 : 0;
+            trend->last_min = trend->window_min;
+            // 刚达到标记条件时输出一次
+            if (trend->rising == RL_MEM_SNAPSHOT_GROWTH_WINDOWS)
+            {
+                rl_log_warn("[%s:%s:%d] sustained growth at %s:%s:%d, cur_bytes=%llu", __FILENAME__, __FUNCTION__, __LINE__, site->file, site->func, site->line, cur);
+                if (g_mem_snapshot_fp != NULL)
+                {
+                    fprintf(g_mem_snapshot_fp, "%s GROWTH %s:%s:%d cur_bytes=%llu cur_blocks=%llu\n", stamp, site->file, site->func, site->line,
+                            cur, __atomic_load_n(&site->cur_blocks, __ATOMIC_RELAXED));
+                }
+            }
+        }
+        if (trend->rising >= RL_MEM_SNAPSHOT_GROWTH_WINDOWS)
+        {
+            growing++;
         }
-        node->ptr = ptr;
-        node->size = size;
-        node->file = file;
-        node->func = func;
-        node->line = line;
-
-        pthread_mutex_lock(&mem_lock);
-        node->next = g_mem_header;
-        g_mem_header = node;
-        // 记录总分配内存
-        g_alloc_block_count++;
-        g_alloc_total_bytes += size;
-        pthread_mutex_unlock(&mem_lock);
-        rl_log_debug("[%s:%s:%d][calloc] addr=%p(%d bytes), total blocks=%d, total bytes=%d", file, func, line, ptr, size, g_alloc_block_count, g_alloc_total_bytes);
     }
-    return ptr;
+    g_mem_snapshot_tick++;
+    return growing;
 }
 
-void *rl_realloc(void *ptr, unsigned int size, const char *file, const char *func, int line)
+// 记录一次快照
+static void rl_mem_snapshot_take()
 {
-    if (size == 0)
+    rl_mem_snapshot_t snapshot;
+    memset(&snapshot, 0, sizeof(snapshot));
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    snapshot.time_ms = (unsigned long long)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+    rl_mem_stats_t stats;
+    rl_memory_get_stats(&stats);
+    snapshot.trace_blocks = stats.trace_blocks;
+    snapshot.trace_bytes = stats.trace_bytes;
+    snapshot.arena_reserved_bytes = stats.arena_reserved_bytes;
+    int rss_kb = rl_get_memory_usage();
+    snapshot.rss_bytes = (rss_kb > 0) ? (unsigned long long)rss_kb * 1024 : 0;
+    snapshot.untracked_bytes = (long long)snapshot.rss_bytes - (long long)snapshot.trace_bytes - (long long)snapshot.arena_reserved_bytes;
+
+    rl_time_t time;
+    char stamp[80] = {0};
+    if (rl_get_time(&time) == RL_SUCCESS)
     {
-        rl_log_error("[%s:%s:%d] size=0, invalid realloc", __FILENAME__, __FUNCTION__, __LINE__);
-        return NULL;
+        snprintf(stamp, sizeof(stamp), "%04d-%02d-%02d %02d:%02d:%02d", time.tm_year + 1900, time.tm_mon + 1, time.tm_mday, time.tm_hour, time.tm_min, time.tm_sec);
     }
-    if (ptr == NULL)
+    pthread_mutex_lock(&g_mem_snapshot_lock);
+    snapshot.growing_sites = rl_mem_snapshot_trend_locked(stamp);
+    g_mem_snapshot_last = snapshot;
+    rl_stat_set(g_mem_snapshot_stat_rss, snapshot.rss_bytes);
+    rl_stat_set(g_mem_snapshot_stat_untracked, snapshot.untracked_bytes);
+    rl_stat_set(g_mem_snapshot_stat_growing, snapshot.growing_sites);
+    if (g_mem_snapshot_fp != NULL)
     {
-        return rl_malloc(size, file, func, line);
+        fprintf(g_mem_snapshot_fp, "%s blocks=%llu bytes=%llu arena=%llu rss=%llu untracked=%lld growing=%u\n", stamp,
+                snapshot.trace_blocks, snapshot.trace_bytes, snapshot.arena_reserved_bytes, snapshot.rss_bytes, snapshot.untracked_bytes, snapshot.growing_sites);
+        fflush(g_mem_snapshot_fp);
+        rl_mem_snapshot_rotate_locked();
     }
+    pthread_mutex_unlock(&g_mem_snapshot_lock);
+}
 
-    // 尝试分配内存
-    void *new_ptr = realloc(ptr, size);
-    if (new_ptr == NULL)
+// 快照线程：开启时立即记录一次，之后每个间隔记录一次
+static void *rl_mem_snapshot_worker(void *arg)
+{
+    (void)arg;
+    pthread_mutex_lock(&g_mem_snapshot_wait_mutex);
+    while (g_mem_snapshot_state == RL_TRUE)
     {
-        rl_log_error("[%s:%s:%d] realloc=%p bytes=%d failed", __FILENAME__, __FUNCTION__, __LINE__, ptr, size);
-        return NULL;
+        pthread_mutex_unlock(&g_mem_snapshot_wait_mutex);
+        rl_mem_snapshot_take();
+        pthread_mutex_lock(&g_mem_snapshot_wait_mutex);
+        struct timespec ts;
+        clock_gettime(CLOCK_REALTIME, &ts);
+        ts.tv_sec += g_mem_snapshot_interval / 1000;
+        ts.tv_nsec += (g_mem_snapshot_interval % 1000) * 1000 * 1000;
+        if (ts.tv_nsec >= 1000000000)
+        {
+            ts.tv_sec += 1;
+            ts.tv_nsec -= 1000000000;
+        }
+        while (g_mem_snapshot_state == RL_TRUE && pthread_cond_timedwait(&g_mem_snapshot_wait_cond, &g_mem_snapshot_wait_mutex, &ts) != ETIMEDOUT)
+        {
+        }
     }
-    // 如果启用内存分配跟踪
-    if (rl_memory_trace_state == RL_TRUE)
+    pthread_mutex_unlock(&g_mem_snapshot_wait_mutex);
+    return NULL;
+}
+
+// 开启堆使用快照线程
+int rl_memory_snapshot_start(unsigned int interval_ms)
+{
+    pthread_mutex_lock(&g_mem_snapshot_wait_mutex);
+    if (g_mem_snapshot_state == RL_TRUE)
     {
-        pthread_mutex_lock(&mem_lock);
-        bool found_node = RL_FALSE;
-        MEM_NODE_T *cur = g_mem_header;
-        while (cur != NULL)
+        pthread_mutex_unlock(&g_mem_snapshot_wait_mutex);
+        rl_log_error("[%s:%s:%d] memory snapshot already started", __FILENAME__, __FUNCTION__, __LINE__);
+        return RL_FAILED;
+    }
+    g_mem_snapshot_interval = (interval_ms == 0) ? RL_MEM_SNAPSHOT_INTERVAL : interval_ms;
+    pthread_mutex_unlock(&g_mem_snapshot_wait_mutex);
+
+    pthread_mutex_lock(&g_mem_snapshot_lock);
+    if (rl_mem_trace_file_path(g_mem_snapshot_path, sizeof(g_mem_snapshot_path), RL_MEM_SNAPSHOT_FILE_DIR, "log") == RL_SUCCESS)
+    {
+        g_mem_snapshot_fp = fopen(g_mem_snapshot_path, "a");
+    }
+    if (g_mem_snapshot_fp == NULL)
+    {
+        rl_log_error("[%s:%s:%d] open memory snapshot file failed, snapshots will not be recorded", __FILENAME__, __FUNCTION__, __LINE__);
+    }
+    // 重新开始判断增长趋势（上一个窗口的最低值取最大值，第一个窗口不会计为上升）
+    for (int i = 0; i < RL_MEM_TRACE_SITE_COUNT; i++)
+    {
+        g_mem_snapshot_trend[i].window_min = 0;
+        g_mem_snapshot_trend[i].last_min = ULLONG_MAX;
+        g_mem_snapshot_trend[i].rising = 0;
+    }
+    g_mem_snapshot_tick = 0;
+    g_mem_snapshot_stat_rss = rl_stat_register("rlmem.rss_bytes", RL_STAT_GAUGE);
+    g_mem_snapshot_stat_untracked = rl_stat_register("rlmem.untracked_bytes", RL_STAT_GAUGE);
+    g_mem_snapshot_stat_growing = rl_stat_register("rlmem.growing_sites", RL_STAT_GAUGE);
+    pthread_mutex_unlock(&g_mem_snapshot_lock);
+
+    __atomic_store_n(&g_mem_snapshot_state, RL_TRUE, __ATOMIC_RELEASE);
+    if (pthread_create(&g_mem_snapshot_thread, NULL, rl_mem_snapshot_worker, NULL) != 0)
+    {
+        rl_log_error("[%s:%s:%d] create memory snapshot thread failed", __FILENAME__, __FUNCTION__, __LINE__);
+        __atomic_store_n(&g_mem_snapshot_state, RL_FALSE, __ATOMIC_RELEASE);
+        pthread_mutex_lock(&g_mem_snapshot_lock);
+        if (g_mem_snapshot_fp != NULL)
         {
-            // 需要先找到原来的 ptr 对应节点，并更新其地址和大小
-            if (cur->ptr == ptr)
-            {
-                // 更新总字节数：先减去旧的，再加上新的
-                unsigned int old_size = cur->size;
-                g_alloc_total_bytes -= old_size;
-                g_alloc_total_bytes += size;
-
-                cur->ptr = new_ptr;
-                cur->size = size;
-                cur->file = file;
-                cur->func = func;
-                cur->line = line;
-                found_node = RL_TRUE;
-                break;
-            }
-            cur = cur->next;
+            fclose(g_mem_snapshot_fp);
+            g_mem_snapshot_fp = NULL;
         }
-        pthread_mutex_unlock(&mem_lock);
+        pthread_mutex_unlock(&g_mem_snapshot_lock);
+        return RL_FAILED;
+    }
+    RL_LOGD("[%s:%s:%d] enable memory snapshot, interval=%u ms", __FILENAME__, __FUNCTION__, __LINE__, g_mem_snapshot_interval);
+    return RL_SUCCESS;
+}
 
-        // 如果原来找不到 ptr（比如是从系统 malloc），就添加一条新记录
-        if (found_node == RL_FALSE)
+// 停止堆使用快照线程
+int rl_memory_snapshot_stop()
+{
+    pthread_mutex_lock(&g_mem_snapshot_wait_mutex);
+    bool state = g_mem_snapshot_state;
+    __atomic_store_n(&g_mem_snapshot_state, RL_FALSE, __ATOMIC_RELEASE);
+    pthread_cond_signal(&g_mem_snapshot_wait_cond);
+    pthread_mutex_unlock(&g_mem_snapshot_wait_mutex);
+    if (state == RL_FALSE)
+    {
+        return RL_FAILED;
+    }
+    pthread_join(g_mem_snapshot_thread, NULL);
+    pthread_mutex_lock(&g_mem_snapshot_lock);
+    if (g_mem_snapshot_fp != NULL)
+    {
+        fclose(g_mem_snapshot_fp);
+        g_mem_snapshot_fp = NULL;
+    }
+    pthread_mutex_unlock(&g_mem_snapshot_lock);
+    RL_LOGD("[%s:%s:%d] disable memory snapshot", __FILENAME__, __FUNCTION__, __LINE__);
+    return RL_SUCCESS;
+}
+
+// 获取最近一次快照
+int rl_memory_snapshot_get(rl_mem_snapshot_t *snapshot)
+{
+    if (snapshot == NULL)
+    {
+        rl_log_error("[%s:%s:%d] snapshot is null", __FILENAME__, __FUNCTION__, __LINE__);
+        return RL_FAILED;
+    }
+    pthread_mutex_lock(&g_mem_snapshot_lock);
+    *snapshot = g_mem_snapshot_last;
+    pthread_mutex_unlock(&g_mem_snapshot_lock);
+    return (snapshot->time_ms == 0) ? RL_FAILED : RL_SUCCESS;
+}
+
+// 获取被标记为持续增长的调用点
+int rl_memory_get_growing_sites(rl_mem_site_stats_t *stats, unsigned int max_count)
+{
+    if (stats == NULL || max_count == 0)
+    {
+        rl_log_error("[%s:%s:%d] stats is null or max_count=%u invalid", __FILENAME__, __FUNCTION__, __LINE__, max_count);
+        return RL_FAILED;
+    }
+    unsigned int count = 0;
+    pthread_mutex_lock(&g_mem_snapshot_lock);
+    for (int i = 0; i < RL_MEM_TRACE_SITE_COUNT; i++)
+    {
+        const MEM_SITE_T *site = &g_mem_site[i];
+        if (g_mem_snapshot_trend[i].rising < RL_MEM_SNAPSHOT_GROWTH_WINDOWS || __atomic_load_n(&site->state, __ATOMIC_ACQUIRE) != 2)
         {
-            rl_log_warn("[%s:%s:%d] realloc original ptr=%p not found in trace list, new record created", file, func, line, ptr);
-            MEM_NODE_T *node = (MEM_NODE_T *)malloc(sizeof(MEM_NODE_T));
-            if (node == NULL)
+            continue;
+        }
+        if (count < max_count)
+        {
+            rl_mem_site_read(site, &stats[count++]);
+            continue;
+        }
+        // 已满：替换当前未释放字节数最小的一项
+        unsigned int min = 0;
+        for (unsigned int j = 1; j < count; j++)
+        {
+            if (stats[j].cur_bytes < stats[min].cur_bytes)
             {
-                free(new_ptr);
-                rl_log_error("[%s:%s:%d] memory trace malloc %d bytes failed", __FILENAME__, __FUNCTION__, __LINE__, sizeof(MEM_NODE_T));
-                return NULL;
+                min = j;
             }
-            node->ptr = new_ptr;
-            node->size = size;
-            node->file = file;
-            node->func = func;
-            node->line = line;
-            pthread_mutex_lock(&mem_lock);
-            node->next = g_mem_header;
-            g_mem_header = node;
-            // 新节点，增加统计
-            g_alloc_block_count++;
-            g_alloc_total_bytes += size;
-            pthread_mutex_unlock(&mem_lock);
-        }
-        rl_log_debug("[%s:%s:%d][realloc] old=%p, new=%p, size=%d, total blocks=%d, total bytes=%d", file, func, line, ptr, new_ptr, size, g_alloc_block_count, g_alloc_total_bytes);
+        }
+        if (__atomic_load_n(&site->cur_bytes, __ATOMIC_RELAXED) > stats[min].cur_bytes)
+        {
+            rl_mem_site_read(site, &stats[min]);
+        }
     }
-    return new_ptr;
+    pthread_mutex_unlock(&g_mem_snapshot_lock);
+    qsort(stats, count, sizeof(rl_mem_site_stats_t), rl_mem_site_stats_compare);
+    return count;
 }
@@ -0,0 +1,315 @@
+// rlmem 分配事件日志解码工具（主机端使用）
+// 编译：gcc -O2 -o rlmem_journal_decode rlmem_journal_decode.c
+// 用法：rlmem_journal_decode [-s] [-u] file
+//   -s  按单调时间戳排序输出（事件按线程批量写入，排序后恢复跨线程顺序）
+//   -u  时间显示到微秒
+// 输出与 RL_MEM_TRACE_OUTPUT_TEXT 方式的调试日志内容相同
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+#include <unistd.h>
+
+// 以下定义与 rlmem.c 保持一致
+typedef struct
+{
+    uint16_t magic;
+    uint8_t type;
+    uint8_t reserved;
+    uint32_t len;
+} __attribute__((packed)) MEM_JOURNAL_HEAD_T;
+
+typedef struct
+{
+    MEM_JOURNAL_HEAD_T head;
+    uint32_t version;
+    uint32_t pid;
+    uint64_t real_ns;
+    uint64_t mono_ns;
+    char proc_name[16];
+} __attribute__((packed)) MEM_JOURNAL_SESSION_T;
+
+typedef struct
+{
+    MEM_JOURNAL_HEAD_T head;
+    uint32_t id;
+    int32_t line;
+} __attribute__((packed)) MEM_JOURNAL_SITE_T;
+
+typedef struct
+{
+    uint64_t mono_ns;
+    uint64_t ptr;
+    uint64_t old_ptr;
+    uint64_t size;
+    uint64_t block_count;
+    uint64_t total_bytes;
+    uint32_t site;
+    uint8_t op;
+    uint8_t reserved[3];
+} __attribute__((packed)) MEM_JOURNAL_EVENT_T;
+
+#define RL_MEM_JOURNAL_MAGIC            0x4D52
+#define RL_MEM_JOURNAL_VERSION          2
+#define RL_MEM_JOURNAL_TYPE_SESSION     1
+#define RL_MEM_JOURNAL_TYPE_SITE        2
+#define RL_MEM_JOURNAL_TYPE_EVENT       3
+
+#define RL_MEM_EVENT_MALLOC     1
+#define RL_MEM_EVENT_CALLOC     2
+#define RL_MEM_EVENT_FREE       3
+#define RL_MEM_EVENT_REALLOC    4
+#define RL_MEM_EVENT_ALIGNED    5
+#define RL_MEM_EVENT_HUGE       6
+
+// 调用点
+typedef struct
+{
+    uint32_t id;
+    int line;
+    const char *file;
+    const char *func;
+} SITE_T;
+
+// 待输出的事件
+typedef struct
+{
+    uint32_t tid;
+    size_t order;
+    MEM_JOURNAL_EVENT_T event;
+} EVENT_T;
+
+static MEM_JOURNAL_SESSION_T session;
+static int session_found = 0;
+static SITE_T *sites = NULL;
+static size_t site_count = 0;
+static EVENT_T *events = NULL;
+static size_t event_count = 0;
+static int opt_sort = 0;
+static int opt_usec = 0;
+
+static void *xrealloc(void *ptr, size_t size)
+{
+    void *p = realloc(ptr, size);
+    if (p == NULL)
+    {
+        perror("realloc");
+        exit(EXIT_FAILURE);
+    }
+    return p;
+}
+
+// 读取整个文件
+static char *read_file(const char *path, size_t *len)
+{
+    FILE *fp = fopen(path, "rb");
+    if (fp == NULL)
+    {
+        perror(path);
+        return NULL;
+    }
+    size_t cap = 1 << 20;
+    size_t used = 0;
+    char *buf = xrealloc(NULL, cap);
+    size_t n;
+    while ((n = fread(buf + used, 1, cap - used, fp)) > 0)
+    {
+        used += n;
+        if (used == cap)
+        {
+            cap *= 2;
+            buf = xrealloc(buf, cap);
+        }
+    }
+    fclose(fp);
+    *len = used;
+    return buf;
+}
+
+static int site_cmp(const void *a, const void *b)
+{
+    const SITE_T *sa = (const SITE_T *)a;
+    const SITE_T *sb = (const SITE_T *)b;
+    return (sa->id < sb->id) ? -1 : (sa->id > sb->id);
+}
+
+static const SITE_T *find_site(uint32_t id)
+{
+    SITE_T key = {id, 0, NULL, NULL};
+    return bsearch(&key, sites, site_count, sizeof(SITE_T), site_cmp);
+}
+
+static int event_cmp(const void *a, const void *b)
+{
+    const EVENT_T *ea = (const EVENT_T *)a;
+    const EVENT_T *eb = (const EVENT_T *)b;
+    if (ea->event.mono_ns != eb->event.mono_ns)
+    {
+        return (ea->event.mono_ns < eb->event.mono_ns) ? -1 : 1;
+    }
+    return (ea->order < eb->order) ? -1 : (ea->order > eb->order);
+}
+
+// 遍历文件，收集会话、调用点和事件
+static void walk(const char *path, const char *data, size_t len)
+{
+    size_t off = 0;
+    while (off + sizeof(MEM_JOURNAL_HEAD_T) <= len)
+    {
+        MEM_JOURNAL_HEAD_T head;
+        memcpy(&head, data + off, sizeof(head));
+        if (head.magic != RL_MEM_JOURNAL_MAGIC || head.len < sizeof(head) || off + head.len > len)
+        {
+            fprintf(stderr, "%s: corrupt record at offset %zu, resync\n", path, off);
+            off++;
+            continue;
+        }
+        const char *rec = data + off;
+        if (head.type == RL_MEM_JOURNAL_TYPE_SESSION && head.len >= sizeof(MEM_JOURNAL_SESSION_T))
+        {
+            memcpy(&session, rec, sizeof(session));
+            if (session.version != RL_MEM_JOURNAL_VERSION)
+            {
+                fprintf(stderr, "%s: journal version %u not supported (expect %u)\n", path, session.version, RL_MEM_JOURNAL_VERSION);
+                exit(EXIT_FAILURE);
+            }
+            session_found = 1;
+        }
+        else if (head.type == RL_MEM_JOURNAL_TYPE_SITE && head.len > sizeof(MEM_JOURNAL_SITE_T) + 1)
+        {
+            MEM_JOURNAL_SITE_T s;
+            memcpy(&s, rec, sizeof(s));
+            const char *file = rec + sizeof(s);
+            const char *func = memchr(file, '\0', head.len - sizeof(s));
+            if (func != NULL && func + 1 < rec + head.len && memchr(func + 1, '\0', rec + head.len - func - 1) != NULL)
+            {
+                sites = xrealloc(sites, sizeof(SITE_T) * (site_count + 1));
+                sites[site_count].id = s.id;
+                sites[site_count].line = s.line;
+                sites[site_count].file = file;
+                sites[site_count].func = func + 1;
+                site_count++;
+            }
+        }
+        else if (head.type == RL_MEM_JOURNAL_TYPE_EVENT && head.len >= sizeof(head) + 2 * sizeof(uint32_t))
+        {
+            uint32_t tid;
+            uint32_t count;
+            memcpy(&tid, rec + sizeof(head), sizeof(tid));
+            memcpy(&count, rec + sizeof(head) + sizeof(tid), sizeof(count));
+            const char *p = rec + sizeof(head) + 2 * sizeof(uint32_t);
+            if (p + (size_t)count * sizeof(MEM_JOURNAL_EVENT_T) > rec + head.len)
+            {
+                fprintf(stderr, "%s: truncated event batch at offset %zu\n", path, off);
+                count = (rec + head.len - p) / sizeof(MEM_JOURNAL_EVENT_T);
+            }
+            events = xrealloc(events, sizeof(EVENT_T) * (event_count + count));
+            for (uint32_t i = 0; i < count; i++)
+            {
+                events[event_count].tid = tid;
+                events[event_count].order = event_count;
+                memcpy(&events[event_count].event, p + i * sizeof(MEM_JOURNAL_EVENT_T), sizeof(MEM_JOURNAL_EVENT_T));
+                event_count++;
+            }
+        }
+        off += head.len;
+    }
+}
+
+// 按 RL_MEM_TRACE_OUTPUT_TEXT 的格式输出一个事件
+static void print_event(const EVENT_T *e)
+{
+    static const char *op_name[] = {"", "malloc", "calloc", "free", "realloc", "aligned_alloc", "huge_alloc"};
+    const MEM_JOURNAL_EVENT_T *ev = &e->event;
+    const SITE_T *site = find_site(ev->site);
+    const char *file = (site != NULL) ? site->file : "unknown";
+    const char *func = (site != NULL) ? site->func : "unknown";
+    int line = (site != NULL) ? site->line : 0;
+
+    uint64_t real_ns = (session_found != 0) ? session.real_ns + (ev->mono_ns - session.mono_ns) : ev->mono_ns;
+    time_t sec = real_ns / 1000000000ULL;
+    struct tm tm_info;
+    localtime_r(&sec, &tm_info);
+    char usec[16] = {0};
+    if (opt_usec != 0)
+    {
+        snprintf(usec, sizeof(usec), ".%06llu", (unsigned long long)(real_ns % 1000000000ULL) / 1000);
+    }
+    printf("%02d:%02d:%02d%s-%s-p%u-t%u debug:", tm_info.tm_hour, tm_info.tm_min, tm_info.tm_sec, usec,
+           (session_found != 0) ? session.proc_name : "?", (session_found != 0) ? session.pid : 0, e->tid);
+    void *ptr = (void *)(uintptr_t)ev->ptr;
+    switch (ev->op)
+    {
+    case RL_MEM_EVENT_MALLOC:
+    case RL_MEM_EVENT_CALLOC:
+    case RL_MEM_EVENT_ALIGNED:
+    case RL_MEM_EVENT_HUGE:
+        printf("[%s:%s:%d][%s] addr=%p(%llu bytes), total blocks=%llu, total bytes=%llu\n", file, func, line,
+               op_name[ev->op], ptr, (unsigned long long)ev->size,
+               (unsigned long long)ev->block_count, (unsigned long long)ev->total_bytes);
+        break;
+    case RL_MEM_EVENT_FREE:
+        printf("[%s:%s:%d][free] addr=%p, remain blocks=%llu, remain bytes=%llu\n", file, func, line, ptr,
+               (unsigned long long)ev->block_count, (unsigned long long)ev->total_bytes);
+        break;
+    case RL_MEM_EVENT_REALLOC:
+        printf("[%s:%s:%d][realloc] old=%p, new=%p, size=%llu, total blocks=%llu, total bytes=%llu\n", file, func, line,
+               (void *)(uintptr_t)ev->old_ptr, ptr, (unsigned long long)ev->size,
+               (unsigned long long)ev->block_count, (unsigned long long)ev->total_bytes);
+        break;
+    default:
+        printf("[%s:%s:%d][unknown op %u] addr=%p\n", file, func, line, ev->op, ptr);
+        break;
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    int opt;
+    while ((opt = getopt(argc, argv, "su")) != -1)
+    {
+        if (opt == 's')
+        {
+            opt_sort = 1;
+        }
+        else if (opt == 'u')
+        {
+            opt_usec = 1;
+        }
+        else
+        {
+            fprintf(stderr, "usage: %s [-s] [-u] file\n", argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+    if (optind + 1 != argc)
+    {
+        fprintf(stderr, "usage: %s [-s] [-u] file\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+    size_t len = 0;
+    char *data = read_file(argv[optind], &len);
+    if (data == NULL)
+    {
+        return EXIT_FAILURE;
+    }
+    walk(argv[optind], data, len);
+    if (session_found == 0)
+    {
+        fprintf(stderr, "%s: no session record, times are monotonic\n", argv[optind]);
+    }
+    qsort(sites, site_count, sizeof(SITE_T), site_cmp);
+    if (opt_sort != 0)
+    {
+        qsort(events, event_count, sizeof(EVENT_T), event_cmp);
+    }
+    for (size_t i = 0; i < event_count; i++)
+    {
+        print_event(&events[i]);
+    }
+    free(events);
+    free(sites);
+    free(data);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,97 @@
+#ifndef RL_STAT_H
+#define RL_STAT_H
+
+#include "public.h"
+#include <time.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+// 导出指标的共享内存名称前缀（完整名称为前缀加进程号，位于 /dev/shm 下），使用 rlstat/tools/rlstat_dump 查看
+#define RL_STAT_SHM_PREFIX      "/rlstat."
+// 最多可登记的指标数量
+#define RL_STAT_MAX_COUNT       256
+// 指标名称最大长度（包括结尾的 '\0'）
+#define RL_STAT_NAME_SIZE       48
+// 直方图桶数量（第 0 个桶统计 0，第 i 个桶统计 [2^(i-1), 2^i)，最后一个桶包含更大的值）
+#define RL_STAT_HIST_COUNT      20
+
+// 指标类型
+typedef enum
+{
+    RL_STAT_COUNTER = 1,    // 只增计数
+    RL_STAT_GAUGE,          // 当前值，可增可减或直接设置
+    RL_STAT_HISTOGRAM       // 按 2 的幂分桶统计数值分布（例如耗时），value 为样本数
+} RL_STAT_TYPE;
+
+// 指标（位于共享内存中，布局与 rlstat/tools/rlstat_dump.c 保持一致；按缓存行对齐，不同指标之间不会伪共享）
+typedef struct
+{
+    char name[RL_STAT_NAME_SIZE];
+    unsigned int type;
+    unsigned int reserved;
+    long long value;
+    unsigned long long sum;
+    unsigned long long hist[RL_STAT_HIST_COUNT];
+} __attribute__((aligned(64))) rl_stat_t;
+
+// 登记指标（同名指标返回同一个，类型不同或已满时返回 NULL）
+// 第一次调用时创建共享内存段，失败时指标只保存在进程内存中；以下更新接口都接受 NULL
+rl_stat_t *rl_stat_register(const char *name, RL_STAT_TYPE type);
+
+// 计数/当前值增加 delta（只有一次原子加，不加锁不进入内核）
+static inline void rl_stat_add(rl_stat_t *stat, long long delta)
+{
+    if (stat != NULL)
+    {
+        __atomic_add_fetch(&stat->value, delta, __ATOMIC_RELAXED);
+    }
+}
+
+// 设置当前值
+static inline void rl_stat_set(rl_stat_t *stat, long long value)
+{
+    if (stat != NULL)
+    {
+        __atomic_store_n(&stat->value, value, __ATOMIC_RELAXED);
+    }
+}
+
+// 读取计数/当前值（直方图为样本数）
+static inline long long rl_stat_get(const rl_stat_t *stat)
+{
+    return (stat != NULL) ? __atomic_load_n(&stat->value, __ATOMIC_RELAXED) : 0;
+}
+
+// 直方图记录一个样本
+static inline void rl_stat_observe(rl_stat_t *stat, unsigned long long value)
+{
+    if (stat == NULL)
+    {
+        return;
+    }
+    unsigned int bucket = (value == 0) ? 0 : 64 - __builtin_clzll(value);
+    if (bucket >= RL_STAT_HIST_COUNT)
+    {
+        bucket = RL_STAT_HIST_COUNT - 1;
+    }
+    __atomic_add_fetch(&stat->hist[bucket], 1, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&stat->sum, value, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&stat->value, 1, __ATOMIC_RELAXED);
+}
+
+// 单调时钟（微秒），用于计算直方图耗时
+static inline unsigned long long rl_stat_now_us()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (unsigned long long)ts.tv_sec * 1000000ULL + ts.tv_nsec / 1000;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,216 @@
+#include "rlstat.h"
+#include <errno.h>
+#include <stdint.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+// rllog 也使用本模块统计日志，出错时不能写日志，直接输出到标准错误
+
+#define RL_STAT_MAGIC       0x52535431
+#define RL_STAT_VERSION     1
+
+// 共享内存段头部（布局与 rlstat/tools/rlstat_dump.c 保持一致）
+typedef struct
+{
+    unsigned int magic;         // 头部填写完成后最后写入
+    unsigned int version;
+    unsigned int pid;
+    unsigned int capacity;
+    unsigned int count;         // 已登记的指标数量（只增，指标内容写完后才增加）
+    unsigned int stat_size;     // sizeof(rl_stat_t)
+    unsigned long long start_ms;// 创建时间（1970 年起的毫秒数）
+    char proc_name[16];
+} __attribute__((aligned(64))) RL_STAT_SHM_HEAD_T;
+
+typedef struct
+{
+    RL_STAT_SHM_HEAD_T head;
+    rl_stat_t stat[RL_STAT_MAX_COUNT];
+} RL_STAT_SHM_T;
+
+// 指标表（创建共享内存失败时使用进程内的 rl_stat_local）
+static RL_STAT_SHM_T *rl_stat_shm = NULL;
+static RL_STAT_SHM_T rl_stat_local;
+static pthread_once_t rl_stat_once = PTHREAD_ONCE_INIT;
+// 保护登记过程（更新指标不需要加锁）
+static pthread_mutex_t rl_stat_mutex = PTHREAD_MUTEX_INITIALIZER;
+// 创建共享内存段的进程（fork 出的子进程退出时不能删除父进程的共享内存段）
+static pid_t rl_stat_owner = 0;
+static char rl_stat_shm_name[32] = {0};
+// fork 出的子进程尚未创建自己的共享内存段
+static bool rl_stat_forked = RL_FALSE;
+
+// 进程退出时删除共享内存段
+static void rl_stat_unlink()
+{
+    if (getpid() == rl_stat_owner)
+    {
+        shm_unlink(rl_stat_shm_name);
+    }
+}
+
+// 创建并映射 rl_stat_shm_name 对应的共享内存段，addr 不为 NULL 时替换该地址上原有的映射，失败返回 NULL
+static void *rl_stat_shm_map(void *addr)
+{
+    // 进程号可能被复用，截断后重新设置大小，内容全部清零
+    int fd = shm_open(rl_stat_shm_name, O_CREAT | O_RDWR | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0)
+    {
+        return NULL;
+    }
+    void *base = MAP_FAILED;
+    if (ftruncate(fd, sizeof(RL_STAT_SHM_T)) == 0)
+    {
+        // 替换映射前先写入当前内容，替换后指标地址不变、数值连续
+        if (addr == NULL || pwrite(fd, addr, sizeof(RL_STAT_SHM_T), 0) == (ssize_t)sizeof(RL_STAT_SHM_T))
+        {
+            base = mmap(addr, sizeof(RL_STAT_SHM_T), PROT_READ | PROT_WRITE, MAP_SHARED | ((addr != NULL) ? MAP_FIXED : 0), fd, 0);
+        }
+    }
+    close(fd);
+    if (base == MAP_FAILED)
+    {
+        shm_unlink(rl_stat_shm_name);
+        return NULL;
+    }
+    return base;
+}
+
+static void rl_stat_atfork_prepare()
+{
+    pthread_mutex_lock(&rl_stat_mutex);
+}
+
+static void rl_stat_atfork_parent()
+{
+    pthread_mutex_unlock(&rl_stat_mutex);
+}
+
+// fork 后子进程仍映射着父进程的共享内存段：换成私有内存，避免子进程的更新计入父进程
+// 多线程进程的子进程中只能做异步信号安全的操作，子进程自己的共享内存段在首次登记指标时创建
+static void rl_stat_atfork_child()
+{
+    memcpy(&rl_stat_local, rl_stat_shm, sizeof(RL_STAT_SHM_T));
+    void *base = mmap(rl_stat_shm, sizeof(RL_STAT_SHM_T), PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED, -1, 0);
+    if (base != MAP_FAILED)
+    {
+        memcpy(base, &rl_stat_local, sizeof(RL_STAT_SHM_T));
+    }
+    rl_stat_owner = 0;
+    rl_stat_forked = RL_TRUE;
+    pthread_mutex_unlock(&rl_stat_mutex);
+}
+
+// fork 出的子进程首次登记指标时创建自己的共享内存段，替换 fork 时换上的私有内存（调用者需持有 rl_stat_mutex）
+// 替换期间其他线程对已有指标的更新可能丢失；只 fork 后 exec 或 _exit 的子进程不会创建共享内存段
+static void rl_stat_fork_attach()
+{
+    rl_stat_forked = RL_FALSE;
+    snprintf(rl_stat_shm_name, sizeof(rl_stat_shm_name), "%s%d", RL_STAT_SHM_PREFIX, getpid());
+    if (rl_stat_shm_map(rl_stat_shm) == NULL)
+    {
+        char err_msg[128] = {0};
+        snprintf(err_msg, sizeof(err_msg), "[rlstat:%s:%d] create shm %s failed, stats are process local", __FUNCTION__, __LINE__, rl_stat_shm_name);
+        perror(err_msg);
+        return;
+    }
+    rl_stat_owner = getpid();
+    rl_stat_shm->head.pid = rl_stat_owner;
+}
+
+// 创建共享内存段并填写头部
+static void rl_stat_init_once()
+{
+    char err_msg[128] = {0};
+    snprintf(rl_stat_shm_name, sizeof(rl_stat_shm_name), "%s%d", RL_STAT_SHM_PREFIX, getpid());
+    rl_stat_shm = (RL_STAT_SHM_T *)rl_stat_shm_map(NULL);
+    if (rl_stat_shm == NULL)
+    {
+        snprintf(err_msg, sizeof(err_msg), "[rlstat:%s:%d] create shm %s failed, stats are process local", __FUNCTION__, __LINE__, rl_stat_shm_name);
+        perror(err_msg);
+        rl_stat_shm = &rl_stat_local;
+    }
+    else
+    {
+        rl_stat_owner = getpid();
+        atexit(rl_stat_unlink);
+        pthread_atfork(rl_stat_atfork_prepare, rl_stat_atfork_parent, rl_stat_atfork_child);
+    }
+
+    RL_STAT_SHM_HEAD_T *head = &rl_stat_shm->head;
+    head->version = RL_STAT_VERSION;
+    head->pid = getpid();
+    head->capacity = RL_STAT_MAX_COUNT;
+    head->count = 0;
+    head->stat_size = sizeof(rl_stat_t);
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    head->start_ms = (unsigned long long)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+    // 这里不能依赖 rlsys（rlsys 依赖 rllog），直接读取进程名
+    int comm_fd = open("/proc/self/comm", O_RDONLY | O_CLOEXEC);
+    if (comm_fd >= 0)
+    {
+        ssize_t len = read(comm_fd, head->proc_name, sizeof(head->proc_name) - 1);
+        if (len > 0 && head->proc_name[len - 1] == '\n')
+        {
+            head->proc_name[len - 1] = '\0';
+        }
+        close(comm_fd);
+    }
+    __atomic_store_n(&head->magic, RL_STAT_MAGIC, __ATOMIC_RELEASE);
+}
+
+// 登记指标
+rl_stat_t *rl_stat_register(const char *name, RL_STAT_TYPE type)
+{
+    char err_msg[128] = {0};
+    if (name == NULL || name[0] == '\0' || strlen(name) >= RL_STAT_NAME_SIZE ||
+        (type != RL_STAT_COUNTER && type != RL_STAT_GAUGE && type != RL_STAT_HISTOGRAM))
+    {
+        snprintf(err_msg, sizeof(err_msg), "[rlstat:%s:%d] name or type=%d invalid", __FUNCTION__, __LINE__, type);
+        errno = EINVAL;
+        perror(err_msg);
+        return NULL;
+    }
+    pthread_once(&rl_stat_once, rl_stat_init_once);
+
+    pthread_mutex_lock(&rl_stat_mutex);
+    if (rl_stat_forked == RL_TRUE)
+    {
+        rl_stat_fork_attach();
+    }
+    unsigned int count = rl_stat_shm->head.count;
+    for (unsigned int i = 0; i < count; i++)
+    {
+        rl_stat_t *stat = &rl_stat_shm->stat[i];
+        if (strcmp(stat->name, name) != 0)
+        {
+            continue;
+        }
+        pthread_mutex_unlock(&rl_stat_mutex);
+        if (stat->type != (unsigned int)type)
+        {
+            snprintf(err_msg, sizeof(err_msg), "[rlstat:%s:%d] %s already registered with type=%u", __FUNCTION__, __LINE__, name, stat->type);
+            errno = EEXIST;
+            perror(err_msg);
+            return NULL;
+        }
+        return stat;
+    }
+    if (count == RL_STAT_MAX_COUNT)
+    {
+        pthread_mutex_unlock(&rl_stat_mutex);
+        snprintf(err_msg, sizeof(err_msg), "[rlstat:%s:%d] stat table full, %s not registered", __FUNCTION__, __LINE__, name);
+        errno = ENOSPC;
+        perror(err_msg);
+        return NULL;
+    }
+    rl_stat_t *stat = &rl_stat_shm->stat[count];
+    memset(stat, 0, sizeof(rl_stat_t));
+    strcpy(stat->name, name);
+    stat->type = type;
+    // 读取方看到新的数量时指标内容已经写完
+    __atomic_store_n(&rl_stat_shm->head.count, count + 1, __ATOMIC_RELEASE);
+    pthread_mutex_unlock(&rl_stat_mutex);
+    return stat;
+}
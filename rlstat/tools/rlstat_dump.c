@@ -0,0 +1,258 @@
+// rlstat 指标查看工具（设备端使用，只读映射共享内存，不影响被查看的进程）
+// 编译：gcc -O2 -o rlstat_dump rlstat_dump.c -lrt
+// 用法：rlstat_dump [-c]                 列出所有导出指标的进程（-c 删除进程已退出的共享内存段）
+//       rlstat_dump [-i ms] pid          输出进程的指标（-i 每隔 ms 毫秒输出一次，计数显示每秒增量）
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <signal.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <dirent.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+// 以下定义与 rlstat.h/rlstat.c 保持一致
+#define RL_STAT_SHM_PREFIX      "/rlstat."
+#define RL_STAT_NAME_SIZE       48
+#define RL_STAT_HIST_COUNT      20
+#define RL_STAT_MAGIC           0x52535431
+#define RL_STAT_VERSION         1
+
+#define RL_STAT_COUNTER         1
+#define RL_STAT_GAUGE           2
+#define RL_STAT_HISTOGRAM       3
+
+typedef struct
+{
+    char name[RL_STAT_NAME_SIZE];
+    unsigned int type;
+    unsigned int reserved;
+    long long value;
+    unsigned long long sum;
+    unsigned long long hist[RL_STAT_HIST_COUNT];
+} __attribute__((aligned(64))) rl_stat_t;
+
+typedef struct
+{
+    unsigned int magic;
+    unsigned int version;
+    unsigned int pid;
+    unsigned int capacity;
+    unsigned int count;
+    unsigned int stat_size;
+    unsigned long long start_ms;
+    char proc_name[16];
+} __attribute__((aligned(64))) RL_STAT_SHM_HEAD_T;
+
+// 映射进程的共享内存段（只读），失败返回 NULL
+static const RL_STAT_SHM_HEAD_T *map_shm(const char *name, size_t *map_len)
+{
+    int fd = shm_open(name, O_RDONLY, 0);
+    if (fd < 0)
+    {
+        return NULL;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(RL_STAT_SHM_HEAD_T))
+    {
+        close(fd);
+        return NULL;
+    }
+    void *addr = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (addr == MAP_FAILED)
+    {
+        return NULL;
+    }
+    const RL_STAT_SHM_HEAD_T *head = (const RL_STAT_SHM_HEAD_T *)addr;
+    if (__atomic_load_n(&head->magic, __ATOMIC_ACQUIRE) != RL_STAT_MAGIC || head->version != RL_STAT_VERSION ||
+        head->stat_size != sizeof(rl_stat_t) || sizeof(RL_STAT_SHM_HEAD_T) + (size_t)head->capacity * sizeof(rl_stat_t) > (size_t)st.st_size)
+    {
+        munmap(addr, st.st_size);
+        return NULL;
+    }
+    *map_len = st.st_size;
+    return head;
+}
+
+// 进程是否仍在运行
+static int pid_alive(unsigned int pid)
+{
+    return kill((pid_t)pid, 0) == 0 || errno == EPERM;
+}
+
+// 列出所有导出指标的进程
+static int list_all(int clean)
+{
+    DIR *dir = opendir("/dev/shm");
+    if (dir == NULL)
+    {
+        perror("/dev/shm");
+        return EXIT_FAILURE;
+    }
+    const char *prefix = RL_STAT_SHM_PREFIX + 1;
+    struct dirent *entry;
+    while ((entry = readdir(dir)) != NULL)
+    {
+        if (strncmp(entry->d_name, prefix, strlen(prefix)) != 0)
+        {
+            continue;
+        }
+        char name[300];
+        snprintf(name, sizeof(name), "/%s", entry->d_name);
+        size_t map_len = 0;
+        const RL_STAT_SHM_HEAD_T *head = map_shm(name, &map_len);
+        if (head == NULL)
+        {
+            printf("%-24s invalid\n", entry->d_name);
+            continue;
+        }
+        int alive = pid_alive(head->pid);
+        printf("%-24s pid=%-8u proc=%-16s stats=%u%s\n", entry->d_name, head->pid, head->proc_name,
+               __atomic_load_n(&head->count, __ATOMIC_ACQUIRE), alive ? "" : " (exited)");
+        if (!alive && clean && shm_unlink(name) == 0)
+        {
+            printf("%-24s removed\n", entry->d_name);
+        }
+        munmap((void *)head, map_len);
+    }
+    closedir(dir);
+    return EXIT_SUCCESS;
+}
+
+// 直方图第 ratio 分位数所在桶的上界
+static unsigned long long hist_quantile(const unsigned long long *hist, unsigned long long total, double ratio)
+{
+    if (total == 0)
+    {
+        return 0;
+    }
+    unsigned long long target = (unsigned long long)(total * ratio);
+    if (target >= total)
+    {
+        target = total - 1;
+    }
+    unsigned long long seen = 0;
+    for (int i = 0; i < RL_STAT_HIST_COUNT; i++)
+    {
+        seen += hist[i];
+        if (seen > target)
+        {
+            return (i == 0) ? 0 : (1ULL << i) - 1;
+        }
+    }
+    return (1ULL << (RL_STAT_HIST_COUNT - 1)) - 1;
+}
+
+// 输出一次指标，prev 不为 NULL 时计数按 interval_ms 显示每秒增量、直方图只统计增量
+static void print_stats(const RL_STAT_SHM_HEAD_T *head, rl_stat_t *prev, unsigned int interval_ms)
+{
+    const rl_stat_t *stats = (const rl_stat_t *)(head + 1);
+    unsigned int count = __atomic_load_n(&head->count, __ATOMIC_ACQUIRE);
+    for (unsigned int i = 0; i < count && i < head->capacity; i++)
+    {
+        rl_stat_t cur;
+        memcpy(&cur, &stats[i], sizeof(cur));
+        cur.name[RL_STAT_NAME_SIZE - 1] = '\0';
+        rl_stat_t delta = cur;
+        if (prev != NULL && cur.type != RL_STAT_GAUGE)
+        {
+            delta.value = cur.value - prev[i].value;
+            delta.sum = cur.sum - prev[i].sum;
+            for (int j = 0; j < RL_STAT_HIST_COUNT; j++)
+            {
+                delta.hist[j] = cur.hist[j] - prev[i].hist[j];
+            }
+        }
+        if (cur.type == RL_STAT_COUNTER)
+        {
+            if (prev != NULL && interval_ms != 0)
+            {
+                printf("%-40s counter   %lld (%.1f/s)\n", cur.name, cur.value, delta.value * 1000.0 / interval_ms);
+            }
+            else
+            {
+                printf("%-40s counter   %lld\n", cur.name, cur.value);
+            }
+        }
+        else if (cur.type == RL_STAT_GAUGE)
+        {
+            printf("%-40s gauge     %lld\n", cur.name, cur.value);
+        }
+        else if (cur.type == RL_STAT_HISTOGRAM)
+        {
+            unsigned long long n = (unsigned long long)delta.value;
+            printf("%-40s histogram count=%llu avg=%llu p50<=%llu p99<=%llu max<=%llu\n", cur.name, n,
+                   (n != 0) ? delta.sum / n : 0, hist_quantile(delta.hist, n, 0.5), hist_quantile(delta.hist, n, 0.99),
+                   hist_quantile(delta.hist, n, 1.0));
+        }
+        if (prev != NULL)
+        {
+            prev[i] = cur;
+        }
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    int opt;
+    int clean = 0;
+    unsigned int interval_ms = 0;
+    while ((opt = getopt(argc, argv, "ci:")) != -1)
+    {
+        if (opt == 'c')
+        {
+            clean = 1;
+        }
+        else if (opt == 'i')
+        {
+            interval_ms = (unsigned int)strtoul(optarg, NULL, 10);
+        }
+        else
+        {
+            fprintf(stderr, "usage: %s [-c] | [-i ms] pid\n", argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+    if (optind == argc)
+    {
+        return list_all(clean);
+    }
+    char name[64];
+    snprintf(name, sizeof(name), "%s%s", RL_STAT_SHM_PREFIX, argv[optind]);
+    size_t map_len = 0;
+    const RL_STAT_SHM_HEAD_T *head = map_shm(name, &map_len);
+    if (head == NULL)
+    {
+        fprintf(stderr, "%s: no valid stats segment\n", name);
+        return EXIT_FAILURE;
+    }
+    printf("pid=%u proc=%s\n", head->pid, head->proc_name);
+    if (interval_ms == 0)
+    {
+        print_stats(head, NULL, 0);
+        munmap((void *)head, map_len);
+        return EXIT_SUCCESS;
+    }
+    // 周期输出：先记录一次基准，之后每次输出区间内的增量
+    rl_stat_t *prev = calloc(head->capacity, sizeof(rl_stat_t));
+    if (prev == NULL)
+    {
+        perror("calloc");
+        return EXIT_FAILURE;
+    }
+    memcpy(prev, head + 1, (size_t)__atomic_load_n(&head->count, __ATOMIC_ACQUIRE) * sizeof(rl_stat_t));
+    while (pid_alive(head->pid))
+    {
+        usleep(interval_ms * 1000);
+        printf("----\n");
+        print_stats(head, prev, interval_ms);
+        fflush(stdout);
+    }
+    free(prev);
+    munmap((void *)head, map_len);
+    return EXIT_SUCCESS;
+}
@@ -15,14 +15,84 @@ typedef struct
     bool valid;
 } cpu_usage_t;
 
+// CPU 利用率采样器（保持 /proc/stat 打开，重复采样不再打开文件），不是线程安全的，每个调用者使用自己的采样器
+typedef struct rl_cpu_sampler rl_cpu_sampler_t;
+
+// 一个 CPU（或全部 CPU 汇总）在两次采样之间的利用率，单位都是千分之一，与 rl_get_cpu_usage 的返回值一致
+typedef struct
+{
+    int id;         // CPU 编号，汇总为 -1
+    int usage;      // 总利用率（iowait 与 rl_get_cpu_usage 一样算作空闲）
+    int user;       // 用户态（包括 nice）
+    int system;     // 内核态
+    int iowait;     // IO 等待
+    int irq;        // 硬中断和软中断
+    int steal;      // 被虚拟机管理程序占用
+} rl_cpu_stat_t;
+
+// 进程自身运行状况（rl_sys_snapshot 一次采集）
+typedef struct
+{
+    unsigned long long rss_kb;          // 当前常驻内存（KB）
+    unsigned long long hwm_kb;          // 常驻内存峰值（KB）
+    int threads;                        // 线程数量
+    int fd_count;                       // 使用的文件句柄数量，获取失败为 RL_FAILED
+    int fd_limit;                       // 文件句柄数量上限（rl_get_fd_limit）
+    unsigned long long voluntary_ctxt_switches;     // 主动上下文切换次数（所有线程）
+    unsigned long long nonvoluntary_ctxt_switches;  // 被动上下文切换次数（所有线程）
+    unsigned long long minor_faults;    // 次缺页次数
+    unsigned long long major_faults;    // 主缺页次数（需要读磁盘）
+    unsigned long long utime_ms;        // 用户态 CPU 时间（毫秒）
+    unsigned long long stime_ms;        // 内核态 CPU 时间（毫秒）
+    int temperature;                    // CPU 温度（与 rl_get_cpu_temperature 相同），获取失败为 RL_FAILED
+} rl_sys_snapshot_t;
+
+// 系统监视线程各项的采样间隔（毫秒），0 使用默认值
+typedef struct
+{
+    unsigned int cpu_ms;            // CPU 利用率
+    unsigned int temperature_ms;    // CPU 温度
+    unsigned int proc_ms;           // 常驻内存、线程数和文件句柄数量
+    unsigned int loadavg_ms;        // 系统负载
+} rl_sys_monitor_config_t;
+
+// 系统监视线程最近一次的采样结果（各项按各自的间隔更新）
+typedef struct
+{
+    unsigned long long update_ms;   // 最近一次更新时间（CLOCK_MONOTONIC 毫秒），0 表示还没有采样
+    rl_cpu_stat_t cpu;              // 全部 CPU 汇总的利用率（第一个间隔之后才有数值）
+    int temperature;                // CPU 温度（与 rl_get_cpu_temperature 相同），获取失败为 RL_FAILED
+    unsigned long long rss_kb;      // 当前常驻内存（KB）
+    int threads;                    // 线程数量
+    int fd_count;                   // 使用的文件句柄数量
+    int load_1;                     // 1 分钟平均负载乘以 100
+    int load_5;                     // 5 分钟平均负载乘以 100
+    int load_15;                    // 15 分钟平均负载乘以 100
+} rl_sys_monitor_t;
+
 // CPU 温度
 #define SYS_CPU_GET_TEMPERATURE_FILE    "/sys/class/thermal/thermal_zone0/temp"
 // CPU 信息
 #define SYS_CPU_GET_INFORMATION_FILE    "/proc/stat"
+// 采样器最多统计的 CPU 核数
+#define SYS_CPU_SAMPLER_MAX_COUNT       64
+// 系统监视线程默认采样间隔（毫秒）
+#define SYS_MONITOR_CPU_INTERVAL            1000
+#define SYS_MONITOR_TEMPERATURE_INTERVAL    5000
+#define SYS_MONITOR_PROC_INTERVAL           1000
+#define SYS_MONITOR_LOADAVG_INTERVAL        5000
 // 程序路径
 #define SYS_PROC_GET_PATH_FILE          "/proc/self/exe"
 // 进程状态
 #define SYS_PROC_GET_STATUS_FILE        "/proc/self/status"
+// 进程内存使用（页数）
+#define SYS_PROC_GET_STATM_FILE         "/proc/self/statm"
+// 进程统计（缺页、CPU 时间、线程数）
+#define SYS_PROC_GET_STAT_FILE          "/proc/self/stat"
+// 系统负载
+#define SYS_GET_LOADAVG_FILE            "/proc/loadavg"
+// 进程打开的文件
+#define SYS_PROC_GET_FD_DIR             "/proc/self/fd"
 // 进程名称
 #define SYS_PROC_GET_NAME_FILE          "/proc/self/comm"
 
@@ -30,6 +100,16 @@ typedef struct
 // 采样并计算CPU利用率
 int rl_get_cpu_usage(cpu_usage_t *tracker);
 
+// 创建 CPU 利用率采样器
+rl_cpu_sampler_t *rl_cpu_sampler_create();
+
+// 采样并计算与上次采样之间的利用率，total 为全部 CPU 汇总（可为 NULL），cores 按编号顺序最多填写 max_cores 个
+// 返回填写的核数，失败返回 RL_FAILED；首次采样（以及新上线的核）各项均为 0
+int rl_cpu_sampler_sample(rl_cpu_sampler_t *sampler, rl_cpu_stat_t *total, rl_cpu_stat_t *cores, int max_cores);
+
+// 销毁 CPU 利用率采样器
+int rl_cpu_sampler_destroy(rl_cpu_sampler_t *sampler);
+
 // 查看当前cpu温度（51440）
 int rl_get_cpu_temperature();
 
@@ -42,15 +122,31 @@ int rl_get_proc_dir(char *buf, unsigned int len);
 // 获取文件相对程序的绝对路径
 int rl_get_file_abs_path(char *buf, unsigned int len, const char *file_path);
 
-// 获取使用的文件句柄数量
+// 获取使用的文件句柄数量（保持 /proc/self/fd 打开，Linux 6.2 起不遍历目录）
+// 不包括 rlsys 自身保持打开的文件（/proc/self/fd 目录、rl_sys_snapshot 和系统监视线程读取的文件）
 int rl_get_fd_count();
 
+// 获取文件句柄数量上限（RLIMIT_NOFILE 软限制，第一次调用后缓存，之后的 setrlimit 不会反映）
+int rl_get_fd_limit();
+
 // 获取使用的内存情况（单位是 KB）
 int rl_get_memory_usage();
 
+// 一次采集进程自身运行状况（文件保持打开，每次从头重新读取），返回 RL_SUCCESS 或 RL_FAILED
+int rl_sys_snapshot(rl_sys_snapshot_t *snap);
+
 // 获取当前进程的名称
 int rl_get_proc_name(char *name, unsigned int len);
 
+// 开启系统监视线程（config 为 NULL 时全部使用默认间隔），采样结果通过 rl_sys_monitor_get 读取
+int rl_sys_monitor_start(const rl_sys_monitor_config_t *config);
+
+// 停止系统监视线程
+int rl_sys_monitor_stop();
+
+// 读取系统监视线程最近一次的采样结果（不加锁不进入内核，可在任意线程频繁调用），还没有采样时返回 RL_FAILED
+int rl_sys_monitor_get(rl_sys_monitor_t *data);
+
 // 计算代码运行时间
 double rl_calcuate_run_time_ms(const struct timespec *start);
 
@@ -1,9 +1,12 @@
 #include "rlsys.h"
 #include "rl/rlstr.h"
 #include <libgen.h>
-#include <dirent.h>
+#include <limits.h>
 #include <stdio.h>
 #include <time.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
 
 #define __FILENAME__ "rlsys"
 
@@ -71,6 +74,202 @@ int rl_get_cpu_usage(cpu_usage_t *tracker)
     return (int)((total_diff - idle_diff) * 1000 / total_diff);
 }
 
+// /proc/stat 中 cpu 行的各项时间（单位 USER_HZ）
+enum
+{
+    CPU_TICK_USER = 0,
+    CPU_TICK_NICE,
+    CPU_TICK_SYSTEM,
+    CPU_TICK_IDLE,
+    CPU_TICK_IOWAIT,
+    CPU_TICK_IRQ,
+    CPU_TICK_SOFTIRQ,
+    CPU_TICK_STEAL,
+    CPU_TICK_COUNT      // 之后的 guest/guest_nice 已包含在 user/nice 中，不读取
+};
+
+typedef struct
+{
+    unsigned long long tick[CPU_TICK_COUNT];
+    bool valid;
+} CPU_TICKS_T;
+
+// 读取 /proc/stat 的缓冲区大小（cpu 行在文件开头，只读取这部分，后面的 intr 等行可能很长）
+#define SYS_CPU_SAMPLER_BUF_SIZE    8192
+
+struct rl_cpu_sampler
+{
+    int fd;
+    CPU_TICKS_T last_total;
+    CPU_TICKS_T last[SYS_CPU_SAMPLER_MAX_COUNT];
+    char buf[SYS_CPU_SAMPLER_BUF_SIZE];
+};
+
+// 解析十进制无符号数（跳过前导空格），没有数字时返回 NULL
+static const char *rl_sys_parse_ull(const char *p, const char *end, unsigned long long *value)
+{
+    while (p < end && *p == ' ')
+    {
+        p++;
+    }
+    if (p == end || *p < '0' || *p > '9')
+    {
+        return NULL;
+    }
+    unsigned long long v = 0;
+    while (p < end && *p >= '0' && *p <= '9')
+    {
+        v = v * 10 + (unsigned long long)(*p - '0');
+        p++;
+    }
+    *value = v;
+    return p;
+}
+
+// 根据两次采样的时间计算利用率，计数回退（CPU 下线后重新上线）时各项为 0
+static void rl_cpu_sampler_calc(const CPU_TICKS_T *last, const CPU_TICKS_T *curr, int id, rl_cpu_stat_t *stat)
+{
+    memset(stat, 0, sizeof(rl_cpu_stat_t));
+    stat->id = id;
+    if (last->valid == RL_FALSE)
+    {
+        return;
+    }
+    unsigned long long diff[CPU_TICK_COUNT];
+    unsigned long long total_diff = 0;
+    for (int i = 0; i < CPU_TICK_COUNT; i++)
+    {
+        if (curr->tick[i] < last->tick[i])
+        {
+            return;
+        }
+        diff[i] = curr->tick[i] - last->tick[i];
+        total_diff += diff[i];
+    }
+    if (total_diff == 0)
+    {
+        return;
+    }
+    unsigned long long idle_diff = diff[CPU_TICK_IDLE] + diff[CPU_TICK_IOWAIT];
+    stat->usage = (int)((total_diff - idle_diff) * 1000 / total_diff);
+    stat->user = (int)((diff[CPU_TICK_USER] + diff[CPU_TICK_NICE]) * 1000 / total_diff);
+    stat->system = (int)(diff[CPU_TICK_SYSTEM] * 1000 / total_diff);
+    stat->iowait = (int)(diff[CPU_TICK_IOWAIT] * 1000 / total_diff);
+    stat->irq = (int)((diff[CPU_TICK_IRQ] + diff[CPU_TICK_SOFTIRQ]) * 1000 / total_diff);
+    stat->steal = (int)(diff[CPU_TICK_STEAL] * 1000 / total_diff);
+}
+
+// 创建 CPU 利用率采样器
+rl_cpu_sampler_t *rl_cpu_sampler_create()
+{
+    rl_cpu_sampler_t *sampler = (rl_cpu_sampler_t *)calloc(1, sizeof(rl_cpu_sampler_t));
+    if (sampler == NULL)
+    {
+        rl_log_error("[%s:%s:%d] calloc cpu sampler failed", __FILENAME__, __FUNCTION__, __LINE__);
+        return NULL;
+    }
+    sampler->fd = open(SYS_CPU_GET_INFORMATION_FILE, O_RDONLY | O_CLOEXEC);
+    if (sampler->fd < 0)
+    {
+        rl_log_error("[%s:%s:%d] open file:%s failed", __FILENAME__, __FUNCTION__, __LINE__, SYS_CPU_GET_INFORMATION_FILE);
+        free(sampler);
+        return NULL;
+    }
+    return sampler;
+}
+
+// 采样并计算与上次采样之间的利用率
+int rl_cpu_sampler_sample(rl_cpu_sampler_t *sampler, rl_cpu_stat_t *total, rl_cpu_stat_t *cores, int max_cores)
+{
+    if (sampler == NULL || (cores == NULL && max_cores > 0))
+    {
+        rl_log_error("[%s:%s:%d] sampler or cores is null", __FILENAME__, __FUNCTION__, __LINE__);
+        return RL_FAILED;
+    }
+    // 从头重新读取（/proc 文件每次读取都会重新生成内容）
+    ssize_t len = pread(sampler->fd, sampler->buf, sizeof(sampler->buf), 0);
+    if (len <= 0)
+    {
+        rl_log_error("[%s:%s:%d] pread file:%s failed", __FILENAME__, __FUNCTION__, __LINE__, SYS_CPU_GET_INFORMATION_FILE);
+        return RL_FAILED;
+    }
+
+    // 逐行解析 "cpu" 和 "cpuN" 行，遇到其他行或不完整的行结束
+    const char *p = sampler->buf;
+    const char *end = sampler->buf + len;
+    bool seen[SYS_CPU_SAMPLER_MAX_COUNT] = {RL_FALSE};
+    int count = 0;
+    while (end - p > 3 && memcmp(p, "cpu", 3) == 0)
+    {
+        const char *eol = memchr(p, '\n', end - p);
+        if (eol == NULL)
+        {
+            break;
+        }
+        p += 3;
+        int id = -1;
+        if (*p != ' ')
+        {
+            unsigned long long n = 0;
+            p = rl_sys_parse_ull(p, eol, &n);
+            if (p == NULL)
+            {
+                break;
+            }
+            id = (n < SYS_CPU_SAMPLER_MAX_COUNT) ? (int)n : SYS_CPU_SAMPLER_MAX_COUNT;
+        }
+        // 较早的内核没有 steal 等后面的字段，按 0 处理
+        CPU_TICKS_T curr = {{0}, RL_TRUE};
+        for (int i = 0; i < CPU_TICK_COUNT && p != NULL; i++)
+        {
+            p = rl_sys_parse_ull(p, eol, &curr.tick[i]);
+        }
+        p = eol + 1;
+
+        if (id < 0)
+        {
+            if (total != NULL)
+            {
+                rl_cpu_sampler_calc(&sampler->last_total, &curr, -1, total);
+            }
+            sampler->last_total = curr;
+        }
+        else if (id < SYS_CPU_SAMPLER_MAX_COUNT)
+        {
+            if (count < max_cores)
+            {
+                rl_cpu_sampler_calc(&sampler->last[id], &curr, id, &cores[count]);
+                count++;
+            }
+            sampler->last[id] = curr;
+            seen[id] = RL_TRUE;
+        }
+    }
+
+    // 已下线的核下次上线时重新开始计算
+    for (int i = 0; i < SYS_CPU_SAMPLER_MAX_COUNT; i++)
+    {
+        if (seen[i] == RL_FALSE)
+        {
+            sampler->last[i].valid = RL_FALSE;
+        }
+    }
+    return count;
+}
+
+// 销毁 CPU 利用率采样器
+int rl_cpu_sampler_destroy(rl_cpu_sampler_t *sampler)
+{
+    if (sampler == NULL)
+    {
+        rl_log_error("[%s:%s:%d] sampler is null", __FILENAME__, __FUNCTION__, __LINE__);
+        return RL_FAILED;
+    }
+    close(sampler->fd);
+    free(sampler);
+    return RL_SUCCESS;
+}
+
 // 查看当前cpu温度（51440）
 int rl_get_cpu_temperature()
 {
@@ -175,39 +374,117 @@ int rl_get_file_abs_path(char *buf, unsigned int len,const char *file_path)
     return RL_SUCCESS;
 }
 
-// 获取使用的文件句柄数量
+// getdents64 返回的目录项
+typedef struct
+{
+    unsigned long long d_ino;
+    long long d_off;
+    unsigned short d_reclen;
+    unsigned char d_type;
+    char d_name[];
+} SYS_DIRENT64_T;
+
+// rl_get_fd_count 保持打开的 /proc/self/fd（fork 后子进程需要重新打开）
+static int g_sys_fd_dir = -1;
+static pid_t g_sys_fd_dir_pid = 0;
+// 打开时目录的身份（应用可能关闭了该句柄，句柄号又被其他文件复用）
+static dev_t g_sys_fd_dir_dev = 0;
+static ino_t g_sys_fd_dir_ino = 0;
+static pthread_mutex_t g_sys_fd_mutex = PTHREAD_MUTEX_INITIALIZER;
+// rl_sys_snapshot 和系统监视线程保持打开的文件数量（rl_get_fd_count 不计入）
+static int g_sys_held_fd_count = 0;
+// 缓存的文件句柄数量上限
+static int g_sys_fd_limit = 0;
+static pthread_once_t g_sys_fd_limit_once = PTHREAD_ONCE_INIT;
+
+// 获取使用的文件句柄数量（不包括本函数保持打开的目录和 rlsys 采集时保持打开的文件）
 int rl_get_fd_count()
 {
-    char path[64] = {0};
-    // 获取当前进程的文件描述符目录路径
-    snprintf(path, sizeof(path), "/proc/%d/fd", getpid()); 
+    pthread_mutex_lock(&g_sys_fd_mutex);
+    struct stat st;
+    bool valid = (g_sys_fd_dir_pid == getpid() && fstat(g_sys_fd_dir, &st) == 0 && S_ISDIR(st.st_mode) &&
+                  st.st_dev == g_sys_fd_dir_dev && st.st_ino == g_sys_fd_dir_ino);
+    if (valid == RL_FALSE)
+    {
+        // fork 后（或句柄已被应用关闭）重新打开；句柄号可能已被其他文件复用，不能关闭
+        if (g_sys_fd_dir >= 0 && fstat(g_sys_fd_dir, &st) == 0 && st.st_dev == g_sys_fd_dir_dev && st.st_ino == g_sys_fd_dir_ino)
+        {
+            close(g_sys_fd_dir);
+        }
+        g_sys_fd_dir = open(SYS_PROC_GET_FD_DIR, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+        if (g_sys_fd_dir < 0 || fstat(g_sys_fd_dir, &st) != 0)
+        {
+            if (g_sys_fd_dir >= 0)
+            {
+                close(g_sys_fd_dir);
+                g_sys_fd_dir = -1;
+            }
+            g_sys_fd_dir_pid = 0;
+            pthread_mutex_unlock(&g_sys_fd_mutex);
+            rl_log_error("[%s:%s:%d] open file:%s failed", __FILENAME__, __FUNCTION__, __LINE__, SYS_PROC_GET_FD_DIR);
+            return RL_FAILED;
+        }
+        g_sys_fd_dir_pid = getpid();
+        g_sys_fd_dir_dev = st.st_dev;
+        g_sys_fd_dir_ino = st.st_ino;
+    }
 
-    DIR *dir = opendir(path);
-    if (dir == NULL)
+    // Linux 6.2 起目录大小就是打开的文件数量，不需要遍历
+    if (st.st_size > 0)
     {
-        rl_log_error("[%s:%s:%d] open file:%s failed", __FILENAME__, __FUNCTION__, __LINE__, path);
-        return RL_FAILED;
+        pthread_mutex_unlock(&g_sys_fd_mutex);
+        return (int)st.st_size - 1 - __atomic_load_n(&g_sys_held_fd_count, __ATOMIC_RELAXED);
     }
 
+    // 较早的内核：从头用 getdents64 读取到栈上的缓冲区计数（不使用 readdir，避免分配内存）
     int count = 0;
-    struct dirent *entry;
-    while ((entry = readdir(dir)) != NULL)
+    char buf[4096] __attribute__((aligned(8)));
+    lseek(g_sys_fd_dir, 0, SEEK_SET);
+    while (1)
     {
-        // 只计算文件项，不包括 "." 和 ".."
-        if (entry->d_name[0] != '.')
+        long len = syscall(SYS_getdents64, g_sys_fd_dir, buf, sizeof(buf));
+        if (len < 0)
+        {
+            pthread_mutex_unlock(&g_sys_fd_mutex);
+            rl_log_error("[%s:%s:%d] getdents64 file:%s failed", __FILENAME__, __FUNCTION__, __LINE__, SYS_PROC_GET_FD_DIR);
+            return RL_FAILED;
+        }
+        if (len == 0)
         {
-            count++;
+            break;
+        }
+        for (long off = 0; off < len;)
+        {
+            const SYS_DIRENT64_T *entry = (const SYS_DIRENT64_T *)(buf + off);
+            // 只计算文件项，不包括 "." 和 ".."
+            if (entry->d_name[0] != '.')
+            {
+                count++;
+            }
+            off += entry->d_reclen;
         }
     }
+    pthread_mutex_unlock(&g_sys_fd_mutex);
+    return count - 1 - __atomic_load_n(&g_sys_held_fd_count, __ATOMIC_RELAXED);
+}
 
-    // 关闭目录
-    if (closedir(dir) != 0)
+static void rl_sys_fd_limit_once()
+{
+    struct rlimit limit;
+    if (getrlimit(RLIMIT_NOFILE, &limit) != 0)
     {
-        rl_log_error("[%s:%s:%d] close file:%s failed", __FILENAME__, __FUNCTION__, __LINE__, path);
-        return RL_FAILED;
+        rl_log_error("[%s:%s:%d] getrlimit failed", __FILENAME__, __FUNCTION__, __LINE__);
+        g_sys_fd_limit = RL_FAILED;
+        return;
     }
+    g_sys_fd_limit = (limit.rlim_cur == RLIM_INFINITY || limit.rlim_cur > INT_MAX) ? INT_MAX : (int)limit.rlim_cur;
+}
 
-    return count;
+// 获取文件句柄数量上限
+int rl_get_fd_limit()
+{
+    pthread_once(&g_sys_fd_limit_once, rl_sys_fd_limit_once);
+    return g_sys_fd_limit;
 }
 
 // 获取使用的内存情况（单位是 KB）
@@ -248,6 +525,191 @@ int rl_get_memory_usage()
     return memory_usage;
 }
 
+// rl_sys_snapshot 保持打开的文件（/proc/self 在打开时确定进程，fork 后子进程需要重新打开）
+typedef struct
+{
+    pid_t pid;
+    int statm_fd;
+    int stat_fd;
+    int temp_fd;
+    long page_kb;
+    long clk_tck;
+} SYS_SNAPSHOT_FILES_T;
+
+static SYS_SNAPSHOT_FILES_T g_sys_snapshot_files = {0, -1, -1, -1, 0, 0};
+static pthread_mutex_t g_sys_snapshot_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+// 打开（或在 fork 后重新打开）采集使用的文件，需持有 g_sys_snapshot_mutex
+static int rl_sys_snapshot_open_locked()
+{
+    SYS_SNAPSHOT_FILES_T *files = &g_sys_snapshot_files;
+    pid_t pid = getpid();
+    if (files->pid == pid)
+    {
+        return RL_SUCCESS;
+    }
+    int *fds[] = {&files->statm_fd, &files->stat_fd, &files->temp_fd};
+    for (unsigned int i = 0; i < sizeof(fds) / sizeof(fds[0]); i++)
+    {
+        if (*fds[i] >= 0)
+        {
+            close(*fds[i]);
+            *fds[i] = -1;
+            __atomic_sub_fetch(&g_sys_held_fd_count, 1, __ATOMIC_RELAXED);
+        }
+    }
+    files->statm_fd = open(SYS_PROC_GET_STATM_FILE, O_RDONLY | O_CLOEXEC);
+    files->stat_fd = open(SYS_PROC_GET_STAT_FILE, O_RDONLY | O_CLOEXEC);
+    __atomic_add_fetch(&g_sys_held_fd_count, (files->statm_fd >= 0) + (files->stat_fd >= 0), __ATOMIC_RELAXED);
+    if (files->statm_fd < 0 || files->stat_fd < 0)
+    {
+        rl_log_error("[%s:%s:%d] open file:%s or %s failed", __FILENAME__, __FUNCTION__, __LINE__, SYS_PROC_GET_STATM_FILE, SYS_PROC_GET_STAT_FILE);
+        return RL_FAILED;
+    }
+    // 没有温度传感器的设备只在打开时记录一次
+    files->temp_fd = open(SYS_CPU_GET_TEMPERATURE_FILE, O_RDONLY | O_CLOEXEC);
+    if (files->temp_fd < 0)
+    {
+        rl_log_error("[%s:%s:%d] open file:%s failed, temperature unavailable", __FILENAME__, __FUNCTION__, __LINE__, SYS_CPU_GET_TEMPERATURE_FILE);
+    }
+    else
+    {
+        __atomic_add_fetch(&g_sys_held_fd_count, 1, __ATOMIC_RELAXED);
+    }
+    files->page_kb = sysconf(_SC_PAGESIZE) / 1024;
+    files->clk_tck = sysconf(_SC_CLK_TCK);
+    files->pid = pid;
+    return RL_SUCCESS;
+}
+
+// 从头读取已打开的文件，内容以 '\0' 结尾，返回读取的长度
+static ssize_t rl_sys_pread_file(int fd, char *buf, size_t size)
+{
+    ssize_t len = pread(fd, buf, size - 1, 0);
+    if (len < 0)
+    {
+        return RL_FAILED;
+    }
+    buf[len] = '\0';
+    return len;
+}
+
+// 跳过 count 个以空格分隔的字段，不足时返回 NULL
+static const char *rl_sys_skip_fields(const char *p, const char *end, int count)
+{
+    for (int i = 0; i < count; i++)
+    {
+        while (p < end && *p == ' ')
+        {
+            p++;
+        }
+        while (p < end && *p != ' ')
+        {
+            p++;
+        }
+        if (p == end)
+        {
+            return NULL;
+        }
+    }
+    return p;
+}
+
+// 一次采集进程自身运行状况
+int rl_sys_snapshot(rl_sys_snapshot_t *snap)
+{
+    if (snap == NULL)
+    {
+        rl_log_error("[%s:%s:%d] snap is null", __FILENAME__, __FUNCTION__, __LINE__);
+        return RL_FAILED;
+    }
+    memset(snap, 0, sizeof(rl_sys_snapshot_t));
+    SYS_SNAPSHOT_FILES_T *files = &g_sys_snapshot_files;
+    char buf[512];
+    unsigned long long value = 0;
+    const char *p = NULL;
+    const char *end = NULL;
+
+    pthread_mutex_lock(&g_sys_snapshot_mutex);
+    if (rl_sys_snapshot_open_locked() != RL_SUCCESS)
+    {
+        pthread_mutex_unlock(&g_sys_snapshot_mutex);
+        return RL_FAILED;
+    }
+
+    // statm：size resident shared ...（单位页）
+    ssize_t len = rl_sys_pread_file(files->statm_fd, buf, sizeof(buf));
+    p = (len > 0) ? rl_sys_skip_fields(buf, buf + len, 1) : NULL;
+    if (p == NULL || rl_sys_parse_ull(p, buf + len, &value) == NULL)
+    {
+        pthread_mutex_unlock(&g_sys_snapshot_mutex);
+        rl_log_error("[%s:%s:%d] read file:%s failed", __FILENAME__, __FUNCTION__, __LINE__, SYS_PROC_GET_STATM_FILE);
+        return RL_FAILED;
+    }
+    snap->rss_kb = value * files->page_kb;
+
+    // stat：进程名可能包含空格和括号，从最后一个 ')' 之后按字段解析（部分字段可能为负数，只解析需要的字段）
+    // state ppid pgrp session tty_nr tpgid flags minflt cminflt majflt cmajflt utime stime cutime cstime priority nice num_threads
+    len = rl_sys_pread_file(files->stat_fd, buf, sizeof(buf));
+    p = (len > 0) ? strrchr(buf, ')') : NULL;
+    end = buf + len;
+    // 每项为 {解析前跳过的字段数, 保存位置}
+    unsigned long long threads = 0;
+    unsigned long long utime = 0;
+    unsigned long long stime = 0;
+    struct
+    {
+        int skip;
+        unsigned long long *value;
+    } stat_fields[] = {
+        {7, &snap->minor_faults},
+        {1, &snap->major_faults},
+        {1, &utime},
+        {0, &stime},
+        {4, &threads},
+    };
+    p = (p != NULL) ? p + 1 : NULL;
+    for (unsigned int i = 0; i < sizeof(stat_fields) / sizeof(stat_fields[0]) && p != NULL; i++)
+    {
+        p = rl_sys_skip_fields(p, end, stat_fields[i].skip);
+        p = (p != NULL) ? rl_sys_parse_ull(p, end, stat_fields[i].value) : NULL;
+    }
+    if (p == NULL)
+    {
+        pthread_mutex_unlock(&g_sys_snapshot_mutex);
+        rl_log_error("[%s:%s:%d] read file:%s failed", __FILENAME__, __FUNCTION__, __LINE__, SYS_PROC_GET_STAT_FILE);
+        return RL_FAILED;
+    }
+    snap->utime_ms = utime * 1000 / files->clk_tck;
+    snap->stime_ms = stime * 1000 / files->clk_tck;
+    snap->threads = (int)threads;
+
+    // 温度
+    snap->temperature = RL_FAILED;
+    if (files->temp_fd >= 0)
+    {
+        len = rl_sys_pread_file(files->temp_fd, buf, sizeof(buf));
+        if (len > 0 && rl_sys_parse_ull(buf, buf + len, &value) != NULL)
+        {
+            snap->temperature = (int)value;
+        }
+    }
+    pthread_mutex_unlock(&g_sys_snapshot_mutex);
+
+    // 常驻内存峰值和上下文切换次数（/proc/self/status 解析较慢，使用 getrusage 获取相同的内核计数）
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) == 0)
+    {
+        snap->hwm_kb = (unsigned long long)usage.ru_maxrss;
+        snap->voluntary_ctxt_switches = (unsigned long long)usage.ru_nvcsw;
+        snap->nonvoluntary_ctxt_switches = (unsigned long long)usage.ru_nivcsw;
+    }
+
+    snap->fd_count = rl_get_fd_count();
+    snap->fd_limit = rl_get_fd_limit();
+    return RL_SUCCESS;
+}
+
 // 获取当前进程的名称
 int rl_get_proc_name(char *name, unsigned int len)
 {
@@ -294,4 +756,244 @@ double rl_calcuate_run_time_ms(const struct timespec *start)
     }
 
     return sec_diff * 1000.0 + nsec_diff / 1e6;
-}
\ No newline at end of file
+}
+
+// 系统监视线程的采样项
+enum
+{
+    SYS_MONITOR_ITEM_CPU = 0,
+    SYS_MONITOR_ITEM_TEMPERATURE,
+    SYS_MONITOR_ITEM_PROC,
+    SYS_MONITOR_ITEM_LOADAVG,
+    SYS_MONITOR_ITEM_COUNT
+};
+
+// 监视线程发布的结果（顺序锁：写入前后序号各加一，读取方看到奇数或读取前后序号不同时重试）
+typedef struct
+{
+    unsigned int seq;
+    rl_sys_monitor_t data;
+} __attribute__((aligned(64))) SYS_MONITOR_PUBLISH_T;
+
+static SYS_MONITOR_PUBLISH_T g_sys_monitor_publish;
+static bool g_sys_monitor_state = RL_FALSE;
+static unsigned int g_sys_monitor_interval[SYS_MONITOR_ITEM_COUNT];
+static pthread_t g_sys_monitor_thread;
+static pthread_mutex_t g_sys_monitor_wait_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t g_sys_monitor_wait_cond = PTHREAD_COND_INITIALIZER;
+
+static unsigned long long rl_sys_monotonic_ms()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (unsigned long long)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+// 发布采样结果（只有监视线程写入，不需要加锁）
+static void rl_sys_monitor_publish(const rl_sys_monitor_t *data)
+{
+    unsigned int seq = g_sys_monitor_publish.seq;
+    __atomic_store_n(&g_sys_monitor_publish.seq, seq + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    memcpy(&g_sys_monitor_publish.data, data, sizeof(rl_sys_monitor_t));
+    __atomic_store_n(&g_sys_monitor_publish.seq, seq + 2, __ATOMIC_RELEASE);
+}
+
+// 解析 /proc/loadavg 中的一个负载值（内核固定输出两位小数），结果乘以 100
+static const char *rl_sys_parse_load(const char *p, const char *end, int *value)
+{
+    unsigned long long whole = 0;
+    unsigned long long frac = 0;
+    p = rl_sys_parse_ull(p, end, &whole);
+    if (p == NULL || p == end || *p != '.')
+    {
+        return NULL;
+    }
+    p = rl_sys_parse_ull(p + 1, end, &frac);
+    *value = (int)(whole * 100 + frac);
+    return p;
+}
+
+// 系统监视线程：开启时立即采样，之后各项按各自的间隔采样，每次有更新时发布一次
+static void *rl_sys_monitor_worker(void *arg)
+{
+    (void)arg;
+    rl_cpu_sampler_t *sampler = rl_cpu_sampler_create();
+    int loadavg_fd = open(SYS_GET_LOADAVG_FILE, O_RDONLY | O_CLOEXEC);
+    if (loadavg_fd < 0)
+    {
+        rl_log_error("[%s:%s:%d] open file:%s failed", __FILENAME__, __FUNCTION__, __LINE__, SYS_GET_LOADAVG_FILE);
+    }
+    // 采样器和 /proc/loadavg 不计入 rl_get_fd_count
+    int held = (sampler != NULL) + (loadavg_fd >= 0);
+    __atomic_add_fetch(&g_sys_held_fd_count, held, __ATOMIC_RELAXED);
+    // 获取失败的项不再采样（例如没有温度传感器的设备），避免每个间隔都记录错误
+    bool enabled[SYS_MONITOR_ITEM_COUNT] = {sampler != NULL, RL_TRUE, RL_TRUE, loadavg_fd >= 0};
+    unsigned long long next_ms[SYS_MONITOR_ITEM_COUNT] = {0};
+    rl_sys_monitor_t latest;
+    memset(&latest, 0, sizeof(latest));
+    latest.cpu.id = -1;
+    latest.temperature = RL_FAILED;
+    latest.fd_count = RL_FAILED;
+
+    pthread_mutex_lock(&g_sys_monitor_wait_mutex);
+    while (g_sys_monitor_state == RL_TRUE)
+    {
+        pthread_mutex_unlock(&g_sys_monitor_wait_mutex);
+        unsigned long long now_ms = rl_sys_monotonic_ms();
+        bool updated = RL_FALSE;
+        for (int i = 0; i < SYS_MONITOR_ITEM_COUNT; i++)
+        {
+            if (enabled[i] == RL_FALSE || now_ms < next_ms[i])
+            {
+                continue;
+            }
+            next_ms[i] = now_ms + g_sys_monitor_interval[i];
+            updated = RL_TRUE;
+            if (i == SYS_MONITOR_ITEM_CPU)
+            {
+                enabled[i] = (rl_cpu_sampler_sample(sampler, &latest.cpu, NULL, 0) != RL_FAILED);
+            }
+            else if (i == SYS_MONITOR_ITEM_TEMPERATURE)
+            {
+                latest.temperature = rl_get_cpu_temperature();
+                enabled[i] = (latest.temperature != RL_FAILED);
+            }
+            else if (i == SYS_MONITOR_ITEM_PROC)
+            {
+                rl_sys_snapshot_t snap;
+                enabled[i] = (rl_sys_snapshot(&snap) == RL_SUCCESS);
+                latest.rss_kb = snap.rss_kb;
+                latest.threads = snap.threads;
+                latest.fd_count = snap.fd_count;
+            }
+            else if (i == SYS_MONITOR_ITEM_LOADAVG)
+            {
+                // 格式：1 分钟 5 分钟 15 分钟 运行/总任务数 最近的进程号
+                char buf[128];
+                ssize_t len = rl_sys_pread_file(loadavg_fd, buf, sizeof(buf));
+                const char *p = (len > 0) ? rl_sys_parse_load(buf, buf + len, &latest.load_1) : NULL;
+                p = (p != NULL) ? rl_sys_parse_load(p, buf + len, &latest.load_5) : NULL;
+                p = (p != NULL) ? rl_sys_parse_load(p, buf + len, &latest.load_15) : NULL;
+                if (p == NULL)
+                {
+                    rl_log_error("[%s:%s:%d] read file:%s failed", __FILENAME__, __FUNCTION__, __LINE__, SYS_GET_LOADAVG_FILE);
+                    enabled[i] = RL_FALSE;
+                }
+            }
+        }
+        if (updated == RL_TRUE)
+        {
+            latest.update_ms = now_ms;
+            rl_sys_monitor_publish(&latest);
+        }
+
+        // 等待到最早需要采样的一项
+        unsigned long long wait_ms = 1000;
+        for (int i = 0; i < SYS_MONITOR_ITEM_COUNT; i++)
+        {
+            if (enabled[i] == RL_TRUE && next_ms[i] - now_ms < wait_ms)
+            {
+                wait_ms = next_ms[i] - now_ms;
+            }
+        }
+        pthread_mutex_lock(&g_sys_monitor_wait_mutex);
+        struct timespec ts;
+        clock_gettime(CLOCK_REALTIME, &ts);
+        ts.tv_sec += wait_ms / 1000;
+        ts.tv_nsec += (wait_ms % 1000) * 1000 * 1000;
+        if (ts.tv_nsec >= 1000000000)
+        {
+            ts.tv_sec += 1;
+            ts.tv_nsec -= 1000000000;
+        }
+        while (g_sys_monitor_state == RL_TRUE && pthread_cond_timedwait(&g_sys_monitor_wait_cond, &g_sys_monitor_wait_mutex, &ts) != ETIMEDOUT)
+        {
+        }
+    }
+    pthread_mutex_unlock(&g_sys_monitor_wait_mutex);
+
+    if (sampler != NULL)
+    {
+        rl_cpu_sampler_destroy(sampler);
+    }
+    if (loadavg_fd >= 0)
+    {
+        close(loadavg_fd);
+    }
+    __atomic_sub_fetch(&g_sys_held_fd_count, held, __ATOMIC_RELAXED);
+    return NULL;
+}
+
+// 开启系统监视线程
+int rl_sys_monitor_start(const rl_sys_monitor_config_t *config)
+{
+    pthread_mutex_lock(&g_sys_monitor_wait_mutex);
+    if (g_sys_monitor_state == RL_TRUE)
+    {
+        pthread_mutex_unlock(&g_sys_monitor_wait_mutex);
+        rl_log_error("[%s:%s:%d] sys monitor already started", __FILENAME__, __FUNCTION__, __LINE__);
+        return RL_FAILED;
+    }
+    rl_sys_monitor_config_t cfg = {0, 0, 0, 0};
+    if (config != NULL)
+    {
+        cfg = *config;
+    }
+    g_sys_monitor_interval[SYS_MONITOR_ITEM_CPU] = (cfg.cpu_ms == 0) ? SYS_MONITOR_CPU_INTERVAL : cfg.cpu_ms;
+    g_sys_monitor_interval[SYS_MONITOR_ITEM_TEMPERATURE] = (cfg.temperature_ms == 0) ? SYS_MONITOR_TEMPERATURE_INTERVAL : cfg.temperature_ms;
+    g_sys_monitor_interval[SYS_MONITOR_ITEM_PROC] = (cfg.proc_ms == 0) ? SYS_MONITOR_PROC_INTERVAL : cfg.proc_ms;
+    g_sys_monitor_interval[SYS_MONITOR_ITEM_LOADAVG] = (cfg.loadavg_ms == 0) ? SYS_MONITOR_LOADAVG_INTERVAL : cfg.loadavg_ms;
+    __atomic_store_n(&g_sys_monitor_state, RL_TRUE, __ATOMIC_RELEASE);
+    pthread_mutex_unlock(&g_sys_monitor_wait_mutex);
+
+    if (pthread_create(&g_sys_monitor_thread, NULL, rl_sys_monitor_worker, NULL) != 0)
+    {
+        rl_log_error("[%s:%s:%d] create sys monitor thread failed", __FILENAME__, __FUNCTION__, __LINE__);
+        __atomic_store_n(&g_sys_monitor_state, RL_FALSE, __ATOMIC_RELEASE);
+        return RL_FAILED;
+    }
+    return RL_SUCCESS;
+}
+
+// 停止系统监视线程（最后一次的结果仍可读取）
+int rl_sys_monitor_stop()
+{
+    pthread_mutex_lock(&g_sys_monitor_wait_mutex);
+    bool state = g_sys_monitor_state;
+    __atomic_store_n(&g_sys_monitor_state, RL_FALSE, __ATOMIC_RELEASE);
+    pthread_cond_signal(&g_sys_monitor_wait_cond);
+    pthread_mutex_unlock(&g_sys_monitor_wait_mutex);
+    if (state == RL_FALSE)
+    {
+        return RL_FAILED;
+    }
+    pthread_join(g_sys_monitor_thread, NULL);
+    return RL_SUCCESS;
+}
+
+// 读取系统监视线程最近一次的采样结果
+int rl_sys_monitor_get(rl_sys_monitor_t *data)
+{
+    if (data == NULL)
+    {
+        rl_log_error("[%s:%s:%d] data is null", __FILENAME__, __FUNCTION__, __LINE__);
+        return RL_FAILED;
+    }
+    while (1)
+    {
+        unsigned int begin = __atomic_load_n(&g_sys_monitor_publish.seq, __ATOMIC_ACQUIRE);
+        if ((begin & 1) != 0)
+        {
+            // 正在写入，写入只是一次内存复制，很快结束
+            continue;
+        }
+        memcpy(data, &g_sys_monitor_publish.data, sizeof(rl_sys_monitor_t));
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        if (__atomic_load_n(&g_sys_monitor_publish.seq, __ATOMIC_RELAXED) == begin)
+        {
+            break;
+        }
+    }
+    return (data->update_ms == 0) ? RL_FAILED : RL_SUCCESS;
+}
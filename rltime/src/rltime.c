@@ -226,7 +226,7 @@ int rl_get_time_from_server(unsigned int try_sec, rl_time_t *time)
         return RL_FALSE;
     }
     // 输出 HTTP 响应头
-    rl_log_debug("[%s:%s:%d] HTTP Response:\n%s", __FILENAME__, __FUNCTION__, __LINE__, response);
+    RL_LOGD("[%s:%s:%d] HTTP Response:\n%s", __FILENAME__, __FUNCTION__, __LINE__, response);
 
     // 解析 Date 字段（从响应头中提取时间）
     char *date_header = strstr(response, "Date: ");
@@ -237,7 +237,7 @@ int rl_get_time_from_server(unsigned int try_sec, rl_time_t *time)
         {
             *end = '\0';
             const char *date_str = date_header + 6;
-            rl_log_debug("[%s:%s:%d] rece date: %s", __FILENAME__, __FUNCTION__, __LINE__, date_str);
+            RL_LOGD("[%s:%s:%d] rece date: %s", __FILENAME__, __FUNCTION__, __LINE__, date_str);
             // 转换时间格式
             rl_memset(time, 0, sizeof(rl_time_t));
             if (strptime(date_str, "%a, %d %b %Y %H:%M:%S GMT", time) == NULL)
@@ -249,14 +249,14 @@ int rl_get_time_from_server(unsigned int try_sec, rl_time_t *time)
         }
         else
         {
-            rl_log_debug("[%s:%s:%d] date header malformed", __FILENAME__, __FUNCTION__, __LINE__);
+            RL_LOGD("[%s:%s:%d] date header malformed", __FILENAME__, __FUNCTION__, __LINE__);
             close(sockfd);
             return RL_FAILED;
         }
     }
     else
     {
-        rl_log_debug("[%s:%s:%d] date header not found", __FILENAME__, __FUNCTION__, __LINE__);
+        RL_LOGD("[%s:%s:%d] date header not found", __FILENAME__, __FUNCTION__, __LINE__);
         close(sockfd);
         return RL_FAILED;
     }